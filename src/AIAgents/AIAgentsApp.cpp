@@ -21,14 +21,15 @@ void AIAgentsApp::setup() {
 		renderer->AddTileLayer(spritesImage, "spriteLayer", 1000, 1);
 
 		scene = new Scene();
+		// objects of the game are allocated in the arena of the scene
+		SceneAllocatorScope allocatorScope(scene->GetAllocator());
 		this->Reset();
 	}
 }
 
 void AIAgentsApp::Reset() {
-	if (scene->GetRootObject() != nullptr) {
-		delete scene->GetRootObject();
-	}
+	// destroy the previous game and release its memory
+	scene->Clear();
 
 	// set scale factor so that the whole scene will have the height of 100 units
 	float desiredSceneHeight = 100.0f;
@@ -57,6 +58,10 @@ void AIAgentsApp::Reset() {
 }
 
 void AIAgentsApp::PushNodeIntoRenderer(GameObject* node) {
+	if (renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+		return;
+	}
+
 	renderer->PushNode(node->GetRenderable());
 
 	for (auto child : node->GetChildren()) {
@@ -66,6 +71,8 @@ void AIAgentsApp::PushNodeIntoRenderer(GameObject* node) {
 
 //--------------------------------------------------------------
 void AIAgentsApp::update() {
+	SceneAllocatorScope allocatorScope(scene->GetAllocator());
+
 	if(!initialized) {
 
 		// check pressed keys for networking mode
@@ -94,6 +101,8 @@ void AIAgentsApp::update() {
 		uint64 fixDelta = (delta < expectedDelta) ? expectedDelta : (delta < (2 * expectedDelta)) ? delta : (2 * expectedDelta);
 
 		scene->GetRootObject()->Update(fixDelta, absolute);
+		scene->UpdateComponentPools(fixDelta, absolute);
+		scene->DispatchMessages();
 		scene->GetRootObject()->UpdateTransformations();
 
 		if (resetGamePending) {
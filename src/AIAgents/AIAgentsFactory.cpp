@@ -55,9 +55,10 @@ void AIAgentsFactory::InitializeGame(GameObject* rootObject, AIModel* model) {
 	
 	TransformBuilder trBld;
 
-	// create mesh for map
-	auto mapMesh = new MultiSpriteMesh("spriteLayer");
-	auto map = new GameObject("map", context, scene, mapMesh); // no components -> just a crate for map sprites
+	// create mesh for map, its blocks are baked into chunks that are drawn at once
+	auto mapMesh = new TileMapMesh("spriteLayer", model->spriteSheet, AIMAP_WIDTH, AIMAP_HEIGHT,
+		model->spriteSheet->GetSpriteWidth(), model->spriteSheet->GetSpriteHeight());
+	auto map = new GameObject("map", context, scene, mapMesh); // no components -> just a crate for map tiles
 
 	// for debugging only -> crate for dot sprites that can be used to render current path
 	auto pathMesh = new MultiSpriteMesh("spriteLayer");
@@ -107,17 +108,10 @@ void AIAgentsFactory::InitializeGame(GameObject* rootObject, AIModel* model) {
 				model->warehouseModel.position = Vec2i(i, j);
 			}
 
-			Trans transform;
-			Sprite* mapSprite = new Sprite(model->spriteSheet, index, transform);
-			mapSprite->GetTransform().localPos.x = i * mapSprite->GetWidth();
-			mapSprite->GetTransform().localPos.y = j * mapSprite->GetHeight();
-			mapMesh->AddSprite(mapSprite);
+			mapMesh->SetTile(i, j, index);
 		}
 	}
 
-	// recalculate boundaries of the multi sprite mesh so that we can use TransformBuilder to set proper position
-	mapMesh->Recalc();
-
 	// height of the map is equal to the height of the screen
 	float aspectRatio = context->GetVirtualWidth() * 1.0f / context->GetVirtualHeight();
 	trBld.RelativePosition(0, 0).RelativeScale(1.0f / aspectRatio, 1).BuildAndReset(map);
@@ -33,8 +33,6 @@ void ArkanoidApp::Init() {
 	float desiredSceneHeight = 25.0f;
 	float autoScale = ofGetWindowSize().y / desiredSceneHeight;
 	this->meshDefaultScale = 1.0f / autoScale * (ofGetWindowSize().y / 400.0f);
-	rootBorder = new FRect(ofGetWindowSize().x / autoScale, ofGetWindowSize().y / autoScale, ofColor(0));
-	rootBorder->SetIsRenderable(false);
 
 	auto scripts = ScriptManager::GetInstance();
 	scripts->Init();
@@ -43,11 +41,14 @@ void ArkanoidApp::Init() {
 }
 
 void ArkanoidApp::Reset() {
-	if(scene->GetRootObject() != nullptr) {
-		delete scene->GetRootObject();
-	}
+	// destroy the previous game and release its memory
+	scene->Clear();
 	
 	model->InitLevel();
+	// the root owns its mesh, hence a new one is created for each game
+	float autoScale = ofGetWindowSize().y / 25.0f;
+	auto rootBorder = new FRect(ofGetWindowSize().x / autoScale, ofGetWindowSize().y / autoScale, ofColor(0));
+	rootBorder->SetIsRenderable(false);
 	auto rootObject = new GameObject("root", this, scene, rootBorder);
 	scene->SetRootObject(rootObject);;
 	ArkanoidFactory::InitializeLevel(rootObject, model, gameConfig);
@@ -10,8 +10,6 @@
 class ArkanoidApp : public AphApp {
 public:
 	ArkanoidModel* model;
-	// border of the root element
-	FRect* rootBorder;
 	
 	jsonxx::Object gameConfig;
 
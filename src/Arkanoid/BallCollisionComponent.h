@@ -8,6 +8,7 @@
 #include "GameObject.h"
 #include "SteeringComponent.h"
 #include "Scene.h"
+#include "CollisionWorld.h"
 
 /**
  * Component that handles collisions with the ball
@@ -22,6 +23,12 @@ public:
 	GameObject* bricks;
 	ArkanoidModel* model;
 	Dynamics* dynamics;
+	// bricks as static colliders, indexed in the same way as the sprites of the bricks
+	CollisionWorld* world = nullptr;
+
+	~BallCollisionComponent() {
+		delete world;
+	}
 
 	virtual void Init() {
 		leftPanel = owner->GetScene()->FindGameObjectByName("left_panel");
@@ -31,6 +38,7 @@ public:
 		bricks = owner->GetScene()->FindGameObjectByName("bricks");
 		model = owner->GetRoot()->GetAttr<ArkanoidModel*>(ARKANOID_MODEL);
 		dynamics = owner->GetAttr<Dynamics*>(ATTR_DYNAMICS);
+		world = new CollisionWorld(owner->GetScene());
 	}
 
 	virtual void Update(uint64_t delta, uint64_t absolute) {
@@ -115,17 +123,17 @@ public:
 	/**
 	 * Checks collision with all bricks
 	 */
-	bool CheckBrickCollision(HitInfo& hitInfo) const {
+	bool CheckBrickCollision(HitInfo& hitInfo) {
 
 		auto& ballBB = owner->GetRenderable()->GetBoundingBox();
 		auto multiMesh = bricks->GetMesh<MultiSpriteMesh>();
 		auto& sprites = multiMesh->GetSprites();
 		auto& velocity = dynamics->GetVelocity();
 
-		for (int i = 0; i < sprites.size(); i++) {
-			BoundingBox bb;
-			Sprite* spr = sprites[i];
-			spr->CalcBoundingBox(bb);
+		RefreshBricks(sprites);
+
+		for (int i : world->QueryStatic(ballBB)) {
+			BoundingBox bb = world->GetStaticBox(i);
 			
 			if (bb.Intersects(ballBB)) {
 				if (bb.HorizontalIntersection(ballBB) > bb.VerticalIntersection(ballBB)) {
@@ -150,4 +158,30 @@ public:
 		}
 		return false;
 	}
+
+	/**
+	 * Puts bricks into the collision world, if they have changed since the last check
+	 * Bricks don't move on their own; they are only removed or moved all at once when the scene is resized
+	 */
+	void RefreshBricks(vector<Sprite*>& sprites) {
+		if (world->GetStaticCount() == (int)sprites.size()) {
+			if (sprites.empty()) {
+				return;
+			}
+
+			BoundingBox first;
+			sprites[0]->CalcBoundingBox(first);
+			auto& stored = world->GetStaticBox(0);
+			if (first.topLeft == stored.topLeft && first.bottomRight == stored.bottomRight) {
+				return;
+			}
+		}
+
+		world->ClearStatic();
+		for (auto spr : sprites) {
+			BoundingBox bb;
+			spr->CalcBoundingBox(bb);
+			world->AddStatic(bb);
+		}
+	}
 };
\ No newline at end of file
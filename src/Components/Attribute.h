@@ -1,5 +1,14 @@
 #pragma once
 
+#include <vector>
+#include <type_traits>
+#include <new>
+#include "SceneAllocator.h"
+
+using namespace std;
+
+// maximum size of values that are stored directly in the attribute table
+#define ATTR_INLINE_SIZE 16
 
 class GameObject;
 
@@ -7,7 +16,7 @@ class GameObject;
 * Base attribute
 *
 */
-class BaseAttribute {
+class BaseAttribute : public SceneAllocated {
 protected:
 	// owner node
 	GameObject* owner;
@@ -109,4 +118,237 @@ public:
 	void Set(T& val) {
 		this->value = val;
 	}
+};
+
+/**
+ * Indicator whether values of given type are stored directly in the attribute table
+ * Small trivially copyable values (numbers, vectors, pointers) are stored inline,
+ * other values are wrapped into Attribute<T>
+ */
+template<typename T> struct AttrIsInline {
+	static const bool value = sizeof(T) <= ATTR_INLINE_SIZE && alignof(T) <= alignof(void*) && std::is_trivially_copyable<T>::value;
+};
+
+/**
+ * Slot of the attribute table
+ */
+struct AttrSlot {
+	// key identifier
+	unsigned key;
+	bool isUsed;
+	bool isPointer;
+	bool isInline;
+	// deletes the pointer value when the attribute is destroyed, nullptr if it's not owned
+	void(*deleter)(AttrSlot& slot);
+	// inline value or pointer to a wrapping attribute
+	alignas(void*) unsigned char storage[ATTR_INLINE_SIZE];
+
+	BaseAttribute* GetWrapper() {
+		return *reinterpret_cast<BaseAttribute**>(storage);
+	}
+
+	/**
+	* Gets address of the value
+	*/
+	void* RawVal() {
+		return isInline ? (void*)storage : GetWrapper()->RawVal();
+	}
+};
+
+/**
+ * Flat table of attributes of one game object
+ * Attributes are kept in a small vector and searched linearly, as objects usually have only a few of them
+ * An attribute keeps its slot until it is removed, even if its value is replaced
+ */
+class AttributeTable {
+private:
+	vector<AttrSlot> slots;
+
+public:
+	AttributeTable() {
+
+	}
+
+	AttributeTable(const AttributeTable& copy) = delete;
+	AttributeTable& operator=(const AttributeTable& copy) = delete;
+
+	~AttributeTable() {
+		Clear(true);
+	}
+
+	/**
+	* Finds index of the slot of given attribute, returns -1 if there is no such attribute
+	*/
+	int Find(unsigned key) const {
+		for (int i = 0; i < (int)slots.size(); i++) {
+			if (slots[i].key == key && slots[i].isUsed) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	/**
+	* Returns true, if the slot at given index contains given attribute
+	*/
+	bool IsAt(int index, unsigned key) const {
+		return index >= 0 && index < (int)slots.size() && slots[index].key == key && slots[index].isUsed;
+	}
+
+	/**
+	* Adds a new attribute or replaces the value of an existing one; the old value is destroyed
+	*/
+	template<class T> void Add(unsigned key, T value, GameObject* owner, bool isShared = false) {
+		int index = Find(key);
+
+		if (index != -1) {
+			Release(slots[index], true);
+		} else {
+			// reuse a slot of a removed attribute
+			index = Find(key, false);
+			if (index == -1) {
+				index = slots.size();
+				slots.push_back(AttrSlot());
+			}
+		}
+
+		AttrSlot& slot = slots[index];
+		slot.key = key;
+		slot.isUsed = true;
+		slot.isPointer = std::is_pointer<T>::value;
+		slot.isInline = AttrIsInline<T>::value;
+		slot.deleter = nullptr;
+		Store(slot, value, owner, isShared, std::integral_constant<bool, AttrIsInline<T>::value>());
+	}
+
+	/**
+	* Gets value at given index
+	*/
+	template<class T> T& Get(int index) {
+		return Load<T>(slots[index], std::integral_constant<bool, AttrIsInline<T>::value>());
+	}
+
+	/**
+	* Removes an attribute
+	* @param destroy if true, pointer values owned by the attribute are deleted
+	*/
+	bool Remove(unsigned key, bool destroy) {
+		int index = Find(key);
+
+		if (index != -1) {
+			Release(slots[index], destroy);
+			slots[index].isUsed = false;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	* Removes all attributes
+	* @param destroy if true, pointer values owned by the attributes are deleted
+	*/
+	void Clear(bool destroy) {
+		for (auto& slot : slots) {
+			if (slot.isUsed) {
+				Release(slot, destroy);
+			}
+		}
+		slots.clear();
+	}
+
+	/**
+	* Gets address of the value, or the value itself if the attribute is a pointer
+	*/
+	void* GetPtr(unsigned key) {
+		int index = Find(key);
+
+		if (index != -1) {
+			void* rawVal = slots[index].RawVal();
+			return slots[index].isPointer ? *(void**)rawVal : rawVal;
+		}
+		return nullptr;
+	}
+
+private:
+	int Find(unsigned key, bool isUsed) const {
+		for (int i = 0; i < (int)slots.size(); i++) {
+			if (slots[i].isUsed == isUsed && (!isUsed || slots[i].key == key)) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void Release(AttrSlot& slot, bool destroy) {
+		if (!slot.isInline) {
+			delete slot.GetWrapper();
+		} else if (destroy && slot.deleter != nullptr) {
+			slot.deleter(slot);
+		}
+	}
+
+	// inline values don't refer to their owner
+	template<class T> void Store(AttrSlot& slot, T& value, GameObject*, bool isShared, std::true_type) {
+		::new (slot.storage) T(value);
+		if (slot.isPointer && !isShared) {
+			slot.deleter = [](AttrSlot& slot) {
+				AttrDeleter<T>::Destroy(*reinterpret_cast<T*>(slot.storage));
+			};
+		}
+	}
+
+	template<class T> void Store(AttrSlot& slot, T& value, GameObject* owner, bool isShared, std::false_type) {
+		*reinterpret_cast<BaseAttribute**>(slot.storage) = new Attribute<T>(slot.key, value, owner, isShared);
+	}
+
+	template<class T> T& Load(AttrSlot& slot, std::true_type) {
+		return *reinterpret_cast<T*>(slot.storage);
+	}
+
+	template<class T> T& Load(AttrSlot& slot, std::false_type) {
+		return static_cast<Attribute<T>*>(slot.GetWrapper())->Get();
+	}
+};
+
+/**
+ * Cached reference to an attribute; it can be resolved once, e.g. in Component::Init,
+ * and dereferenced without searching the attribute table again
+ * The handle stays valid when the value of the attribute is replaced
+ */
+template<class T>
+class AttrHandle {
+private:
+	AttributeTable* table = nullptr;
+	unsigned key = 0;
+	int index = -1;
+public:
+	AttrHandle() {
+
+	}
+
+	AttrHandle(AttributeTable* table, unsigned key) : table(table), key(key), index(table->Find(key)) {
+
+	}
+
+	/**
+	* Returns true, if the attribute exists
+	*/
+	bool IsValid() {
+		return table != nullptr && (table->IsAt(index, key) || (index = table->Find(key)) != -1);
+	}
+
+	/**
+	* Gets reference to the attribute value
+	*/
+	T& Get() {
+		if (!table->IsAt(index, key)) {
+			// the attribute was removed and added again
+			index = table->Find(key);
+		}
+		return table->Get<T>(index);
+	}
+
+	T& operator*() {
+		return Get();
+	}
 };
\ No newline at end of file
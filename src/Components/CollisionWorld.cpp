@@ -0,0 +1,195 @@
+#include "CollisionWorld.h"
+#include <algorithm>
+#include <cmath>
+#include "Scene.h"
+#include "GameObject.h"
+
+const vector<CollisionPair>& CollisionWorld::FindCollisions(unsigned firstFlag, unsigned secondFlag) {
+	pairs.clear();
+	sweepEntries.clear();
+	activeFirst.clear();
+	activeSecond.clear();
+
+	bool sameSet = firstFlag == secondFlag;
+	AddSweepEntries(scene->GetGameObjectsByFlag(firstFlag), true);
+	if (!sameSet) {
+		AddSweepEntries(scene->GetGameObjectsByFlag(secondFlag), false);
+	}
+
+	sort(sweepEntries.begin(), sweepEntries.end(), [](const SweepEntry& a, const SweepEntry& b) {
+		return a.minX < b.minX;
+	});
+
+	for (int i = 0; i < (int)sweepEntries.size(); i++) {
+		auto& entry = sweepEntries[i];
+		// entries of the other set that are still open on the x axis
+		auto& opposite = (sameSet || !entry.isFirst) ? activeFirst : activeSecond;
+
+		int kept = 0;
+		for (int j = 0; j < (int)opposite.size(); j++) {
+			auto& other = sweepEntries[opposite[j]];
+			if (other.maxX < entry.minX) {
+				// the sweep has already passed this entry
+				continue;
+			}
+			opposite[kept++] = opposite[j];
+
+			if (other.minY <= entry.maxY && other.maxY >= entry.minY && other.object != entry.object) {
+				if (entry.isFirst) {
+					pairs.push_back(CollisionPair{ entry.object, other.object });
+				} else {
+					pairs.push_back(CollisionPair{ other.object, entry.object });
+				}
+			}
+		}
+		opposite.resize(kept);
+
+		(entry.isFirst ? activeFirst : activeSecond).push_back(i);
+	}
+
+	return pairs;
+}
+
+int CollisionWorld::AddStatic(const BoundingBox& bb) {
+	staticBoxes.push_back(bb);
+	staticStamps.push_back(0);
+	staticGridDirty = true;
+	return staticBoxes.size() - 1;
+}
+
+void CollisionWorld::ClearStatic() {
+	staticBoxes.clear();
+	staticStamps.clear();
+	staticGridDirty = true;
+}
+
+const vector<int>& CollisionWorld::QueryStatic(const BoundingBox& bb) {
+	queryResult.clear();
+
+	if (staticGridDirty) {
+		BuildStaticGrid();
+	}
+
+	if (staticBoxes.empty()) {
+		return queryResult;
+	}
+
+	if (++queryStamp == 0) {
+		// the stamp has overflowed, old stamps could be mistaken for the current one
+		fill(staticStamps.begin(), staticStamps.end(), 0);
+		queryStamp = 1;
+	}
+
+	float minX = min(bb.topLeft.x, bb.bottomRight.x);
+	float maxX = max(bb.topLeft.x, bb.bottomRight.x);
+	float minY = min(bb.topLeft.y, bb.bottomRight.y);
+	float maxY = max(bb.topLeft.y, bb.bottomRight.y);
+
+	int maxColumn = GetColumn(maxX);
+	int maxRow = GetRow(maxY);
+
+	for (int row = GetRow(minY); row <= maxRow; row++) {
+		for (int column = GetColumn(minX); column <= maxColumn; column++) {
+			for (int index : staticCells[row * gridColumns + column]) {
+				if (staticStamps[index] == queryStamp) {
+					// already checked, the collider spans more cells
+					continue;
+				}
+				staticStamps[index] = queryStamp;
+
+				auto& other = staticBoxes[index];
+				if (min(other.topLeft.x, other.bottomRight.x) <= maxX && max(other.topLeft.x, other.bottomRight.x) >= minX
+					&& min(other.topLeft.y, other.bottomRight.y) <= maxY && max(other.topLeft.y, other.bottomRight.y) >= minY) {
+					queryResult.push_back(index);
+				}
+			}
+		}
+	}
+
+	// keep the order in which the colliders were added
+	sort(queryResult.begin(), queryResult.end());
+	return queryResult;
+}
+
+void CollisionWorld::AddSweepEntries(const vector<GameObject*>& objects, bool isFirst) {
+	for (auto obj : objects) {
+		auto mesh = obj->GetRenderable();
+		if (mesh == nullptr) {
+			continue;
+		}
+
+		auto& bb = mesh->GetBoundingBox();
+		SweepEntry entry;
+		entry.minX = min(bb.topLeft.x, bb.bottomRight.x);
+		entry.maxX = max(bb.topLeft.x, bb.bottomRight.x);
+		entry.minY = min(bb.topLeft.y, bb.bottomRight.y);
+		entry.maxY = max(bb.topLeft.y, bb.bottomRight.y);
+		entry.object = obj;
+		entry.isFirst = isFirst;
+		sweepEntries.push_back(entry);
+	}
+}
+
+void CollisionWorld::BuildStaticGrid() {
+	staticGridDirty = false;
+
+	for (auto& cell : staticCells) {
+		cell.clear();
+	}
+
+	if (staticBoxes.empty()) {
+		gridColumns = gridRows = 0;
+		return;
+	}
+
+	float minX = staticBoxes[0].topLeft.x;
+	float minY = staticBoxes[0].topLeft.y;
+	float maxX = minX;
+	float maxY = minY;
+	float totalSize = 0;
+
+	for (auto& bb : staticBoxes) {
+		minX = min(minX, min(bb.topLeft.x, bb.bottomRight.x));
+		maxX = max(maxX, max(bb.topLeft.x, bb.bottomRight.x));
+		minY = min(minY, min(bb.topLeft.y, bb.bottomRight.y));
+		maxY = max(maxY, max(bb.topLeft.y, bb.bottomRight.y));
+		totalSize += max(abs(bb.bottomRight.x - bb.topLeft.x), abs(bb.bottomRight.y - bb.topLeft.y));
+	}
+
+	// cells of an average collider cover most of the colliders by a few cells
+	cellSize = totalSize / staticBoxes.size();
+	if (cellSize <= 0) {
+		cellSize = 1;
+	}
+
+	gridMinX = minX;
+	gridMinY = minY;
+	gridColumns = (int)((maxX - minX) / cellSize) + 1;
+	gridRows = (int)((maxY - minY) / cellSize) + 1;
+
+	if ((int)staticCells.size() < gridColumns * gridRows) {
+		staticCells.resize(gridColumns * gridRows);
+	}
+
+	for (int i = 0; i < (int)staticBoxes.size(); i++) {
+		auto& bb = staticBoxes[i];
+		int maxColumn = GetColumn(max(bb.topLeft.x, bb.bottomRight.x));
+		int maxRow = GetRow(max(bb.topLeft.y, bb.bottomRight.y));
+
+		for (int row = GetRow(min(bb.topLeft.y, bb.bottomRight.y)); row <= maxRow; row++) {
+			for (int column = GetColumn(min(bb.topLeft.x, bb.bottomRight.x)); column <= maxColumn; column++) {
+				staticCells[row * gridColumns + column].push_back(i);
+			}
+		}
+	}
+}
+
+int CollisionWorld::GetColumn(float x) const {
+	int column = (int)floor((x - gridMinX) / cellSize);
+	return max(0, min(gridColumns - 1, column));
+}
+
+int CollisionWorld::GetRow(float y) const {
+	int row = (int)floor((y - gridMinY) / cellSize);
+	return max(0, min(gridRows - 1, row));
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include "BoundingBox.h"
+
+using namespace std;
+
+class Scene;
+class GameObject;
+
+/**
+ * Pair of game objects whose bounding boxes overlap
+ */
+struct CollisionPair {
+	// object with the first flag
+	GameObject* first;
+	// object with the second flag
+	GameObject* second;
+};
+
+/**
+ * Broad phase of collision detection
+ *
+ * Dynamic objects are taken from the flag index of the scene, which is maintained incrementally,
+ * and their bounding boxes are tested by sweep and prune along the x axis
+ * Static colliders (e.g. tiles or bricks) are kept in a uniform grid and can be queried by a bounding box
+ *
+ * Results are written into buffers owned by the world; they are reused by the next query,
+ * hence nothing is allocated once the buffers have grown large enough
+ */
+class CollisionWorld {
+private:
+	/**
+	* Entry of the sweep, bounding box projected on both axes
+	*/
+	struct SweepEntry {
+		float minX;
+		float maxX;
+		float minY;
+		float maxY;
+		GameObject* object;
+		// indicator whether the object belongs to the first set
+		bool isFirst;
+	};
+
+	Scene* scene;
+
+	// buffers of the sweep
+	vector<SweepEntry> sweepEntries;
+	vector<int> activeFirst;
+	vector<int> activeSecond;
+	vector<CollisionPair> pairs;
+
+	// static colliders and the grid of their indices
+	vector<BoundingBox> staticBoxes;
+	vector<vector<int>> staticCells;
+	bool staticGridDirty = false;
+	float cellSize = 1;
+	float gridMinX = 0;
+	float gridMinY = 0;
+	int gridColumns = 0;
+	int gridRows = 0;
+	// stamp of the last query that found each static collider, prevents duplicates
+	vector<unsigned> staticStamps;
+	unsigned queryStamp = 0;
+	vector<int> queryResult;
+
+public:
+	CollisionWorld(Scene* scene) : scene(scene) {
+
+	}
+
+	/**
+	* Finds all pairs of objects with given flags whose bounding boxes overlap
+	* Objects without a renderable are ignored; if both flags are equal, each pair is reported once
+	* The returned collection is valid until the next call
+	*/
+	const vector<CollisionPair>& FindCollisions(unsigned firstFlag, unsigned secondFlag);
+
+	/**
+	* Adds a static collider with given bounding box
+	* @return index of the collider, colliders are indexed in the order they were added
+	*/
+	int AddStatic(const BoundingBox& bb);
+
+	/**
+	* Removes all static colliders
+	*/
+	void ClearStatic();
+
+	/**
+	* Gets number of static colliders
+	*/
+	int GetStaticCount() const {
+		return staticBoxes.size();
+	}
+
+	/**
+	* Gets bounding box of a static collider
+	*/
+	const BoundingBox& GetStaticBox(int index) const {
+		return staticBoxes[index];
+	}
+
+	/**
+	* Finds indices of all static colliders that overlap given bounding box, sorted in ascending order
+	* The returned collection is valid until the next call
+	*/
+	const vector<int>& QueryStatic(const BoundingBox& bb);
+
+private:
+	void AddSweepEntries(const vector<GameObject*>& objects, bool isFirst);
+
+	void BuildStaticGrid();
+
+	int GetColumn(float x) const;
+
+	int GetRow(float y) const;
+};
@@ -4,10 +4,37 @@
 
 int Component::idCounter = 0;
 
+unordered_map<type_index, unsigned>& ComponentType::GetRegistry() {
+	// function-local static, so that the registry exists before any static initializer asks for an id
+	static unordered_map<type_index, unsigned> registry;
+	return registry;
+}
+
+unsigned ComponentType::Register(const type_info& type) {
+	auto& registry = GetRegistry();
+	auto found = registry.find(type_index(type));
+
+	if (found != registry.end()) {
+		return found->second;
+	}
+
+	unsigned id = registry.size();
+	registry[type_index(type)] = id;
+	return id;
+}
+
+unsigned ComponentType::GetId(const Component* component) {
+	return Register(typeid(*component));
+}
+
 void Component::RegisterSubscriber(StrId action) {
 	owner->GetScene()->RegisterSubscriber(action, this);
 }
 
+void Component::RegisterDeferredSubscriber(StrId action) {
+	owner->GetScene()->RegisterSubscriber(action, this, true);
+}
+
 void Component::SendMsg(StrId action) {
 	Msg msg(action, this->id, owner, nullptr);
 	SendMsg(msg);
@@ -22,6 +49,16 @@ void Component::SendMsg(Msg& msg) {
 	owner->GetScene()->SendMsg(msg);
 }
 
+void Component::PostMsg(StrId action) {
+	Msg msg(action, this->id, owner, nullptr);
+	owner->GetScene()->PostMsg(msg);
+}
+
+void Component::PostMsg(StrId action, void* data) {
+	Msg msg(action, this->id, owner, data);
+	owner->GetScene()->PostMsg(msg);
+}
+
 Context* Component::GetContext() const {
 	return owner->GetContext();
 }
@@ -1,21 +1,59 @@
 #pragma once
 
+#include <typeinfo>
+#include <typeindex>
+#include <unordered_map>
 #include "Msg.h"
+#include "SceneAllocator.h"
+
+using namespace std;
 
 class GameObject;
 class Context;
 class Scene;
+class Component;
+class BaseComponentPool;
+
+/**
+ * Generator of component type ids; each type of component gets its own id,
+ * starting from 0, the first time it is asked for
+ */
+class ComponentType {
+private:
+	static unordered_map<type_index, unsigned>& GetRegistry();
+
+	static unsigned Register(const type_info& type);
+public:
+	/**
+	* Gets id of given type of component; the id is evaluated only once for each type
+	*/
+	template<class T> static unsigned GetId() {
+		static const unsigned id = Register(typeid(T));
+		return id;
+	}
+
+	/**
+	* Gets id of the actual type of given component
+	*/
+	static unsigned GetId(const Component* component);
+};
 
 /**
  * Game component
  */
-class Component {
+class Component : public SceneAllocated {
 protected:
 	// owner of this component
-	GameObject* owner;
+	GameObject* owner = nullptr;
+	// pool the component was created in, if any
+	BaseComponentPool* pool = nullptr;
+	// index of the component in its pool
+	int poolIndex = -1;
 	// incremental counter
 	static int idCounter; 
 	int id;
+	// id of the component type, assigned when the component is attached to a game object
+	unsigned typeId = 0;
 	bool enabled = true;
 	bool isScriptComponent = false;
 public:
@@ -36,6 +74,21 @@ public:
 		return owner;
 	}
 
+	/**
+	* Gets id of the component type, see ComponentType
+	*/
+	unsigned GetTypeId() const {
+		return typeId;
+	}
+
+	/**
+	* Returns true, if the component was created in a pool
+	* Such components are updated by the pool and not by their owner
+	*/
+	bool IsPooled() const {
+		return pool != nullptr;
+	}
+
 	void SetOwner(GameObject* owner) {
 		this->owner = owner;
 	}
@@ -54,6 +107,17 @@ public:
 		
 	}
 
+	/**
+	 * Handler of a batch of messages of the same action, invoked by the batched dispatch
+	 * Calls OnMessage for each message by default; components may override it
+	 * in order to process the whole batch at once
+	 */
+	virtual void OnMessages(MsgSpan messages) {
+		for (auto& msg : messages) {
+			OnMessage(msg);
+		}
+	}
+
 
 	virtual void Update(uint64_t delta, uint64_t absolute) = 0;
 
@@ -72,6 +136,13 @@ protected:
 	 */
 	void RegisterSubscriber(StrId action);
 
+	/**
+	 * Registers itself as a deferred subscriber of given action; messages of this action
+	 * are queued and delivered in batches when the scene dispatches its messages
+	 * Note that the context node and the data payload of a queued message may no longer be valid
+	 */
+	void RegisterDeferredSubscriber(StrId action);
+
 	/**
 	 * Sends message to all subscribers
 	 */
@@ -81,9 +152,19 @@ protected:
 	
 	void SendMsg(Msg& msg);
 
+	/**
+	 * Posts message into the queue of the scene; it will be delivered to all subscribers
+	 * when the scene dispatches its messages
+	 */
+	void PostMsg(StrId action);
+
+	void PostMsg(StrId action, void* data);
+
 	Context* GetContext() const;
 
 	Scene* GetScene() const;
 
 	friend class ScriptManager;
+	friend class GameObject;
+	template<class T> friend class ComponentPool;
 };
\ No newline at end of file
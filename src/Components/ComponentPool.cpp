@@ -0,0 +1,8 @@
+#include "ComponentPool.h"
+#include "GameObject.h"
+#include "Scene.h"
+
+bool BaseComponentPool::IsAttached(Component* component) {
+	auto owner = component->GetOwner();
+	return owner != nullptr && (owner->IsInScene() || owner == owner->GetScene()->GetRootObject());
+}
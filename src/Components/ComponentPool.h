@@ -0,0 +1,181 @@
+#pragma once
+
+#include <vector>
+#include <type_traits>
+#include <functional>
+#include "Component.h"
+
+using namespace std;
+
+// number of components in one chunk of a pool
+#define COMPONENT_POOL_CHUNK_SIZE 1024
+
+/**
+ * Base class for pools of components of one type
+ */
+class BaseComponentPool {
+protected:
+	// indicator whether the pool is iterating its components
+	bool isUpdating = false;
+	// components released while the pool was updating; they are destroyed after the update
+	vector<Component*> pendingReleases;
+public:
+
+	virtual ~BaseComponentPool() {
+
+	}
+
+	/**
+	* Updates all components of the pool whose owners are in the scene
+	*/
+	virtual void Update(uint64_t delta, uint64_t absolute) = 0;
+
+	/**
+	* Destroys a component that was created by this pool and returns its slot back to the pool
+	* If the pool is being updated, the component is skipped by the rest of the update
+	* and destroyed after it, as it may still be running
+	*/
+	virtual void Release(Component* component) = 0;
+
+	/**
+	* Gets number of living components
+	*/
+	virtual int GetSize() const = 0;
+
+protected:
+	/**
+	* Returns true, if the owner of given component is a part of the scene
+	* Components of objects that were removed from the scene are not updated
+	*/
+	static bool IsAttached(Component* component);
+};
+
+/**
+ * Pool that keeps components of one type in contiguous chunks of memory
+ * and updates all of them in one loop, without walking the scene graph
+ * Components created by the pool are not updated by their owners and
+ * they are destroyed via the pool when they are removed from their owners
+ */
+template<class T>
+class ComponentPool : public BaseComponentPool {
+protected:
+	typedef typename aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+	// chunks of memory; their addresses don't change when the pool grows
+	vector<Storage*> chunks;
+	// indicator for each slot whether it contains a living component
+	vector<bool> alive;
+	// indices of free slots
+	vector<int> freeSlots;
+	// number of living components
+	int size = 0;
+
+public:
+
+	~ComponentPool() {
+		for (int i = 0; i < (int)alive.size(); i++) {
+			if (alive[i]) {
+				At(i)->~T();
+			}
+		}
+
+		for (auto chunk : chunks) {
+			delete[] chunk;
+		}
+	}
+
+	/**
+	* Creates a new component in the pool; it has to be added to its owner afterwards
+	*/
+	template<typename... Args>
+	T* Create(Args&&... args) {
+		int index;
+
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		} else {
+			index = alive.size();
+			if (index == (int)chunks.size() * COMPONENT_POOL_CHUNK_SIZE) {
+				chunks.push_back(new Storage[COMPONENT_POOL_CHUNK_SIZE]);
+			}
+			alive.push_back(false);
+		}
+
+		T* component = new (At(index)) T(std::forward<Args>(args)...);
+		component->pool = this;
+		component->poolIndex = index;
+		alive[index] = true;
+		size++;
+		return component;
+	}
+
+	virtual void Release(Component* component) {
+		alive[component->poolIndex] = false;
+		size--;
+
+		if (isUpdating) {
+			pendingReleases.push_back(component);
+		} else {
+			Destroy(component);
+		}
+	}
+
+	virtual int GetSize() const {
+		return size;
+	}
+
+	/**
+	* Calls given function for each living component, in the order of their slots
+	*/
+	void ForEach(std::function<void(T&)> func) {
+		BeginUpdate();
+		for (int i = 0; i < (int)alive.size(); i++) {
+			if (alive[i]) {
+				func(*At(i));
+			}
+		}
+		EndUpdate();
+	}
+
+	virtual void Update(uint64_t delta, uint64_t absolute) {
+		BeginUpdate();
+		for (int i = 0; i < (int)alive.size(); i++) {
+			if (alive[i]) {
+				T* component = At(i);
+				if (IsAttached(component)) {
+					// the type is known here, hence the call doesn't have to be dispatched virtually
+					component->T::Update(delta, absolute);
+				}
+			}
+		}
+		EndUpdate();
+	}
+
+protected:
+	T* At(int index) {
+		return reinterpret_cast<T*>(&chunks[index / COMPONENT_POOL_CHUNK_SIZE][index % COMPONENT_POOL_CHUNK_SIZE]);
+	}
+
+	/**
+	* Destroys a released component and returns its slot back to the pool
+	*/
+	void Destroy(Component* component) {
+		int index = component->poolIndex;
+		static_cast<T*>(component)->~T();
+		freeSlots.push_back(index);
+	}
+
+	void BeginUpdate() {
+		isUpdating = true;
+	}
+
+	void EndUpdate() {
+		isUpdating = false;
+
+		for (auto component : pendingReleases) {
+			Destroy(component);
+		}
+		pendingReleases.clear();
+	}
+};
@@ -3,6 +3,8 @@
 #include <set>
 using namespace std;
 
+class SpriteAtlas;
+
 /**
  * Global context that can be attached to all game objects.
  * May provide access to some enviromental attributes
@@ -30,6 +32,13 @@ public:
 
 	virtual ofImage* GetImage(string path) = 0;
 
+	/**
+	* Gets atlas of packed images of the game, or nullptr if the game doesn't use any
+	*/
+	virtual SpriteAtlas* GetSpriteAtlas() {
+		return nullptr;
+	}
+
 	virtual void ResetGame() = 0;
 
 	virtual void PlaySound(string path) = 0;
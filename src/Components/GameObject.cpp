@@ -1,12 +1,45 @@
 #include "GameObject.h"
 #include "Scene.h"
+#include "ComponentPool.h"
 #include "CompValues.h"
+#include "LooseQuadTree.h"
+#include <cfloat>
 
 int GameObject::idCounter = 0;
 
 
+void GameObject::SetNetworkId(int networkId) {
+	int oldNetworkId = this->networkId;
+	this->networkId = networkId;
+
+	if (IsInScene() && oldNetworkId != networkId) {
+		scene->OnNetworkIdChanged(this, oldNetworkId);
+	}
+}
+
+void GameObject::SetName(const string& name) {
+	string oldName = this->name;
+	this->name = name;
+
+	if (IsInScene() && oldName != name) {
+		scene->OnNameChanged(this, oldName);
+	}
+}
+
 void GameObject::SetFlags(Flags val) {
+	if (IsInScene()) {
+		for (auto state : flags.GetAllStates()) {
+			scene->OnFlagChanged(this, state, false);
+		}
+	}
+
 	this->flags = val;
+
+	if (IsInScene()) {
+		for (auto state : flags.GetAllStates()) {
+			scene->OnFlagChanged(this, state, true);
+		}
+	}
 }
 
 bool GameObject::HasFlag(unsigned state) const {
@@ -14,15 +47,32 @@ bool GameObject::HasFlag(unsigned state) const {
 }
 
 void GameObject::SetFlag(unsigned state) {
-	flags.SetState(state);
+	if (!flags.HasState(state)) {
+		flags.SetState(state);
+		if (IsInScene()) scene->OnFlagChanged(this, state, true);
+	}
 }
 
 void GameObject::ResetFlag(unsigned state) {
-	flags.ResetState(state);
+	if (flags.HasState(state)) {
+		flags.ResetState(state);
+		if (IsInScene()) scene->OnFlagChanged(this, state, false);
+	}
 }
 
 void GameObject::SwitchFlag(unsigned state1, unsigned state2) {
+	bool hadState1 = flags.HasState(state1);
+	bool hadState2 = flags.HasState(state2);
 	flags.SwitchState(state1, state2);
+
+	if (IsInScene()) {
+		// compare with the actual result instead of guessing what the switch did
+		bool hasState1 = flags.HasState(state1);
+		bool hasState2 = flags.HasState(state2);
+
+		if (hadState1 != hasState1) scene->OnFlagChanged(this, state1, hasState1);
+		if (state1 != state2 && hadState2 != hasState2) scene->OnFlagChanged(this, state2, hasState2);
+	}
 }
 
 
@@ -46,6 +96,17 @@ void GameObject::Remove() {
 void GameObject::AddComponent(Component* component) {
 	this->components.push_back(component);
 	component->SetOwner(this);
+	// the actual type is resolved only once, lookups by type are indexed afterwards
+	component->typeId = ComponentType::GetId(component);
+
+	if (component->typeId >= componentsByType.size()) {
+		componentsByType.resize(component->typeId + 1, nullptr);
+	}
+
+	if (componentsByType[component->typeId] == nullptr) {
+		componentsByType[component->typeId] = component;
+	}
+
 	component->Init(); // initialize component
 }
 
@@ -56,6 +117,7 @@ bool GameObject::RemoveComponent(Component* component) {
 		component->SetOwner(nullptr);
 		scene->RemoveSubscriber(component);
 		components.erase(found);
+		RemoveFromTypeIndex(component);
 		return true;
 	}
 
@@ -64,34 +126,81 @@ bool GameObject::RemoveComponent(Component* component) {
 
 void GameObject::RemoveAllComponents() {
 	for (auto comp : components) {
-		RemoveComponent(comp);
+		comp->SetOwner(nullptr);
+		scene->RemoveSubscriber(comp);
 	}
 
 	components.clear();
+	componentsByType.clear();
 }
 
 bool GameObject::DestroyComponent(Component* component) {
 	bool result = RemoveComponent(component);
-	if (result) { delete component; }
+	if (result) { DeleteComponent(component); }
 	return result;
 }
 
+GameObject::~GameObject() {
+	DestroyAllComponents();
+	DestroyAllChildren();
+	DestroyAllAttributes();
+	// a detached object mustn't be deleted again when the scene is cleared
+	scene->OnObjectAttached(this);
+
+	// objects that aren't removed by the scene, e.g. its root, would leave a dangling entry in the tree
+	if (spatialTree != nullptr) {
+		spatialTree->Remove(this);
+	}
+
+	// each object has its own mesh
+	delete mesh;
+}
+
 void GameObject::DestroyAllComponents() {
 	for (auto comp : components) {
 		scene->RemoveSubscriber(comp);
-		delete comp;
+		DeleteComponent(comp);
 	}
 
 	components.clear();
+	componentsByType.clear();
+}
+
+void GameObject::DeleteComponent(Component* component) {
+	if (component->IsPooled()) {
+		component->pool->Release(component);
+	} else {
+		delete component;
+	}
+}
+
+void GameObject::RemoveFromTypeIndex(Component* component) {
+	if (componentsByType[component->typeId] == component) {
+		// another component of the same type takes its place
+		componentsByType[component->typeId] = nullptr;
+		for (auto comp : components) {
+			if (comp->typeId == component->typeId) {
+				componentsByType[component->typeId] = comp;
+				break;
+			}
+		}
+	}
 }
 
 void GameObject::AddChild(GameObject* child) {
 	child->SetParent(this);
+	scene->OnObjectAttached(child);
+
+	// bounds of the subtrees don't cover the new child until the next update
+	for (auto obj = this; obj != nullptr && obj->hasSubtreeBounds; obj = obj->parent) {
+		obj->hasSubtreeBounds = false;
+	}
 
 	if (isUpdating) {
 		childrenToAdd.push_back(child);
 	}
 	else {
+		child->childIndex = children.size();
 		this->children.push_back(child);
 		scene->AddGameObjectInternal(child);
 	}
@@ -99,16 +208,25 @@ void GameObject::AddChild(GameObject* child) {
 
 bool GameObject::RemoveChild(GameObject* child) {
 
-	auto found = std::find(children.begin(), children.end(), child);
+	int index = child->childIndex;
 
-	if (found != children.end()) {
+	if (index >= 0 && index < (int)children.size() && children[index] == child) {
 		if (isUpdating) {
 			childrenToRemove.push_back(child);
 		}
 		else {
+			// only release the slot, the collection is compacted later in order to keep
+			// the removal cost independent of the number of children
 			child->SetParent(nullptr);
-			children.erase(found);
+			child->childIndex = -1;
+			children[index] = nullptr;
+			removedChildren++;
 			scene->RemoveGameObjectInternal(child);
+			scene->OnObjectDetached(child);
+
+			if (removedChildren * 2 > (int)children.size()) {
+				CompactChildren();
+			}
 		}
 		return true;
 	}
@@ -123,24 +241,62 @@ bool GameObject::DestroyChild(GameObject* child) {
 }
 
 void GameObject::RemoveAllChildren() {
+	if (isUpdating) {
+		// removal is deferred, the collection doesn't change
+		for (auto child : children) {
+			if (child != nullptr) RemoveChild(child);
+		}
+		return;
+	}
+
+	// children are detached without compacting, which would resize the collection being iterated
 	for (auto child : children) {
-		RemoveChild(child);
+		if (child != nullptr) {
+			child->SetParent(nullptr);
+			child->childIndex = -1;
+			scene->RemoveGameObjectInternal(child);
+			scene->OnObjectDetached(child);
+		}
 	}
+	children.clear();
+	removedChildren = 0;
 }
 
 void GameObject::DestroyAllChildren() {
 	for (auto child : children) {
-		scene->RemoveGameObjectInternal(child);
-		delete child;
+		if (child != nullptr) {
+			scene->RemoveGameObjectInternal(child);
+			delete child;
+		}
 	}
 	children.clear();
+	removedChildren = 0;
+}
+
+void GameObject::CompactChildren() {
+	if (removedChildren == 0) return;
+
+	int count = 0;
+
+	for (int i = 0; i < (int)children.size(); i++) {
+		if (children[i] != nullptr) {
+			children[i]->childIndex = count;
+			children[count++] = children[i];
+		}
+	}
+
+	children.resize(count);
+	removedChildren = 0;
 }
 
 void GameObject::Update(uint64_t delta, uint64_t absolute) {
+	CompactChildren();
 	isUpdating = true;
-	// update components
+	// update components; pooled components are updated by their pools
 	for (auto comp : components) {
-		comp->Update(delta, absolute);
+		if (!comp->IsPooled()) {
+			comp->Update(delta, absolute);
+		}
 	}
 
 	// update children
@@ -161,44 +317,86 @@ void GameObject::Update(uint64_t delta, uint64_t absolute) {
 	childrenToRemove.clear();
 }
 
-void GameObject::UpdateTransformations() {
+int GameObject::UpdateTransformations() {
+	int recalculated = 0;
+	auto& transform = GetTransform();
 
 	if (parent != nullptr) {
-		GetTransform().CalcAbsTransform(parent->GetTransform());
-	}else {
-		GetTransform().SetAbsAsLocal();
+		if (!transform.IsAbsTransformValid(parent->GetTransform())) {
+			transform.CalcAbsTransform(parent->GetTransform());
+			recalculated++;
+		}
+	}else if (!transform.IsAbsAsLocalValid()) {
+		transform.SetAbsAsLocal();
+		recalculated++;
+	}
+
+	if (this->mesh->RefreshBoundingBox() && spatialTree != nullptr) {
+		spatialTree->Update(this);
 	}
 
-	this->mesh->UpdateBoundingBox();
+	CompactChildren();
+
+	// the subtree bounds are merged from the draw bounds of the mesh and the bounds of all children,
+	// meshes that don't draw anything (e.g. empty objects that only group their children) don't extend them
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	hasSubtreeBounds = true;
+	visibleSubtreeSize = 0;
+
+	if (this->mesh->IsVisible()) {
+		visibleSubtreeSize++;
+		auto& bounds = this->mesh->GetDrawBounds();
+
+		if (!this->mesh->HasDrawBounds()) {
+			hasSubtreeBounds = false;
+		}
+		else if (bounds.topLeft != bounds.bottomRight) {
+			minX = bounds.topLeft.x;
+			minY = bounds.topLeft.y;
+			maxX = bounds.bottomRight.x;
+			maxY = bounds.bottomRight.y;
+		}
+	}
 
 	for (auto child : children) {
-		child->UpdateTransformations();
+		recalculated += child->UpdateTransformations();
+		visibleSubtreeSize += child->visibleSubtreeSize;
+
+		if (!child->hasSubtreeBounds) {
+			hasSubtreeBounds = false;
+		}
+		else if (hasSubtreeBounds) {
+			auto& bounds = child->subtreeBounds;
+			minX = min(minX, bounds.topLeft.x);
+			minY = min(minY, bounds.topLeft.y);
+			maxX = max(maxX, bounds.bottomRight.x);
+			maxY = max(maxY, bounds.bottomRight.y);
+		}
 	}
+
+	// empty subtree keeps inverted bounds, which don't overlap anything
+	subtreeBounds.topLeft = ofVec2f(minX, minY);
+	subtreeBounds.topRight = ofVec2f(maxX, minY);
+	subtreeBounds.bottomLeft = ofVec2f(minX, maxY);
+	subtreeBounds.bottomRight = ofVec2f(maxX, maxY);
+
+	return recalculated;
 }
 
 
 bool GameObject::RemoveAttr(StrId key, bool destroy) {
-	auto it = attributes.find(key);
-
-	if (it != attributes.end()) {
-		BaseAttribute* attr = it->second;
-		attributes.erase(it);
-		if (destroy) delete attr;
-		return true;
-	}
-	return false;
+	return attributes.Remove(key, destroy);
 }
 
 void GameObject::RemoveAllAttributes() {
-	attributes.clear();
+	attributes.Clear(false);
 }
 
 void GameObject::DestroyAllAttributes() {
-	for (auto attr : attributes) {
-		delete attr.second;
-	}
-
-	attributes.clear();
+	attributes.Clear(true);
 }
 
 void GameObject::AddAttrString(StrId key, string val) {
@@ -254,17 +452,7 @@ Vec2i GameObject::GetAttrVec2i(StrId key) {
 }
 
 void* GameObject::GetAttrPtr(StrId key) {
-	auto it = attributes.find(key);
-	if(it != attributes.end()) {
-		if(it->second->IsPointer()) {
-			// address of a pointer
-			return *(void**)(it->second->RawVal());
-		}else {
-			// address of a value
-			return it->second->RawVal();
-		}
-	}
-
-	return nullptr;
+	// address of a value or the pointer itself
+	return attributes.GetPtr(key);
 }
 
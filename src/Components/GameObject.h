@@ -13,22 +13,27 @@ using namespace std;
 #include "Vec2i.h"
 
 class Scene;
+class LooseQuadTree;
 
 
 /**
 * Game object, structured in a tree hierarchy
 */
-class GameObject {
+class GameObject : public SceneAllocated {
+public:
+	// network id of objects that are not synchronized over network
+	static const int NO_NETWORK_ID = -1;
 protected:
 	static int idCounter;
 	int id;
-	int networkId;
+	int networkId = NO_NETWORK_ID;
 	Renderable* mesh = nullptr;
 	GameObject* parent = nullptr;
 	Flags flags;
 	vector<GameObject*> children;
 	vector<Component*> components;			// list of components
-	map<StrId, BaseAttribute*> attributes;  // list of attributes
+	vector<Component*> componentsByType;	// first component of each type, indexed by type id
+	AttributeTable attributes;				// list of attributes
 	Context* context;
 	Scene* scene;
 	bool isUpdating = false;
@@ -36,6 +41,25 @@ protected:
 	vector<GameObject*> childrenToAdd;
 	vector<GameObject*> childrenToRemove;
 	string name = "";
+	// position in the scene collection of all objects, -1 if the object isn't registered
+	int sceneIndex = -1;
+	// position in the scene index of objects with the same name
+	int sceneNameIndex = -1;
+	// positions in the scene indices of objects with the same flag, as pairs of [flag, position]
+	vector<pair<unsigned, int>> sceneFlagIndices;
+	// position in the collection of children of the parent
+	int childIndex = -1;
+	// number of removed children whose slots haven't been compacted yet
+	int removedChildren = 0;
+	// spatial index the object is inserted in and its position in it
+	LooseQuadTree* spatialTree = nullptr;
+	int spatialEntry = -1;
+	// area the object and all its descendants are drawn into, calculated by UpdateTransformations
+	BoundingBox subtreeBounds;
+	// indicator whether the subtree bounds are known and still cover all descendants
+	bool hasSubtreeBounds = false;
+	// number of visible meshes in the subtree
+	int visibleSubtreeSize = 0;
 public:
 	GameObject(Context* context, Scene* scene) : id(idCounter++), context(context), scene(scene), mesh(new FRect(0, 0)) { }
 
@@ -45,11 +69,7 @@ public:
 
 	GameObject(string name, Context* context, Scene* scene, Renderable* mesh) : id(idCounter++), name(name), context(context), scene(scene), mesh(mesh) {}
 
-	~GameObject() {
-		DestroyAllComponents();
-		DestroyAllChildren();
-		DestroyAllAttributes();
-	}
+	~GameObject();
 
 	int GetId() const {
 		return id;
@@ -59,17 +79,13 @@ public:
 		return networkId;
 	}
 
-	void SetNetworkId(int networkId) {
-		this->networkId = networkId;
-	}
+	void SetNetworkId(int networkId);
 
 	const string& GetName() const {
 		return name;
 	}
 
-	void SetName(const string& name) {
-		this->name = name;
-	}
+	void SetName(const string& name);
 
 	Trans& GetTransform() const {
 		return mesh->GetTransform();
@@ -83,6 +99,13 @@ public:
 		return this->context;
 	}
 
+	/**
+	* Returns true, if this object is registered in its scene
+	*/
+	bool IsInScene() const {
+		return sceneIndex != -1;
+	}
+
 	GameObject* GetParent() const {
 		return this->parent;
 	}
@@ -103,6 +126,8 @@ public:
 
 	void SetParent(GameObject* parent) {
 		this->parent = parent;
+		// the absolute transformation was calculated from another parent
+		GetTransform().Invalidate();
 	}
 
 	/**
@@ -151,6 +176,7 @@ public:
 	}
 
 	vector<GameObject*>& GetChildren() {
+		CompactChildren();
 		return this->children;
 	}
 
@@ -158,13 +184,32 @@ public:
 	 * Gets component by its type
 	 */
 	template<class T> T* GetComponent() {
-		for (auto cmp : this->components) {
-			if (typeid(*cmp) == typeid(T)) {
-				return static_cast<T*>(cmp);
+		unsigned typeId = ComponentType::GetId<T>();
+		return typeId < componentsByType.size() ? static_cast<T*>(componentsByType[typeId]) : nullptr;
+	}
+
+	/**
+	 * Gets all components of given type
+	 */
+	template<class T> vector<T*> GetComponents() {
+		vector<T*> output;
+		unsigned typeId = ComponentType::GetId<T>();
+
+		if (typeId < componentsByType.size() && componentsByType[typeId] != nullptr) {
+			for (auto cmp : components) {
+				if (cmp->GetTypeId() == typeId) {
+					output.push_back(static_cast<T*>(cmp));
+				}
 			}
 		}
+		return output;
+	}
 
-		return nullptr;
+	/**
+	 * Returns true, if the object contains a component of given type
+	 */
+	template<class T> bool HasComponent() {
+		return GetComponent<T>() != nullptr;
 	}
 
 	void AddComponent(Component* component);
@@ -191,8 +236,34 @@ public:
 
 	/**
 	 * Recursively updates all transformations
+	 * Only transformations whose local values or parents have changed are recalculated,
+	 * the same goes for bounding boxes, which are recalculated also when the size of the mesh changes
+	 * @return number of recalculated transformations, for profiling
 	 */
-	void UpdateTransformations();
+	int UpdateTransformations();
+
+	/**
+	* Gets area the object and all its descendants are drawn into, e.g. for culling of the whole subtree
+	* Valid only if HasSubtreeBounds returns true
+	*/
+	const BoundingBox& GetSubtreeBounds() const {
+		return subtreeBounds;
+	}
+
+	/**
+	* Returns true, if the subtree bounds are known; they aren't known if any mesh of the subtree
+	* can be drawn anywhere or if a child has been added since the last update of transformations
+	*/
+	bool HasSubtreeBounds() const {
+		return hasSubtreeBounds;
+	}
+
+	/**
+	* Gets number of visible meshes in the subtree, calculated by UpdateTransformations
+	*/
+	int GetVisibleSubtreeSize() const {
+		return visibleSubtreeSize;
+	}
 
 	/**
 	* Adds a new attribute or replaces already existing attribute
@@ -200,13 +271,11 @@ public:
 	* @param value reference
 	*/
 	template<class T> void AddAttr(StrId key, T value, bool isShared = false) {
-		RemoveAttr(key, true);
-
-		attributes[key] = new Attribute<T>(key, value, this, isShared);
+		attributes.Add(key, value, this, isShared);
 	}
 
 	bool HasAttr(StrId key) {
-		return attributes.count(key) != 0;
+		return attributes.Find(key) != -1;
 	}
 
 	bool RemoveAttr(StrId key, bool destroy);
@@ -219,9 +288,14 @@ public:
 	* Gets an attribute by its key
 	*/
 	template<class T> T& GetAttr(StrId key) {
-		auto it = attributes.find(key);
-		Attribute<T>* attr = static_cast<Attribute<T>*>(it->second);
-		return attr->Get();
+		return attributes.Get<T>(attributes.Find(key));
+	}
+
+	/**
+	* Gets a cached reference to an attribute that can be dereferenced without searching
+	*/
+	template<class T> AttrHandle<T> GetAttrHandle(StrId key) {
+		return AttrHandle<T>(&attributes, key);
 	}
 
 
@@ -229,10 +303,9 @@ public:
 	* Changes value of selected attribute or adds a new attribute if this one doesn't exist
 	*/
 	template<class T> void ChangeAttr(StrId key, T value) {
-		auto it = attributes.find(key);
-		if (it != attributes.end()) {
-			Attribute<T>* attr = static_cast<Attribute<T>*>(it->second);
-			attr->Set(value);
+		int index = attributes.Find(key);
+		if (index != -1) {
+			attributes.Get<T>(index) = value;
 		}
 		else {
 			AddAttr(key, value);
@@ -279,4 +352,23 @@ public:
 	void* GetAttrPtrStatic(){
 		return GetAttrPtr(StrId(str));
 	}
+
+protected:
+	/**
+	* Removes slots of removed children while keeping the order of the remaining ones
+	*/
+	void CompactChildren();
+
+	/**
+	* Removes a detached component from the index of components by type
+	*/
+	void RemoveFromTypeIndex(Component* component);
+
+	/**
+	* Deletes a detached component or returns it back to its pool
+	*/
+	void DeleteComponent(Component* component);
+
+	friend class Scene;
+	friend class LooseQuadTree;
 };
\ No newline at end of file
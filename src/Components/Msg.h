@@ -110,3 +110,34 @@ public:
 		return static_cast<T*>(data);
 	}
 };
+
+
+/**
+* Contiguous sequence of messages of the same action, delivered by a batched dispatch
+*/
+class MsgSpan {
+private:
+	Msg* first;
+	int count;
+public:
+
+	MsgSpan(Msg* first, int count) : first(first), count(count) {
+
+	}
+
+	Msg* begin() const {
+		return first;
+	}
+
+	Msg* end() const {
+		return first + count;
+	}
+
+	int GetCount() const {
+		return count;
+	}
+
+	Msg& operator[](int index) const {
+		return first[index];
+	}
+};
@@ -1,43 +1,78 @@
 #include "Scene.h"
+#include <algorithm>
 #include "GameObject.h"
 #include "Component.h"
 #include "CompValues.h"
+#include "LooseQuadTree.h"
 
 void Scene::FindGameObjectsByFlag(unsigned flag, vector<GameObject*>& output) {
-	for (auto gameObj : allGameObjects) {
-		if (gameObj->HasFlag(flag)) {
-			output.push_back(gameObj);
-		}
+	auto found = objectsByFlag.find(flag);
+	if (found != objectsByFlag.end()) {
+		output.insert(output.end(), found->second.begin(), found->second.end());
 	}
 }
 
+const vector<GameObject*>& Scene::GetGameObjectsByFlag(unsigned flag) {
+	// creates an empty bucket if there is none, so that the reference stays valid
+	// when objects with this flag are added later
+	return objectsByFlag[flag];
+}
+
 void Scene::FindGameObjectsByName(string name, vector<GameObject*>& output) {
-	// linear search :-(
-	for(auto gameObj : allGameObjects) {
-		if(gameObj->GetName() == name) {
-			output.push_back(gameObj);
-		}
+	auto found = objectsByName.find(name);
+	if (found != objectsByName.end()) {
+		output.insert(output.end(), found->second.begin(), found->second.end());
 	}
 }
 
 GameObject* Scene::FindGameObjectByName(string name) {
-	for (auto gameObj : allGameObjects) {
-		if (gameObj->GetName() == name) {
-			return gameObj;
-		}
+	auto found = objectsByName.find(name);
+	if (found != objectsByName.end() && !found->second.empty()) {
+		return found->second.front();
 	}
 	return nullptr;
 }
 
 GameObject* Scene::FindGameObjectByNetworkId(int id) {
-	for (auto gameObj : allGameObjects) {
-		if (gameObj->GetNetworkId() == id) {
-			return gameObj;
-		}
+	auto found = objectsByNetworkId.find(id);
+	if (found != objectsByNetworkId.end()) {
+		return found->second;
 	}
 	return nullptr;
 }
 
+Scene::~Scene() {
+	for (auto pool : componentPools) {
+		delete pool;
+	}
+}
+
+void Scene::Clear() {
+	if (rootObject != nullptr) {
+		delete rootObject;
+		rootObject = nullptr;
+	}
+
+	// each object removes itself from the collection when it is deleted
+	while (!detachedObjects.empty()) {
+		delete *detachedObjects.begin();
+	}
+
+	// queued messages refer to objects of the previous scene
+	sentQueue.clear();
+	postedQueue.clear();
+
+	allocator.Reset();
+}
+
+void Scene::UpdateComponentPools(uint64_t delta, uint64_t absolute) {
+	for (auto pool : componentPools) {
+		if (pool != nullptr) {
+			pool->Update(delta, absolute);
+		}
+	}
+}
+
 
 void Scene::SendMsg(Msg& msg) {
 	auto registeredSubs = subscribers.find(msg.GetAction());
@@ -50,12 +85,106 @@ void Scene::SendMsg(Msg& msg) {
 			}
 		}
 	}
+
+	if (deferredSubscribers.count(msg.GetAction()) != 0) {
+		sentQueue.push_back(msg);
+	}
+}
+
+void Scene::PostMsg(Msg& msg) {
+	postedQueue.push_back(msg);
+}
+
+void Scene::DispatchMessages() {
+	// messages sent by the handlers go to the next dispatch
+	dispatchedSent.swap(sentQueue);
+	dispatchedPosted.swap(postedQueue);
+
+	DispatchQueue(dispatchedSent, false);
+	DispatchQueue(dispatchedPosted, true);
+
+	dispatchedSent.clear();
+	dispatchedPosted.clear();
+}
+
+void Scene::DispatchQueue(vector<Msg>& messages, bool toAllSubscribers) {
+	auto compare = [](const Msg& a, const Msg& b) {
+		return a.GetAction().GetValue() < b.GetAction().GetValue();
+	};
+
+	// group messages by their actions
+	if (!is_sorted(messages.begin(), messages.end(), compare)) {
+		stable_sort(messages.begin(), messages.end(), compare);
+	}
+
+	int groupStart = 0;
+
+	while (groupStart < (int)messages.size()) {
+		StrId action = messages[groupStart].GetAction();
+		int groupEnd = groupStart + 1;
+		
+		while (groupEnd < (int)messages.size() && messages[groupEnd].GetAction() == action) {
+			groupEnd++;
+		}
+
+		Msg* group = &messages[groupStart];
+		int count = groupEnd - groupStart;
+
+		// the lists are accessed by index, as handlers may remove subscribers
+		auto deferredSubs = deferredSubscribers.find(action);
+		if (deferredSubs != deferredSubscribers.end()) {
+			for (int i = 0; i < (int)deferredSubs->second.size(); i++) {
+				DeliverMessages(deferredSubs->second[i], group, count);
+			}
+		}
+
+		auto registeredSubs = subscribers.find(action);
+		if (toAllSubscribers && registeredSubs != subscribers.end()) {
+			for (int i = 0; i < (int)registeredSubs->second.size(); i++) {
+				DeliverMessages(registeredSubs->second[i], group, count);
+			}
+		}
+
+		groupStart = groupEnd;
+	}
 }
 
+void Scene::DeliverMessages(Component* subscriber, Msg* messages, int count) {
+	// consecutive messages are delivered at once; the sequence is split only
+	// by messages the subscriber sent itself
+	int spanStart = 0;
+	int subscriberId = subscriber->GetId();
+
+	for (int i = 0; i < count; i++) {
+		if (messages[i].GetSenderId() == subscriberId) {
+			if (i > spanStart) {
+				subscriber->OnMessages(MsgSpan(messages + spanStart, i - spanStart));
+			}
+			spanStart = i + 1;
+		}
+	}
+
+	if (count > spanStart) {
+		subscriber->OnMessages(MsgSpan(messages + spanStart, count - spanStart));
+	}
+}
 
 void Scene::AddGameObjectInternal(GameObject* obj) {
-	if (find(allGameObjects.begin(), allGameObjects.end(), obj) == allGameObjects.end()) {
+	if (!obj->IsInScene()) {
+		obj->sceneIndex = allGameObjects.size();
 		allGameObjects.push_back(obj);
+
+		// update indices
+		AddToNameIndex(obj);
+
+		for (auto flag : obj->flags.GetAllStates()) {
+			AddToFlagIndex(obj, flag);
+		}
+
+		if (obj->GetNetworkId() != GameObject::NO_NETWORK_ID) {
+			objectsByNetworkId[obj->GetNetworkId()] = obj;
+		}
+
 		// send event
 		Msg msg(OBJECT_ADDED, obj->GetId(), obj, nullptr);
 		SendMsg(msg);
@@ -63,21 +192,46 @@ void Scene::AddGameObjectInternal(GameObject* obj) {
 }
 
 void Scene::RemoveGameObjectInternal(GameObject* obj) {
-	auto foundObj = find(allGameObjects.begin(), allGameObjects.end(), obj);
-	if(foundObj != allGameObjects.end()) {
-		allGameObjects.erase(foundObj);
+	if(obj->IsInScene()) {
+		// swap with the last object and pop
+		auto last = allGameObjects.back();
+		allGameObjects[obj->sceneIndex] = last;
+		last->sceneIndex = obj->sceneIndex;
+		allGameObjects.pop_back();
+		obj->sceneIndex = -1;
+
+		// update indices
+		RemoveFromNameIndex(obj, obj->GetName());
+
+		while (!obj->sceneFlagIndices.empty()) {
+			RemoveFromFlagIndex(obj, obj->sceneFlagIndices.back().first);
+		}
+
+		auto foundNetObj = objectsByNetworkId.find(obj->GetNetworkId());
+		if (foundNetObj != objectsByNetworkId.end() && foundNetObj->second == obj) {
+			objectsByNetworkId.erase(foundNetObj);
+		}
+
+		if (obj->spatialTree != nullptr) {
+			obj->spatialTree->Remove(obj);
+		}
+
 		// send event
 		Msg msg(OBJECT_REMOVED, obj->GetId(), obj, nullptr);
 		SendMsg(msg);
 	}
 }
 
-void Scene::RegisterSubscriber(StrId action, Component* component) {
-	if (subscribers.count(action) == 0) {
-		subscribers[action] = vector <Component*>();
-	}
+void Scene::OnObjectDetached(GameObject* obj) {
+	detachedObjects.insert(obj);
+}
+
+void Scene::OnObjectAttached(GameObject* obj) {
+	detachedObjects.erase(obj);
+}
 
-	vector<Component*>& listeners = subscribers[action];
+void Scene::RegisterSubscriber(StrId action, Component* component, bool deferred) {
+	vector<Component*>& listeners = deferred ? deferredSubscribers[action] : subscribers[action];
 
 	if (find(listeners.begin(), listeners.end(), component) == listeners.end()) {
 		listeners.push_back(component);
@@ -91,17 +245,24 @@ void Scene::RegisterSubscriber(StrId action, Component* component) {
 }
 
 bool Scene::RemoveSubscriber(StrId action, Component* subscriber) {
-	if (subscribers.count(action) != 0) {
-		vector<Component*>& listeners = subscribers[action];
+	bool removed = false;
 
-		for (auto it = listeners.begin(); it != listeners.end(); ++it) {
-			if ((*it)->GetId() == subscriber->GetId()) {
-				listeners.erase(it);
-				return true;
+	for (auto table : { &subscribers, &deferredSubscribers }) {
+		auto found = table->find(action);
+
+		if (found != table->end()) {
+			vector<Component*>& listeners = found->second;
+
+			for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+				if ((*it)->GetId() == subscriber->GetId()) {
+					listeners.erase(it);
+					removed = true;
+					break;
+				}
 			}
 		}
 	}
-	return false;
+	return removed;
 }
 
 void Scene::RemoveSubscriber(Component* subscriber) {
@@ -121,3 +282,72 @@ void Scene::RemoveSubscriber(Component* subscriber) {
 		subscribedActions.erase(subscriber->GetId());
 	}
 }
+
+void Scene::OnNameChanged(GameObject* obj, const string& oldName) {
+	RemoveFromNameIndex(obj, oldName);
+	AddToNameIndex(obj);
+}
+
+void Scene::OnFlagChanged(GameObject* obj, unsigned flag, bool isSet) {
+	if (isSet) {
+		AddToFlagIndex(obj, flag);
+	}
+	else {
+		RemoveFromFlagIndex(obj, flag);
+	}
+}
+
+void Scene::OnNetworkIdChanged(GameObject* obj, int oldNetworkId) {
+	auto found = objectsByNetworkId.find(oldNetworkId);
+	if (found != objectsByNetworkId.end() && found->second == obj) {
+		objectsByNetworkId.erase(found);
+	}
+
+	if (obj->GetNetworkId() != GameObject::NO_NETWORK_ID) {
+		objectsByNetworkId[obj->GetNetworkId()] = obj;
+	}
+}
+
+void Scene::AddToNameIndex(GameObject* obj) {
+	auto& bucket = objectsByName[obj->GetName()];
+	obj->sceneNameIndex = bucket.size();
+	bucket.push_back(obj);
+}
+
+void Scene::RemoveFromNameIndex(GameObject* obj, const string& name) {
+	auto& bucket = objectsByName[name];
+	auto last = bucket.back();
+	bucket[obj->sceneNameIndex] = last;
+	last->sceneNameIndex = obj->sceneNameIndex;
+	bucket.pop_back();
+	obj->sceneNameIndex = -1;
+}
+
+void Scene::AddToFlagIndex(GameObject* obj, unsigned flag) {
+	auto& bucket = objectsByFlag[flag];
+	obj->sceneFlagIndices.push_back(make_pair(flag, (int)bucket.size()));
+	bucket.push_back(obj);
+}
+
+void Scene::RemoveFromFlagIndex(GameObject* obj, unsigned flag) {
+	auto& indices = obj->sceneFlagIndices;
+	auto found = find_if(indices.begin(), indices.end(), [flag](const pair<unsigned, int>& idx) { return idx.first == flag; });
+
+	if (found != indices.end()) {
+		auto& bucket = objectsByFlag[flag];
+		auto last = bucket.back();
+		bucket[found->second] = last;
+
+		// objects keep only a few flags, hence the linear search
+		for (auto& lastIdx : last->sceneFlagIndices) {
+			if (lastIdx.first == flag) {
+				lastIdx.second = found->second;
+				break;
+			}
+		}
+
+		bucket.pop_back();
+		*found = indices.back();
+		indices.pop_back();
+	}
+}
@@ -2,8 +2,12 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include "StrId.h"
 #include "Msg.h"
+#include "ComponentPool.h"
+#include "SceneAllocator.h"
 
 using namespace std;
 
@@ -14,13 +18,41 @@ class GameObject;
 class Scene {
 private:
 	string name;
-	map<StrId, vector<Component*>> subscribers;
+	// subscribers of each action, notified as soon as a message is sent
+	unordered_map<unsigned, vector<Component*>> subscribers;
+	// subscribers of each action, notified in batches by DispatchMessages
+	unordered_map<unsigned, vector<Component*>> deferredSubscribers;
 	// listeners ids and their registered actions
-	map<int, vector<StrId>> subscribedActions;
+	unordered_map<int, vector<StrId>> subscribedActions;
+
+	// messages waiting for the batched dispatch, in the order they were sent
+	// sent messages go only to the deferred subscribers, posted messages go to all subscribers
+	vector<Msg> sentQueue;
+	vector<Msg> postedQueue;
+	// messages being dispatched; kept as members so that their capacity is reused every frame
+	vector<Msg> dispatchedSent;
+	vector<Msg> dispatchedPosted;
 	
-	// all game objects of the scene
+	// all game objects of the scene; each object keeps its position so that it can be removed
+	// in constant time by swapping it with the last one
 	vector<GameObject*> allGameObjects;
 
+	// secondary indices, maintained incrementally whenever an object is added, removed
+	// or changes its name, flags or network id
+	// objects keep their positions in the buckets as well, hence the order of objects is not preserved
+	unordered_map<string, vector<GameObject*>> objectsByName;
+	unordered_map<unsigned, vector<GameObject*>> objectsByFlag;
+	unordered_map<int, GameObject*> objectsByNetworkId;
+
+	// objects that were removed from their parents and haven't been deleted or added again
+	// they are destroyed when the scene is cleared, so that nothing keeps the arena alive
+	unordered_set<GameObject*> detachedObjects;
+
+	// pools of components, indexed by component type id
+	vector<BaseComponentPool*> componentPools;
+	// arena for objects, components, attributes and meshes of the scene
+	SceneAllocator allocator;
+
 	GameObject* rootObject = nullptr;
 public:
 
@@ -32,6 +64,12 @@ public:
 		
 	}
 
+	/**
+	* Destroys the pools of components
+	* Game objects with pooled components have to be destroyed before the scene
+	*/
+	~Scene();
+
 	const string& GetName() const {
 		return name;
 	}
@@ -48,8 +86,36 @@ public:
 		this->name = name;
 	}
 
+	/**
+	* Gets arena of the scene; objects are allocated in it while it is active, see SceneAllocatorScope
+	*/
+	SceneAllocator& GetAllocator() {
+		return allocator;
+	}
+
+	/**
+	* Destroys the root object together with the whole scene graph and releases
+	* the arena of the scene at once, including meshes that weren't deleted by their owners
+	* Objects that were removed from the scene graph but never deleted are destroyed as well
+	*/
+	void Clear();
+
+	/**
+	* Gets all game objects registered in the scene, in no particular order
+	*/
+	const vector<GameObject*>& GetAllGameObjects() const {
+		return allGameObjects;
+	}
+
 	void FindGameObjectsByFlag(unsigned flag, vector<GameObject*>& output);
 
+	/**
+	* Gets all game objects with given flag, in no particular order
+	* The collection is kept up to date by the scene, hence it can be held and iterated each frame
+	* without searching again; it mustn't be iterated while objects are being added or removed
+	*/
+	const vector<GameObject*>& GetGameObjectsByFlag(unsigned flag);
+
 	void FindGameObjectsByName(string name, vector<GameObject*>& output);
 
 	GameObject* FindGameObjectByName(string name);
@@ -57,8 +123,50 @@ public:
 	GameObject* FindGameObjectByNetworkId(int id);
 
 
+	/**
+	* Sends message to all subscribers of its action; deferred subscribers receive it
+	* when the messages are dispatched
+	*/
 	void SendMsg(Msg& msg);
 
+	/**
+	* Puts message into the queue; it will be delivered to all subscribers when the messages are dispatched
+	*/
+	void PostMsg(Msg& msg);
+
+	/**
+	* Delivers all queued messages in one pass
+	* Messages are grouped by their actions, keeping the order in which they were sent,
+	* and each subscriber receives each group at once, see Component::OnMessages
+	* Sent messages are delivered before posted ones; messages sent during the dispatch
+	* are delivered by the next call
+	*/
+	void DispatchMessages();
+
+	/**
+	* Gets pool of components of given type, creates a new one if it doesn't exist yet
+	* Components created by the pool are updated in one batch, by UpdateComponentPools
+	*/
+	template<class T> ComponentPool<T>* GetComponentPool() {
+		unsigned typeId = ComponentType::GetId<T>();
+
+		if (typeId >= componentPools.size()) {
+			componentPools.resize(typeId + 1, nullptr);
+		}
+
+		if (componentPools[typeId] == nullptr) {
+			componentPools[typeId] = new ComponentPool<T>();
+		}
+
+		return static_cast<ComponentPool<T>*>(componentPools[typeId]);
+	}
+
+	/**
+	* Updates all pooled components, one type after another
+	* Should be called after the update of the scene graph
+	*/
+	void UpdateComponentPools(uint64_t delta, uint64_t absolute);
+
 
 	friend class GameObject;
 	friend class Component;
@@ -68,9 +176,53 @@ protected:
 
 	void RemoveGameObjectInternal(GameObject* obj);
 
-	void RegisterSubscriber(StrId action, Component* component);
+	void RegisterSubscriber(StrId action, Component* component, bool deferred = false);
 
 	bool RemoveSubscriber(StrId action, Component* component);
 
 	void RemoveSubscriber(Component* component);
+
+	/**
+	* Updates the name index when a registered object changes its name
+	*/
+	void OnNameChanged(GameObject* obj, const string& oldName);
+
+	/**
+	* Updates the flag index when a registered object sets or resets a flag
+	*/
+	void OnFlagChanged(GameObject* obj, unsigned flag, bool isSet);
+
+	/**
+	* Updates the network id index when a registered object changes its network id
+	*/
+	void OnNetworkIdChanged(GameObject* obj, int oldNetworkId);
+
+	/**
+	* Keeps track of an object that was removed from its parent until it is deleted or added again
+	*/
+	void OnObjectDetached(GameObject* obj);
+
+	/**
+	* Stops tracking an object that was added to a parent or deleted
+	*/
+	void OnObjectAttached(GameObject* obj);
+
+private:
+	/**
+	* Delivers queued messages to the subscribers of their actions
+	*/
+	void DispatchQueue(vector<Msg>& messages, bool toAllSubscribers);
+
+	/**
+	* Delivers a group of messages to one subscriber, leaving out messages the subscriber sent itself
+	*/
+	void DeliverMessages(Component* subscriber, Msg* messages, int count);
+
+	void AddToNameIndex(GameObject* obj);
+
+	void RemoveFromNameIndex(GameObject* obj, const string& name);
+
+	void AddToFlagIndex(GameObject* obj, unsigned flag);
+
+	void RemoveFromFlagIndex(GameObject* obj, unsigned flag);
 };
\ No newline at end of file
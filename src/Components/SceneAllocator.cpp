@@ -0,0 +1,101 @@
+#include "SceneAllocator.h"
+#include <new>
+#include "ofLog.h"
+
+/**
+ * Header stored in front of each allocation
+ */
+struct SceneAllocationHeader {
+	// allocator the memory came from, nullptr for the global heap
+	SceneAllocator* allocator;
+	unsigned sizeClass;
+};
+
+static_assert(sizeof(SceneAllocationHeader) <= SCENE_ALLOCATOR_ALIGNMENT, "Allocation header doesn't fit into the alignment");
+
+thread_local SceneAllocator* SceneAllocator::current = nullptr;
+
+SceneAllocator::~SceneAllocator() {
+	for (auto block : blocks) {
+		delete[] block;
+	}
+}
+
+void* SceneAllocator::Allocate(size_t size) {
+	size_t fullSize = size + SCENE_ALLOCATOR_ALIGNMENT;
+	SceneAllocationHeader* header;
+
+	if (current != nullptr && size <= SCENE_ALLOCATOR_MAX_SIZE) {
+		// size classes are multiples of the alignment, including the header
+		unsigned sizeClass = (fullSize - 1) / SCENE_ALLOCATOR_ALIGNMENT;
+		header = (SceneAllocationHeader*)current->AllocateInternal(sizeClass);
+		header->allocator = current;
+		header->sizeClass = sizeClass;
+	} else {
+		header = (SceneAllocationHeader*)::operator new(fullSize);
+		header->allocator = nullptr;
+		header->sizeClass = 0;
+	}
+
+	return ((char*)header) + SCENE_ALLOCATOR_ALIGNMENT;
+}
+
+void SceneAllocator::Free(void* ptr) {
+	if (ptr == nullptr) return;
+
+	auto header = (SceneAllocationHeader*)(((char*)ptr) - SCENE_ALLOCATOR_ALIGNMENT);
+
+	if (header->allocator != nullptr) {
+		header->allocator->FreeInternal(header, header->sizeClass);
+	} else {
+		::operator delete(header);
+	}
+}
+
+void SceneAllocator::Reset() {
+	if (liveAllocations != 0) {
+		// allocations the scene doesn't own, e.g. components removed from their owners
+		// without being deleted, still live in the blocks; rewinding would hand their memory out again
+		ofLogError("SceneAllocator", "Reset skipped; %d allocations are still alive", liveAllocations);
+		return;
+	}
+
+	for (int i = 0; i < SCENE_ALLOCATOR_SIZE_CLASSES; i++) {
+		freeLists[i] = nullptr;
+	}
+
+	currentBlock = blocks.empty() ? -1 : 0;
+	blockOffset = 0;
+}
+
+void* SceneAllocator::AllocateInternal(unsigned sizeClass) {
+	liveAllocations++;
+
+	if (freeLists[sizeClass] != nullptr) {
+		// reuse freed slot; the first bytes of a free slot point to the next one
+		void* slot = freeLists[sizeClass];
+		freeLists[sizeClass] = *((void**)slot);
+		return slot;
+	}
+
+	size_t size = (sizeClass + 1) * SCENE_ALLOCATOR_ALIGNMENT;
+
+	if (currentBlock < 0 || blockOffset + size > SCENE_ALLOCATOR_BLOCK_SIZE) {
+		// move to the next block, reserve a new one if all of them are used
+		currentBlock++;
+		if (currentBlock == (int)blocks.size()) {
+			blocks.push_back(new char[SCENE_ALLOCATOR_BLOCK_SIZE]);
+		}
+		blockOffset = 0;
+	}
+
+	void* slot = blocks[currentBlock] + blockOffset;
+	blockOffset += size;
+	return slot;
+}
+
+void SceneAllocator::FreeInternal(void* header, unsigned sizeClass) {
+	liveAllocations--;
+	*((void**)header) = freeLists[sizeClass];
+	freeLists[sizeClass] = header;
+}
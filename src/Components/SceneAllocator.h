@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// size of one block of memory the allocator reserves at once
+#define SCENE_ALLOCATOR_BLOCK_SIZE 65536
+// alignment of all allocations; each allocation is prepended by a header of this size
+#define SCENE_ALLOCATOR_ALIGNMENT 16
+// allocations bigger than this are passed to the global heap
+#define SCENE_ALLOCATOR_MAX_SIZE 512
+#define SCENE_ALLOCATOR_SIZE_CLASSES (SCENE_ALLOCATOR_MAX_SIZE / SCENE_ALLOCATOR_ALIGNMENT + 1)
+
+/**
+ * Arena of a scene that serves allocations of game objects, components, attributes and meshes
+ * Memory is taken from large blocks and recycled by free lists of fixed size classes;
+ * blocks are returned only when the whole arena is reset or destroyed
+ *
+ * Allocations are served by the allocator that is active in the current thread (see SceneAllocatorScope);
+ * if there is none, the global heap is used
+ */
+class SceneAllocator {
+private:
+	// allocator that is active in the current thread
+	static thread_local SceneAllocator* current;
+
+	// reserved blocks of memory
+	vector<char*> blocks;
+	// index of the block the memory is being taken from
+	int currentBlock = -1;
+	// offset of the first unused byte in the current block
+	size_t blockOffset = SCENE_ALLOCATOR_BLOCK_SIZE;
+	// heads of free lists of all size classes
+	void* freeLists[SCENE_ALLOCATOR_SIZE_CLASSES] = {};
+	// number of allocations that haven't been freed yet
+	int liveAllocations = 0;
+
+public:
+	SceneAllocator() {
+
+	}
+
+	SceneAllocator(const SceneAllocator& copy) = delete;
+	SceneAllocator& operator=(const SceneAllocator& copy) = delete;
+
+	~SceneAllocator();
+
+	/**
+	* Allocates memory from the active allocator, or from the global heap if there is none
+	*/
+	static void* Allocate(size_t size);
+
+	/**
+	* Frees memory allocated by Allocate; the memory is returned to the allocator it came from
+	*/
+	static void Free(void* ptr);
+
+	/**
+	* Gets allocator that is active in the current thread
+	*/
+	static SceneAllocator* GetCurrent() {
+		return current;
+	}
+
+	/**
+	* Sets allocator that will be used for allocations in the current thread
+	*/
+	static void SetCurrent(SceneAllocator* allocator) {
+		current = allocator;
+	}
+
+	/**
+	* Makes the reserved blocks available again once all allocations have been freed
+	* If some allocations are still alive, the allocator is left untouched and
+	* freed memory is recycled by the free lists only
+	*/
+	void Reset();
+
+	/**
+	* Gets number of allocations that haven't been freed yet
+	*/
+	int GetLiveAllocations() const {
+		return liveAllocations;
+	}
+
+	/**
+	* Gets size of all reserved blocks in bytes
+	*/
+	size_t GetReservedMemory() const {
+		return blocks.size() * SCENE_ALLOCATOR_BLOCK_SIZE;
+	}
+
+private:
+	void* AllocateInternal(unsigned sizeClass);
+
+	void FreeInternal(void* header, unsigned sizeClass);
+};
+
+/**
+ * Makes given allocator active in the current thread for the lifetime of the scope
+ */
+class SceneAllocatorScope {
+private:
+	SceneAllocator* previous;
+public:
+	SceneAllocatorScope(SceneAllocator& allocator) : previous(SceneAllocator::GetCurrent()) {
+		SceneAllocator::SetCurrent(&allocator);
+	}
+
+	~SceneAllocatorScope() {
+		SceneAllocator::SetCurrent(previous);
+	}
+};
+
+/**
+ * Base for types that are allocated by the active scene allocator
+ */
+class SceneAllocated {
+public:
+	static void* operator new(size_t size) {
+		return SceneAllocator::Allocate(size);
+	}
+
+	static void operator delete(void* ptr) {
+		SceneAllocator::Free(ptr);
+	}
+
+	// placement forms, since the ones above hide the global placement new
+	static void* operator new(size_t, void* where) {
+		return where;
+	}
+
+	static void operator delete(void*, void*) {
+
+	}
+};
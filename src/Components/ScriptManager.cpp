@@ -237,6 +237,16 @@ void ScriptManager::InitLuaMapping() {
 		.addFunction("GetSpritesNum", &MultiSpriteMesh::GetSpritesNum)
 		.endClass();
 
+	// Tile map mesh
+	luabridge::getGlobalNamespace(L)
+		.deriveClass<TileMapMesh, Renderable>("TileMapMesh")
+		.addFunction("SetTile", &TileMapMesh::SetTile)
+		.addFunction("GetTile", &TileMapMesh::GetTile)
+		.addFunction("ClearTile", &TileMapMesh::ClearTile)
+		.addFunction("GetColumns", &TileMapMesh::GetColumns)
+		.addFunction("GetRows", &TileMapMesh::GetRows)
+		.endClass();
+
 	// Vec2i
 	luabridge::getGlobalNamespace(L)
 		.beginClass<Vec2i>("Vec2i")
@@ -381,6 +391,7 @@ void ScriptManager::InitLuaMapping() {
 		.addFunction("GetImageMesh", reinterpret_cast<ImageMesh*(GameObject::*)() const> (&GameObject::GetRenderable))
 		.addFunction("GetSpriteMesh", reinterpret_cast<SpriteMesh*(GameObject::*)() const> (&GameObject::GetRenderable))
 		.addFunction("GetMultiSpriteMesh", reinterpret_cast<MultiSpriteMesh*(GameObject::*)() const> (&GameObject::GetRenderable))
+		.addFunction("GetTileMapMesh", reinterpret_cast<TileMapMesh*(GameObject::*)() const> (&GameObject::GetRenderable))
 		.addFunction("GetText", reinterpret_cast<Text*(GameObject::*)() const> (&GameObject::GetRenderable))
 		.endClass();
 
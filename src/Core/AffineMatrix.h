@@ -0,0 +1,35 @@
+#pragma once
+#include "ofVec2f.h"
+#include "ofMatrix4x4.h"
+
+/**
+ * Compact 2D affine transformation, stored as a 3x2 matrix
+ * Points are transformed as [x', y'] = [a*x + c*y + tx, b*x + d*y + ty]
+ */
+struct AffineMatrix {
+	float a = 1;
+	float b = 0;
+	float c = 0;
+	float d = 1;
+	float tx = 0;
+	float ty = 0;
+
+	ofVec2f Transform(float x, float y) const {
+		return ofVec2f(a * x + c * y + tx, b * x + d * y + ty);
+	}
+
+	ofVec2f Transform(const ofVec2f& point) const {
+		return Transform(point.x, point.y);
+	}
+
+	/**
+	 * Converts the matrix into a 4x4 matrix that can be loaded into openFrameworks
+	 * @param z translation along the Z axis
+	 */
+	ofMatrix4x4 ToMatrix4x4(float z = 0) const {
+		return ofMatrix4x4(a, b, 0, 0,
+			c, d, 0, 0,
+			0, 0, 1, 0,
+			tx, ty, z, 1);
+	}
+};
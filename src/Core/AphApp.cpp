@@ -13,6 +13,8 @@ void AphApp::setup() {
 		this->Init();
 		
 		scene = new Scene();
+		// objects of the game are allocated in the arena of the scene
+		SceneAllocatorScope allocatorScope(scene->GetAllocator());
 		this->Reset();
 		// initialize virtual size
 		windowResized(ofGetWindowSize().x, ofGetWindowSize().y);
@@ -21,6 +23,10 @@ void AphApp::setup() {
 
 
 void AphApp::PushNodeIntoRenderer(GameObject* node) {
+	if (renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+		return;
+	}
+
 	renderer->PushNode(node->GetRenderable());
 
 	for (auto child : node->GetChildren()) {
@@ -30,6 +36,7 @@ void AphApp::PushNodeIntoRenderer(GameObject* node) {
 
 //--------------------------------------------------------------
 void AphApp::update() {
+	SceneAllocatorScope allocatorScope(scene->GetAllocator());
 	frameCounter++;
 
 	delta = ofGetSystemTime() - absolute;
@@ -40,7 +47,9 @@ void AphApp::update() {
 	uint64 fixDelta = (delta < expectedDelta) ? expectedDelta : (delta < (2 * expectedDelta)) ? delta : (2 * expectedDelta);
 
 	scene->GetRootObject()->Update(fixDelta, absolute);
-	scene->GetRootObject()->UpdateTransformations();
+	scene->UpdateComponentPools(fixDelta, absolute);
+	scene->DispatchMessages();
+	recalculatedTransforms = scene->GetRootObject()->UpdateTransformations();
 
 	if (resetGamePending) {
 		// game has to be reinitialized after the update process
@@ -17,6 +17,8 @@ public:
 
 	ofVec2f originalRootObjScale = ofVec2f(0);
 	int frameCounter = 0;
+	// number of transformations recalculated in the last frame, for profiling
+	int recalculatedTransforms = 0;
 	float fps = 60;
 	float meshDefaultScale;
 	float virtualAspectRatio;
@@ -0,0 +1,421 @@
+#include "GLRenderBackend.h"
+#include "SpriteSheetRenderer.h"
+#include "ofGLUtils.h"
+#include "ofLog.h"
+#include <cstddef>
+#include <cstdio>
+
+// transforms a corner of the unit quad by per-instance attributes, the same way as SpriteSheetRenderer::MakeQuad
+static const char* instanceVertexShader = R"(
+#version 120
+attribute vec2 corner;
+// center and halves of the size
+attribute vec4 transform;
+attribute float rotation;
+// top-left and bottom-right texture coordinates in halves of texels
+attribute vec4 texCoords;
+attribute vec4 color;
+
+void main() {
+	float c = cos(rotation);
+	float s = sin(rotation);
+	vec2 size = corner * transform.zw;
+	vec2 position = transform.xy + vec2(size.x * c - size.y * s, size.x * s + size.y * c);
+	vec2 uv = mix(texCoords.xy, texCoords.zw, corner * 0.5 + 0.5);
+	gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(uv, 0.0, 1.0);
+	gl_FrontColor = color;
+	gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 0.0, 1.0);
+}
+)";
+
+static const char* instanceFragmentShader = R"(
+#version 120
+uniform sampler2D tex0;
+
+void main() {
+	gl_FragColor = texture2D(tex0, gl_TexCoord[0].xy) * gl_Color;
+}
+)";
+
+static const char* instanceRectFragmentShader = R"(
+#version 120
+#extension GL_ARB_texture_rectangle : enable
+uniform sampler2DRect tex0;
+
+void main() {
+	gl_FragColor = texture2DRect(tex0, gl_TexCoord[0].xy) * gl_Color;
+}
+)";
+
+GLRenderBackend::GLRenderBackend() {
+	// two triangles for each quad, the same as the order of its vertices
+	quadIndices = new unsigned short[SPRITE_BATCH_MAX_SPRITES * 6];
+	for (int i = 0; i < SPRITE_BATCH_MAX_SPRITES; i++) {
+		unsigned short first = i * 4;
+		unsigned short* indices = &quadIndices[i * 6];
+		indices[0] = first;
+		indices[1] = indices[3] = first + 1;
+		indices[2] = indices[4] = first + 2;
+		indices[5] = first + 3;
+	}
+}
+
+GLRenderBackend::~GLRenderBackend() {
+	delete[] quadIndices;
+
+	if (indexBuffer != 0) {
+		glDeleteBuffers(1, &indexBuffer);
+	}
+
+	if (cornerBuffer != 0) {
+		glDeleteBuffers(1, &cornerBuffer);
+	}
+}
+
+GLRenderBackend* GLRenderBackend::GetInstance() {
+	static GLRenderBackend instance;
+	return &instance;
+}
+
+void GLRenderBackend::BeginFrame(int virtualWidth, int virtualHeight) {
+	ClearStats();
+	ofSetupScreenOrtho(virtualWidth, virtualHeight, -1000.0f, 1000.0f);
+	ofBackground(0);
+}
+
+int GLRenderBackend::GetScreenWidth() {
+	return ofGetWindowWidth();
+}
+
+int GLRenderBackend::GetScreenHeight() {
+	return ofGetWindowHeight();
+}
+
+void GLRenderBackend::SetViewport(float x, float y, float width, float height) {
+	stats.stateChanges++;
+	ofViewport(x, y, width, height);
+}
+
+void GLRenderBackend::LoadMatrix(const ofMatrix4x4& matrix) {
+	stats.stateChanges++;
+	ofLoadMatrix(matrix);
+}
+
+void GLRenderBackend::SetColor(const ofColor& color) {
+	stats.stateChanges++;
+	ofSetColor(color);
+}
+
+void GLRenderBackend::SetFill(bool fill) {
+	stats.stateChanges++;
+
+	if (fill) {
+		ofFill();
+		ofSetLineWidth(0);
+	}
+	else {
+		ofNoFill();
+		ofSetLineWidth(1);
+	}
+}
+
+void GLRenderBackend::DrawRectangle(float x, float y, float width, float height) {
+	stats.drawCalls++;
+	stats.vertices += 4;
+	ofDrawRectangle(x, y, width, height);
+}
+
+void GLRenderBackend::DrawCircle(float x, float y, float radius) {
+	stats.drawCalls++;
+	stats.vertices += SHAPE_CIRCLE_SEGMENTS;
+	ofDrawCircle(x, y, radius);
+}
+
+void GLRenderBackend::DrawImage(ofImage* image, const AtlasRegion* region) {
+	stats.drawCalls++;
+	stats.textureBinds++;
+	stats.vertices += 4;
+
+	if (region != nullptr) {
+		image->drawSubsection(0, 0, region->width, region->height, region->x, region->y);
+	}
+	else {
+		image->draw(0, 0);
+	}
+}
+
+void GLRenderBackend::DrawString(ofTrueTypeFont* font, const string& text, float x, float y) {
+	stats.drawCalls++;
+	stats.textureBinds++;
+	stats.vertices += text.size() * 6;
+	font->drawString(text, x, y);
+}
+
+void GLRenderBackend::DrawShapes(const ShapeVertex* vertices, int count) {
+	stats.drawCalls++;
+	stats.vertices += count;
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(ShapeVertex), &vertices[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ShapeVertex), &vertices[0].r);
+	glDrawArrays(GL_TRIANGLES, 0, count);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+void GLRenderBackend::DrawTexts(ofTexture* texture, const TextVertex* vertices, int count) {
+	stats.drawCalls++;
+	stats.textureBinds++;
+	stats.vertices += count;
+	texture->bind();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &vertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), &vertices[0].r);
+	glDrawArrays(GL_TRIANGLES, 0, count);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	texture->unbind();
+}
+
+void GLRenderBackend::DrawImages(ofTexture* texture, const ImageVertex* vertices, int count) {
+	stats.drawCalls++;
+	stats.textureBinds++;
+	stats.vertices += count;
+	texture->bind();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(ImageVertex), &vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(ImageVertex), &vertices[0].u);
+	glDrawArrays(GL_TRIANGLES, 0, count);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	texture->unbind();
+}
+
+unsigned int GLRenderBackend::CreateBuffer(int size) {
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return buffer;
+}
+
+void GLRenderBackend::DeleteBuffer(unsigned int buffer) {
+	GLuint id = buffer;
+	glDeleteBuffers(1, &id);
+}
+
+void GLRenderBackend::UpdateBuffer(unsigned int buffer, int offset, int size, const void* data) {
+	stats.uploadedBytes += size;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GLRenderBackend::DrawSpriteQuads(SpriteLayer* layer, unsigned int buffer, int count) {
+	const char* data;
+	const void* indices;
+
+	if (buffer != 0) {
+		if (indexBuffer == 0) {
+			// indices are the same for all layers and they never change
+			glGenBuffers(1, &indexBuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * SPRITE_BATCH_MAX_SPRITES * 6, quadIndices, GL_STATIC_DRAW);
+		}
+		else {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		}
+
+		// pointers are offsets into the bound buffer objects
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		data = nullptr;
+		indices = nullptr;
+	}
+	else {
+		data = (const char*)layer->quads;
+		indices = quadIndices;
+	}
+
+	stats.textureBinds++;
+	layer->texture->bind();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	// texture coordinates are stored in halves of texels
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+	glLoadIdentity();
+	glScalef(layer->textureCoeffX * 0.5f, layer->textureCoeffY * 0.5f, 1.0f);
+	glMatrixMode(GL_MODELVIEW);
+
+	for (int first = 0; first < count; first += SPRITE_BATCH_MAX_SPRITES) {
+		int batchCount = min(count - first, SPRITE_BATCH_MAX_SPRITES);
+		// indices of each batch start at zero, hence the pointers are moved to the first quad of the batch
+		const char* vertices = data + sizeof(SpriteQuad) * first;
+
+		glVertexPointer(2, GL_FLOAT, sizeof(SpriteVertex), vertices + offsetof(SpriteVertex, x));
+		glTexCoordPointer(2, GL_SHORT, sizeof(SpriteVertex), vertices + offsetof(SpriteVertex, u));
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(SpriteVertex), vertices + offsetof(SpriteVertex, r));
+		glDrawElements(GL_TRIANGLES, batchCount * 6, GL_UNSIGNED_SHORT, indices);
+		stats.drawCalls++;
+		stats.vertices += batchCount * 4;
+	}
+
+	glMatrixMode(GL_TEXTURE);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	layer->texture->unbind();
+
+	if (buffer != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
+void GLRenderBackend::DrawSpriteInstances(SpriteLayer* layer, unsigned int buffer, int count) {
+	if (cornerBuffer == 0) {
+		// top-left, top-right, bottom-left and bottom-right, drawn as a triangle strip
+		float corners[8] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+		glGenBuffers(1, &cornerBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	}
+
+	ofShader& shader = GetInstanceShader(layer->texture->getTextureData().textureTarget);
+	GLint corner = shader.getAttributeLocation("corner");
+	GLint transform = shader.getAttributeLocation("transform");
+	GLint rotation = shader.getAttributeLocation("rotation");
+	GLint texCoords = shader.getAttributeLocation("texCoords");
+	GLint color = shader.getAttributeLocation("color");
+
+	stats.textureBinds++;
+	shader.begin();
+	layer->texture->bind();
+	shader.setUniform1i("tex0", 0);
+
+	// texture coordinates are stored in halves of texels, the same as those of quads
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+	glLoadIdentity();
+	glScalef(layer->textureCoeffX * 0.5f, layer->textureCoeffY * 0.5f, 1.0f);
+	glMatrixMode(GL_MODELVIEW);
+
+	// attributes that the compiler has optimized out have location -1 and are skipped
+	glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+	if (corner >= 0) {
+		glEnableVertexAttribArray(corner);
+		glVertexAttribPointer(corner, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	}
+
+	// the other attributes advance once per instance
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	GLint attributes[4] = { transform, rotation, texCoords, color };
+	GLint sizes[4] = { 4, 1, 4, 4 };
+	GLenum types[4] = { GL_FLOAT, GL_FLOAT, GL_SHORT, GL_UNSIGNED_BYTE };
+	GLboolean normalized[4] = { GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE };
+	size_t offsets[4] = { offsetof(SpriteInstance, posX), offsetof(SpriteInstance, rotation), offsetof(SpriteInstance, u1), offsetof(SpriteInstance, r) };
+
+	for (int i = 0; i < 4; i++) {
+		if (attributes[i] >= 0) {
+			glEnableVertexAttribArray(attributes[i]);
+			SetAttributeDivisor(attributes[i], 1);
+			glVertexAttribPointer(attributes[i], sizes[i], types[i], normalized[i], sizeof(SpriteInstance), (const void*)offsets[i]);
+		}
+	}
+
+	// indices of instances aren't limited, hence all of them are drawn at once
+	if (instancingARB) {
+		glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, count);
+	}
+	else {
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+	}
+
+	stats.drawCalls++;
+	stats.vertices += count * 4;
+
+	for (GLint attribute : attributes) {
+		if (attribute >= 0) {
+			SetAttributeDivisor(attribute, 0);
+			glDisableVertexAttribArray(attribute);
+		}
+	}
+
+	if (corner >= 0) {
+		glDisableVertexAttribArray(corner);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glMatrixMode(GL_TEXTURE);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	layer->texture->unbind();
+	shader.end();
+}
+
+ofShader& GLRenderBackend::GetInstanceShader(GLenum textureTarget) {
+	bool isRect = textureTarget == GL_TEXTURE_RECTANGLE_ARB;
+	ofShader& shader = isRect ? instanceRectShader : instanceShader;
+
+	if (!shader.isLoaded()) {
+		shader.setupShaderFromSource(GL_VERTEX_SHADER, instanceVertexShader);
+		shader.setupShaderFromSource(GL_FRAGMENT_SHADER, isRect ? instanceRectFragmentShader : instanceFragmentShader);
+		shader.linkProgram();
+	}
+
+	return shader;
+}
+
+bool GLRenderBackend::SupportsInstancing() {
+	if (!instancingChecked) {
+		instancingChecked = true;
+		int major = 0;
+		int minor = 0;
+		auto version = (const char*)glGetString(GL_VERSION);
+
+		if (version != nullptr) {
+			sscanf(version, "%d.%d", &major, &minor);
+		}
+
+		if (major > 3 || (major == 3 && minor >= 3)) {
+			instancingSupported = true;
+		}
+		else if (ofGLCheckExtension("GL_ARB_instanced_arrays")) {
+			instancingSupported = true;
+			instancingARB = true;
+		}
+		else {
+			ofLogWarning("GLRenderBackend", "Instancing isn't supported, instanced sprites will be drawn as quads");
+		}
+	}
+
+	return instancingSupported;
+}
+
+void GLRenderBackend::SetAttributeDivisor(GLint attribute, GLuint divisor) {
+	if (instancingARB) {
+		glVertexAttribDivisorARB(attribute, divisor);
+	}
+	else {
+		glVertexAttribDivisor(attribute, divisor);
+	}
+}
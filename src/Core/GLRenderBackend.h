@@ -0,0 +1,87 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "ofGraphics.h"
+#include "ofShader.h"
+
+/**
+* Backend that draws by openFrameworks and OpenGL, used by default
+*
+* Batches and sprite layers are drawn from client-side arrays or buffer objects by the fixed-function pipeline;
+* all quads share one index buffer. Instanced sprites are drawn by a shader that transforms one unit quad
+*/
+class GLRenderBackend : public RenderBackend {
+private:
+	// indices of two triangles for each of SPRITE_BATCH_MAX_SPRITES quads
+	unsigned short* quadIndices;
+	// buffer object with the same indices, created when a layer is drawn from a buffer object for the first time
+	GLuint indexBuffer = 0;
+	// corners of the unit quad of instanced sprites, created by their first draw
+	GLuint cornerBuffer = 0;
+	// shaders of instanced sprites for 2D and rectangle textures
+	ofShader instanceShader;
+	ofShader instanceRectShader;
+	// whether the support of instancing has been checked, it requires OpenGL 3.3 or ARB_instanced_arrays
+	bool instancingChecked = false;
+	bool instancingSupported = false;
+	// instancing is provided only by the extension, hence its functions have to be used
+	bool instancingARB = false;
+
+public:
+	GLRenderBackend();
+
+	~GLRenderBackend();
+
+	/**
+	* Gets a backend shared by all renderers that haven't been given another one
+	*/
+	static GLRenderBackend* GetInstance();
+
+	void BeginFrame(int virtualWidth, int virtualHeight) override;
+
+	int GetScreenWidth() override;
+
+	int GetScreenHeight() override;
+
+	void SetViewport(float x, float y, float width, float height) override;
+
+	void LoadMatrix(const ofMatrix4x4& matrix) override;
+
+	void SetColor(const ofColor& color) override;
+
+	void SetFill(bool fill) override;
+
+	void DrawRectangle(float x, float y, float width, float height) override;
+
+	void DrawCircle(float x, float y, float radius) override;
+
+	void DrawImage(ofImage* image, const AtlasRegion* region) override;
+
+	void DrawString(ofTrueTypeFont* font, const string& text, float x, float y) override;
+
+	void DrawShapes(const ShapeVertex* vertices, int count) override;
+
+	void DrawTexts(ofTexture* texture, const TextVertex* vertices, int count) override;
+
+	void DrawImages(ofTexture* texture, const ImageVertex* vertices, int count) override;
+
+	unsigned int CreateBuffer(int size) override;
+
+	void DeleteBuffer(unsigned int buffer) override;
+
+	void UpdateBuffer(unsigned int buffer, int offset, int size, const void* data) override;
+
+	void DrawSpriteQuads(SpriteLayer* layer, unsigned int buffer, int count) override;
+
+	void DrawSpriteInstances(SpriteLayer* layer, unsigned int buffer, int count) override;
+
+	bool SupportsInstancing() override;
+
+private:
+	/**
+	* Gets shader of instanced sprites for given texture target, compiling it when it is used for the first time
+	*/
+	ofShader& GetInstanceShader(GLenum textureTarget);
+
+	void SetAttributeDivisor(GLint attribute, GLuint divisor);
+};
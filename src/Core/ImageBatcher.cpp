@@ -0,0 +1,49 @@
+#include "ImageBatcher.h"
+#include "GLRenderBackend.h"
+
+ImageBatcher::ImageBatcher() : backend(GLRenderBackend::GetInstance()) {
+}
+
+void ImageBatcher::AddImage(ofTexture* texture, const AffineMatrix& matrix, float x, float y, float width, float height) {
+	if (texture != this->texture) {
+		// each texture needs its own draw call
+		Flush();
+		this->texture = texture;
+	}
+
+	imagesNum++;
+	// texture coordinates depend on the texture target, hence they are calculated by the texture itself
+	ofVec2f texTopLeft = texture->getCoordFromPoint(x, y);
+	ofVec2f texBottomRight = texture->getCoordFromPoint(x + width, y + height);
+	ofVec2f corners[4] = { matrix.Transform(0, 0), matrix.Transform(width, 0),
+		matrix.Transform(0, height), matrix.Transform(width, height) };
+	ofVec2f texCorners[4] = { texTopLeft, ofVec2f(texBottomRight.x, texTopLeft.y),
+		ofVec2f(texTopLeft.x, texBottomRight.y), texBottomRight };
+	// two triangles, the same as sprite quads
+	int indices[6] = { 0, 1, 2, 1, 2, 3 };
+
+	int first = vertices.size();
+	vertices.resize(first + 6);
+	ImageVertex* vertex = &vertices[first];
+
+	for (int i = 0; i < 6; i++) {
+		vertex->x = corners[indices[i]].x;
+		vertex->y = corners[indices[i]].y;
+		vertex->u = texCorners[indices[i]].x;
+		vertex->v = texCorners[indices[i]].y;
+		vertex++;
+	}
+}
+
+void ImageBatcher::Flush() {
+	if (vertices.empty()) {
+		return;
+	}
+
+	backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
+	// images are drawn with their own colors
+	backend->SetColor(ofColor(255));
+	backend->DrawImages(texture, vertices.data(), vertices.size());
+	drawCalls++;
+	vertices.clear();
+}
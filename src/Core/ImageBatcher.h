@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "ofTexture.h"
+#include "AffineMatrix.h"
+
+using namespace std;
+
+class RenderBackend;
+
+/**
+* Vertex of a batched image, already transformed into absolute coordinates
+*/
+struct ImageVertex {
+	float x;
+	float y;
+	float u;
+	float v;
+};
+
+/**
+* Collects images into one vertex buffer and draws them by one call per texture
+*
+* Images packed into one sprite atlas share its texture, hence consecutive images of the same atlas
+* are drawn together; the batch is flushed when the texture changes, which keeps the order of the images
+* The buffer is reused by each batch, so nothing is allocated once it has grown large enough
+*/
+class ImageBatcher {
+private:
+	// texture of the current batch
+	ofTexture* texture = nullptr;
+	vector<ImageVertex> vertices;
+	// statistics of the current frame
+	int imagesNum = 0;
+	int drawCalls = 0;
+	// backend that draws the batches, not owned by the batcher
+	RenderBackend* backend;
+
+public:
+	ImageBatcher();
+
+	/**
+	* Sets backend that draws the batches, OpenGL by default
+	*/
+	void SetBackend(RenderBackend* backend) {
+		this->backend = backend;
+	}
+
+	/**
+	* Adds a part of a texture; if the texture differs from the texture of the current batch, the batch is flushed first
+	* @param matrix absolute transformation of the image, its top-left corner lies at the origin
+	* @param x x-coordinate of the part in the texture, in pixels
+	* @param y y-coordinate of the part in the texture, in pixels
+	* @param width width of the part in pixels
+	* @param height height of the part in pixels
+	*/
+	void AddImage(ofTexture* texture, const AffineMatrix& matrix, float x, float y, float width, float height);
+
+	/**
+	* Returns true, if there are images that haven't been drawn yet
+	*/
+	bool IsEmpty() const {
+		return vertices.empty();
+	}
+
+	/**
+	* Draws all collected images and clears the batch
+	* The vertices are already absolute, hence the matrix of the backend is reset to identity
+	*/
+	void Flush();
+
+	/**
+	* Resets statistics of the frame
+	*/
+	void ClearCounters() {
+		imagesNum = 0;
+		drawCalls = 0;
+	}
+
+	/**
+	* Gets number of images drawn in the current frame
+	*/
+	int GetImagesNum() const {
+		return imagesNum;
+	}
+
+	/**
+	* Gets number of draw calls issued in the current frame
+	*/
+	int GetDrawCalls() const {
+		return drawCalls;
+	}
+
+	/**
+	* Gets collected vertices, valid until the next flush
+	*/
+	const vector<ImageVertex>& GetVertices() const {
+		return vertices;
+	}
+};
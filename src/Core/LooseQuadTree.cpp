@@ -0,0 +1,371 @@
+#include "LooseQuadTree.h"
+#include <algorithm>
+#include <functional>
+#include "GameObject.h"
+
+LooseQuadTree::LooseQuadTree(const BoundingBox& bounds, int maxDepth) : maxDepth(maxDepth) {
+	x = bounds.topLeft.x;
+	y = bounds.topLeft.y;
+	width = bounds.bottomRight.x - bounds.topLeft.x;
+	height = bounds.bottomRight.y - bounds.topLeft.y;
+
+	ofVec2f cellSize(width, height);
+	for (int i = 0; i <= maxDepth; i++) {
+		cellSizes.push_back(cellSize);
+		cellSize /= 2;
+	}
+
+	AllocateNode(-1, 0, x, y);
+}
+
+LooseQuadTree::~LooseQuadTree() {
+	for (auto& entry : entries) {
+		if (entry.object != nullptr) {
+			entry.object->spatialTree = nullptr;
+			entry.object->spatialEntry = -1;
+		}
+	}
+}
+
+void LooseQuadTree::Insert(GameObject* obj) {
+	if (obj->spatialTree == this) {
+		Update(obj);
+		return;
+	}
+
+	if (obj->spatialTree != nullptr) {
+		obj->spatialTree->Remove(obj);
+	}
+
+	int index;
+	if (!freeEntries.empty()) {
+		index = freeEntries.back();
+		freeEntries.pop_back();
+	} else {
+		index = entries.size();
+		entries.push_back(QuadEntry());
+	}
+
+	auto& entry = entries[index];
+	entry.object = obj;
+	ReadBoundingBox(obj, entry);
+
+	int depth = GetDepthForSize(entry.maxX - entry.minX, entry.maxY - entry.minY);
+	int node = FindOrCreateNode((entry.minX + entry.maxX) / 2, (entry.minY + entry.maxY) / 2, depth);
+	LinkEntry(index, node);
+
+	obj->spatialTree = this;
+	obj->spatialEntry = index;
+	size++;
+}
+
+void LooseQuadTree::Remove(GameObject* obj) {
+	if (obj->spatialTree != this) {
+		return;
+	}
+
+	int index = obj->spatialEntry;
+	int node = entries[index].node;
+	UnlinkEntry(index);
+	PruneNode(node);
+
+	entries[index].object = nullptr;
+	freeEntries.push_back(index);
+	obj->spatialTree = nullptr;
+	obj->spatialEntry = -1;
+	size--;
+}
+
+void LooseQuadTree::Update(GameObject* obj) {
+	int index = obj->spatialEntry;
+	auto& entry = entries[index];
+	ReadBoundingBox(obj, entry);
+
+	float centerX = (entry.minX + entry.maxX) / 2;
+	float centerY = (entry.minY + entry.maxY) / 2;
+	int depth = GetDepthForSize(entry.maxX - entry.minX, entry.maxY - entry.minY);
+	int oldNode = entry.node;
+
+	if (nodes[oldNode].depth == depth && IsInCell(oldNode, centerX, centerY)) {
+		// the center hasn't left the cell, which is the most common case
+		return;
+	}
+
+	int newNode = FindOrCreateNode(centerX, centerY, depth, oldNode);
+	if (newNode != oldNode) {
+		UnlinkEntry(index);
+		LinkEntry(index, newNode);
+		PruneNode(oldNode);
+	}
+}
+
+void LooseQuadTree::Clear() {
+	for (auto& entry : entries) {
+		if (entry.object != nullptr) {
+			entry.object->spatialTree = nullptr;
+			entry.object->spatialEntry = -1;
+		}
+	}
+
+	entries.clear();
+	freeEntries.clear();
+	nodes.clear();
+	freeNodes.clear();
+	size = 0;
+	AllocateNode(-1, 0, x, y);
+}
+
+void LooseQuadTree::QueryRange(const BoundingBox& area, vector<GameObject*>& output) {
+	float minX = min(area.topLeft.x, area.bottomRight.x);
+	float maxX = max(area.topLeft.x, area.bottomRight.x);
+	float minY = min(area.topLeft.y, area.bottomRight.y);
+	float maxY = max(area.topLeft.y, area.bottomRight.y);
+
+	stack.clear();
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		int node = stack.back();
+		stack.pop_back();
+
+		for (int i = nodes[node].firstEntry; i != -1; i = entries[i].next) {
+			auto& entry = entries[i];
+			if (entry.minX <= maxX && entry.maxX >= minX && entry.minY <= maxY && entry.maxY >= minY) {
+				output.push_back(entry.object);
+			}
+		}
+
+		for (int child : nodes[node].children) {
+			if (child != -1 && NodeOverlaps(child, minX, minY, maxX, maxY)) {
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+void LooseQuadTree::QueryRadius(const ofVec2f& center, float radius, vector<GameObject*>& output) {
+	float radiusSq = radius * radius;
+
+	stack.clear();
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		int node = stack.back();
+		stack.pop_back();
+
+		for (int i = nodes[node].firstEntry; i != -1; i = entries[i].next) {
+			auto& entry = entries[i];
+			float dx = max(0.0f, max(entry.minX - center.x, center.x - entry.maxX));
+			float dy = max(0.0f, max(entry.minY - center.y, center.y - entry.maxY));
+			if (dx * dx + dy * dy <= radiusSq) {
+				output.push_back(entry.object);
+			}
+		}
+
+		for (int child : nodes[node].children) {
+			if (child != -1 && GetNodeDistanceSq(child, center.x, center.y) <= radiusSq) {
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+void LooseQuadTree::QueryNearest(const ofVec2f& point, int k, vector<GameObject*>& output) {
+	// best-first search; the heap contains both nodes and entries, ordered by their distances
+	// entries are stored as their indices, nodes as negative numbers
+	// since the bounds of a node contain all its objects, an entry popped from the heap is closer than
+	// anything that hasn't been popped yet
+	auto compare = greater<pair<float, int>>();
+	nearestHeap.clear();
+	nearestHeap.push_back(make_pair(0.0f, -1));
+
+	int found = 0;
+	while (!nearestHeap.empty() && found < k) {
+		pop_heap(nearestHeap.begin(), nearestHeap.end(), compare);
+		int item = nearestHeap.back().second;
+		nearestHeap.pop_back();
+
+		if (item >= 0) {
+			output.push_back(entries[item].object);
+			found++;
+			continue;
+		}
+
+		int node = -item - 1;
+		for (int i = nodes[node].firstEntry; i != -1; i = entries[i].next) {
+			auto& entry = entries[i];
+			float dx = max(0.0f, max(entry.minX - point.x, point.x - entry.maxX));
+			float dy = max(0.0f, max(entry.minY - point.y, point.y - entry.maxY));
+			nearestHeap.push_back(make_pair(dx * dx + dy * dy, i));
+			push_heap(nearestHeap.begin(), nearestHeap.end(), compare);
+		}
+
+		for (int child : nodes[node].children) {
+			if (child != -1) {
+				nearestHeap.push_back(make_pair(GetNodeDistanceSq(child, point.x, point.y), -child - 1));
+				push_heap(nearestHeap.begin(), nearestHeap.end(), compare);
+			}
+		}
+	}
+}
+
+void LooseQuadTree::GetNodeCells(vector<BoundingBox>& output) const {
+	for (auto& node : nodes) {
+		if (node.depth != -1) {
+			auto& cellSize = cellSizes[node.depth];
+			BoundingBox bb;
+			bb.topLeft = ofVec2f(node.x, node.y);
+			bb.topRight = ofVec2f(node.x + cellSize.x, node.y);
+			bb.bottomLeft = ofVec2f(node.x, node.y + cellSize.y);
+			bb.bottomRight = ofVec2f(node.x + cellSize.x, node.y + cellSize.y);
+			output.push_back(bb);
+		}
+	}
+}
+
+int LooseQuadTree::GetDepthForSize(float width, float height) const {
+	int depth = 0;
+	while (depth < maxDepth && width <= cellSizes[depth + 1].x && height <= cellSizes[depth + 1].y) {
+		depth++;
+	}
+	return depth;
+}
+
+int LooseQuadTree::FindOrCreateNode(float px, float py, int depth, int start) {
+	if (!IsInCell(0, px, py)) {
+		// objects outside of the tree are kept in the root
+		return 0;
+	}
+
+	// objects usually move only a bit, hence it is enough to go up to the nearest ancestor that contains the point
+	int node = start;
+	while (node != 0 && (nodes[node].depth > depth || !IsInCell(node, px, py))) {
+		node = nodes[node].parent;
+	}
+
+	while (nodes[node].depth < depth) {
+		auto& half = cellSizes[nodes[node].depth + 1];
+		int right = px >= nodes[node].x + half.x ? 1 : 0;
+		int bottom = py >= nodes[node].y + half.y ? 1 : 0;
+		int quadrant = right + bottom * 2;
+		int child = nodes[node].children[quadrant];
+
+		if (child == -1) {
+			child = AllocateNode(node, nodes[node].depth + 1, nodes[node].x + right * half.x, nodes[node].y + bottom * half.y);
+			// the pool may have been reallocated
+			nodes[node].children[quadrant] = child;
+			nodes[node].childCount++;
+		}
+		node = child;
+	}
+
+	return node;
+}
+
+bool LooseQuadTree::IsInCell(int node, float px, float py) const {
+	auto& cell = nodes[node];
+	auto& cellSize = cellSizes[cell.depth];
+	return px >= cell.x && px < cell.x + cellSize.x && py >= cell.y && py < cell.y + cellSize.y;
+}
+
+int LooseQuadTree::AllocateNode(int parent, int depth, float x, float y) {
+	int index;
+	if (!freeNodes.empty()) {
+		index = freeNodes.back();
+		freeNodes.pop_back();
+	} else {
+		index = nodes.size();
+		nodes.push_back(QuadNode());
+	}
+
+	auto& node = nodes[index];
+	node.x = x;
+	node.y = y;
+	node.depth = depth;
+	node.parent = parent;
+	node.children[0] = node.children[1] = node.children[2] = node.children[3] = -1;
+	node.firstEntry = -1;
+	node.entryCount = 0;
+	node.childCount = 0;
+	return index;
+}
+
+void LooseQuadTree::LinkEntry(int entry, int node) {
+	auto& item = entries[entry];
+	item.node = node;
+	item.prev = -1;
+	item.next = nodes[node].firstEntry;
+
+	if (item.next != -1) {
+		entries[item.next].prev = entry;
+	}
+
+	nodes[node].firstEntry = entry;
+	nodes[node].entryCount++;
+}
+
+void LooseQuadTree::UnlinkEntry(int entry) {
+	auto& item = entries[entry];
+	auto& node = nodes[item.node];
+
+	if (item.prev != -1) {
+		entries[item.prev].next = item.next;
+	} else {
+		node.firstEntry = item.next;
+	}
+
+	if (item.next != -1) {
+		entries[item.next].prev = item.prev;
+	}
+
+	node.entryCount--;
+	item.node = item.prev = item.next = -1;
+}
+
+void LooseQuadTree::PruneNode(int node) {
+	// the root is never removed
+	while (node != 0 && nodes[node].entryCount == 0 && nodes[node].childCount == 0) {
+		int parent = nodes[node].parent;
+		auto& parentNode = nodes[parent];
+
+		for (auto& child : parentNode.children) {
+			if (child == node) {
+				child = -1;
+			}
+		}
+		parentNode.childCount--;
+
+		nodes[node].depth = -1;
+		freeNodes.push_back(node);
+		node = parent;
+	}
+}
+
+float LooseQuadTree::GetNodeDistanceSq(int node, float px, float py) const {
+	auto& cell = nodes[node];
+	auto& cellSize = cellSizes[cell.depth];
+	// bounds of the node are loosened by a half of the cell on each side
+	float minX = cell.x - cellSize.x / 2;
+	float minY = cell.y - cellSize.y / 2;
+	float maxX = cell.x + cellSize.x * 1.5f;
+	float maxY = cell.y + cellSize.y * 1.5f;
+
+	float dx = max(0.0f, max(minX - px, px - maxX));
+	float dy = max(0.0f, max(minY - py, py - maxY));
+	return dx * dx + dy * dy;
+}
+
+bool LooseQuadTree::NodeOverlaps(int node, float minX, float minY, float maxX, float maxY) const {
+	auto& cell = nodes[node];
+	auto& cellSize = cellSizes[cell.depth];
+	return cell.x - cellSize.x / 2 <= maxX && cell.x + cellSize.x * 1.5f >= minX
+		&& cell.y - cellSize.y / 2 <= maxY && cell.y + cellSize.y * 1.5f >= minY;
+}
+
+void LooseQuadTree::ReadBoundingBox(GameObject* obj, QuadEntry& entry) const {
+	auto& bb = obj->GetRenderable()->GetBoundingBox();
+	entry.minX = min(bb.topLeft.x, bb.bottomRight.x);
+	entry.maxX = max(bb.topLeft.x, bb.bottomRight.x);
+	entry.minY = min(bb.topLeft.y, bb.bottomRight.y);
+	entry.maxY = max(bb.topLeft.y, bb.bottomRight.y);
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include "ofVec2f.h"
+#include "BoundingBox.h"
+
+using namespace std;
+
+class GameObject;
+
+// default number of levels below the root
+#define QUADTREE_DEFAULT_DEPTH 8
+
+/**
+ * Loose quad tree over bounding boxes of game objects
+ *
+ * Each object is stored in exactly one node: the deepest one whose cell is not smaller than the object,
+ * chosen by the center of the object. Bounds of each node are loosened by a half of its cell on each side,
+ * hence they contain all objects of the node and an object moves to another node only when its center
+ * leaves the cell. Objects outside the bounds of the tree are kept in the root
+ *
+ * Nodes and entries are taken from pools and linked by indices, so inserting and moving objects doesn't allocate
+ * once the pools have grown large enough; nodes without any objects are returned to the pool
+ *
+ * Inserted objects are updated by GameObject::UpdateTransformations and removed when they leave the scene
+ */
+class LooseQuadTree {
+private:
+	struct QuadNode {
+		// top-left corner of the cell
+		float x;
+		float y;
+		int depth;
+		int parent;
+		int children[4];
+		// head of the list of entries
+		int firstEntry;
+		int entryCount;
+		int childCount;
+	};
+
+	struct QuadEntry {
+		GameObject* object;
+		// bounding box of the object when it was inserted or updated
+		float minX;
+		float minY;
+		float maxX;
+		float maxY;
+		int node;
+		// neighbours in the list of the node, -1 if there is none
+		int prev;
+		int next;
+	};
+
+	float x;
+	float y;
+	float width;
+	float height;
+	int maxDepth;
+	// size of cells at each level
+	vector<ofVec2f> cellSizes;
+
+	// the root is always the first node
+	vector<QuadNode> nodes;
+	vector<int> freeNodes;
+	vector<QuadEntry> entries;
+	vector<int> freeEntries;
+	int size = 0;
+
+	// buffers of queries, reused by each query
+	vector<int> stack;
+	vector<pair<float, int>> nearestHeap;
+
+public:
+	/**
+	* Creates a tree over given area
+	* @param bounds area of the tree; objects outside of it are supported, but they aren't partitioned
+	* @param maxDepth number of levels below the root
+	*/
+	LooseQuadTree(const BoundingBox& bounds, int maxDepth = QUADTREE_DEFAULT_DEPTH);
+
+	LooseQuadTree(const LooseQuadTree& copy) = delete;
+	LooseQuadTree& operator=(const LooseQuadTree& copy) = delete;
+
+	/**
+	* Detaches all objects
+	*/
+	~LooseQuadTree();
+
+	/**
+	* Inserts an object according to the bounding box of its renderable
+	* An object can be inserted into one tree only; it has to be a part of the scene
+	*/
+	void Insert(GameObject* obj);
+
+	/**
+	* Removes an object from the tree
+	*/
+	void Remove(GameObject* obj);
+
+	/**
+	* Moves an object according to the current bounding box of its renderable
+	* Called for all inserted objects by GameObject::UpdateTransformations
+	*/
+	void Update(GameObject* obj);
+
+	/**
+	* Removes all objects
+	*/
+	void Clear();
+
+	/**
+	* Gets number of inserted objects
+	*/
+	int GetSize() const {
+		return size;
+	}
+
+	/**
+	* Gets number of nodes that are in use, including the root
+	*/
+	int GetNodeCount() const {
+		return nodes.size() - freeNodes.size();
+	}
+
+	/**
+	* Finds all objects whose bounding boxes overlap given area
+	*/
+	void QueryRange(const BoundingBox& area, vector<GameObject*>& output);
+
+	/**
+	* Finds all objects whose bounding boxes are within given distance from a point
+	*/
+	void QueryRadius(const ofVec2f& center, float radius, vector<GameObject*>& output);
+
+	/**
+	* Finds up to k objects closest to given point, sorted by the distance of their bounding boxes
+	*/
+	void QueryNearest(const ofVec2f& point, int k, vector<GameObject*>& output);
+
+	/**
+	* Collects cells of all nodes that are in use, e.g. for debug drawing
+	*/
+	void GetNodeCells(vector<BoundingBox>& output) const;
+
+private:
+	/**
+	* Gets the deepest level whose cells are not smaller than given size
+	*/
+	int GetDepthForSize(float width, float height) const;
+
+	/**
+	* Finds the node at given depth whose cell contains given point, creating all missing nodes on the way
+	* The search starts at given node and goes up only as far as needed
+	*/
+	int FindOrCreateNode(float px, float py, int depth, int start = 0);
+
+	/**
+	* Returns true, if given point lies in the cell of the node
+	*/
+	bool IsInCell(int node, float px, float py) const;
+
+	int AllocateNode(int parent, int depth, float x, float y);
+
+	void LinkEntry(int entry, int node);
+
+	void UnlinkEntry(int entry);
+
+	/**
+	* Returns empty nodes back to the pool, starting with given node and continuing with its ancestors
+	*/
+	void PruneNode(int node);
+
+	/**
+	* Gets squared distance between a point and the loosened bounds of a node
+	*/
+	float GetNodeDistanceSq(int node, float px, float py) const;
+
+	/**
+	* Returns true, if the loosened bounds of a node overlap given box
+	*/
+	bool NodeOverlaps(int node, float minX, float minY, float maxX, float maxY) const;
+
+	void ReadBoundingBox(GameObject* obj, QuadEntry& entry) const;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string>
+#include "ofColor.h"
+#include "ofMatrix4x4.h"
+#include "ofImage.h"
+#include "ofTrueTypeFont.h"
+#include "ShapeBatcher.h"
+#include "TextBatcher.h"
+#include "ImageBatcher.h"
+#include "SpriteAtlas.h"
+
+using namespace std;
+
+struct SpriteLayer;
+
+/**
+* Statistics of draw calls and state changes issued since the beginning of a frame
+*/
+struct RenderStats {
+	int drawCalls = 0;
+	int vertices = 0;
+	// changes of viewport, matrix, color and fill mode
+	int stateChanges = 0;
+	// number of draw calls that bound a texture
+	int textureBinds = 0;
+	// bytes copied into buffer objects
+	int uploadedBytes = 0;
+};
+
+/**
+* Graphics API underneath the renderer
+*
+* The renderer, its batchers and the sprite sheet renderer don't call the graphics API directly,
+* everything they draw goes through a backend. Vertices of batches are already absolute;
+* other primitives are transformed by the matrix loaded the last time
+* Coordinates are virtual, the projection is set by BeginFrame
+*/
+class RenderBackend {
+public:
+	virtual ~RenderBackend() {
+	}
+
+	/**
+	* Sets an orthographic projection of the virtual size and clears the screen with black color
+	*/
+	virtual void BeginFrame(int virtualWidth, int virtualHeight) = 0;
+
+	/**
+	* Gets size of the window (or of the framebuffer) in pixels
+	*/
+	virtual int GetScreenWidth() = 0;
+
+	virtual int GetScreenHeight() = 0;
+
+	virtual void SetViewport(float x, float y, float width, float height) = 0;
+
+	virtual void LoadMatrix(const ofMatrix4x4& matrix) = 0;
+
+	virtual void SetColor(const ofColor& color) = 0;
+
+	/**
+	* Sets whether shapes are filled or only their outlines, one unit wide, are drawn
+	*/
+	virtual void SetFill(bool fill) = 0;
+
+	virtual void DrawRectangle(float x, float y, float width, float height) = 0;
+
+	virtual void DrawCircle(float x, float y, float radius) = 0;
+
+	/**
+	* Draws an image with its top-left corner at the origin
+	* @param region part of the image to draw, or nullptr for the whole image
+	*/
+	virtual void DrawImage(ofImage* image, const AtlasRegion* region) = 0;
+
+	/**
+	* Draws a string, the same as ofTrueTypeFont::drawString
+	*/
+	virtual void DrawString(ofTrueTypeFont* font, const string& text, float x, float y) = 0;
+
+	/**
+	* Draws triangles of batched shapes
+	*/
+	virtual void DrawShapes(const ShapeVertex* vertices, int count) = 0;
+
+	/**
+	* Draws triangles of batched glyphs from the texture of their font
+	*/
+	virtual void DrawTexts(ofTexture* texture, const TextVertex* vertices, int count) = 0;
+
+	/**
+	* Draws triangles of batched images from one texture, with the current color
+	*/
+	virtual void DrawImages(ofTexture* texture, const ImageVertex* vertices, int count) = 0;
+
+	/**
+	* Creates a buffer object for vertex data
+	* @param size size in bytes
+	* @return identifier of the buffer, never 0
+	*/
+	virtual unsigned int CreateBuffer(int size) = 0;
+
+	virtual void DeleteBuffer(unsigned int buffer) = 0;
+
+	/**
+	* Copies data into a part of a buffer object
+	* @param offset offset in bytes
+	* @param size size in bytes
+	*/
+	virtual void UpdateBuffer(unsigned int buffer, int offset, int size, const void* data) = 0;
+
+	/**
+	* Draws the first quads of a sprite layer with its texture
+	* @param buffer buffer object that contains the quads, or 0 if they are drawn from the layer itself
+	* @param count number of quads
+	*/
+	virtual void DrawSpriteQuads(SpriteLayer* layer, unsigned int buffer, int count) = 0;
+
+	/**
+	* Draws sprites of a layer by instancing one unit quad
+	* @param buffer buffer object that contains the SpriteInstance data
+	* @param count number of instances
+	*/
+	virtual void DrawSpriteInstances(SpriteLayer* layer, unsigned int buffer, int count) = 0;
+
+	/**
+	* Returns true if DrawSpriteInstances can be used; otherwise instanced sprites are drawn as quads
+	*/
+	virtual bool SupportsInstancing() {
+		return true;
+	}
+
+	/**
+	* Gets statistics collected since the beginning of the frame
+	*/
+	const RenderStats& GetStats() const {
+		return stats;
+	}
+
+	/**
+	* Resets statistics, called by BeginFrame
+	*/
+	void ClearStats() {
+		stats = RenderStats();
+	}
+
+protected:
+	RenderStats stats;
+};
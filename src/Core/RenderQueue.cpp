@@ -0,0 +1,62 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+
+void RenderQueue::Push(Renderable* node, int zIndex, int layer) {
+	// shift the z-index so that negative values are sorted before positive ones
+	uint64_t z = (uint64_t)(min(max(zIndex, -0x8000), 0x7FFF) + 0x8000);
+	uint64_t key = (z << 48) | ((uint64_t)(layer & 0xFFFF) << 32) | (uint64_t)nodes.size();
+	keys.push_back(key);
+	nodes.push_back(node);
+}
+
+void RenderQueue::Sort() {
+	int size = keys.size();
+	if (size < 2) {
+		return;
+	}
+
+	// the lowest 32 bits are already sorted, since the nodes are pushed in the order of their indices
+	// hence only the bytes of z-index and layer are sorted, starting with the least significant one
+	uint64_t firstKey = keys[0];
+	uint64_t differentBits = 0;
+	for (int i = 1; i < size; i++) {
+		differentBits |= keys[i] ^ firstKey;
+	}
+
+	sortBuffer.resize(size);
+	uint64_t* source = keys.data();
+	uint64_t* target = sortBuffer.data();
+
+	for (int shift = 32; shift < 64; shift += 8) {
+		if (((differentBits >> shift) & 0xFF) == 0) {
+			// all keys have the same byte, the pass wouldn't change anything
+			continue;
+		}
+
+		int offsets[256];
+		memset(offsets, 0, sizeof(offsets));
+
+		for (int i = 0; i < size; i++) {
+			offsets[(source[i] >> shift) & 0xFF]++;
+		}
+
+		int total = 0;
+		for (int i = 0; i < 256; i++) {
+			int count = offsets[i];
+			offsets[i] = total;
+			total += count;
+		}
+
+		// stable scatter keeps the order of previous passes
+		for (int i = 0; i < size; i++) {
+			target[offsets[(source[i] >> shift) & 0xFF]++] = source[i];
+		}
+
+		swap(source, target);
+	}
+
+	if (source != keys.data()) {
+		keys.swap(sortBuffer);
+	}
+}
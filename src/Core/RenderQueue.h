@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+class Renderable;
+
+/**
+ * Queue of nodes that are going to be rendered, ordered by 64-bit sort keys
+ *
+ * Each key consists of (from the most significant bits) the z-index, the layer of the node
+ * and the order in which the node was pushed; the lowest 32 bits are also the index of the node
+ * in the payload array. Hence nodes with the same z-index and layer keep the order they were pushed in,
+ * which is the same order the former z-index buckets had
+ *
+ * Keys are sorted by a radix sort; all buffers are reused, so nothing is allocated
+ * once the queue has grown large enough
+ */
+class RenderQueue {
+private:
+	// sort keys, sorted by Sort()
+	vector<uint64_t> keys;
+	// second buffer of the radix sort
+	vector<uint64_t> sortBuffer;
+	// nodes in the order they were pushed
+	vector<Renderable*> nodes;
+
+public:
+	/**
+	* Removes all nodes, keeping the allocated memory
+	*/
+	void Clear() {
+		keys.clear();
+		nodes.clear();
+	}
+
+	/**
+	* Pushes a node
+	* @param zIndex z-index of the node, values are clamped to the range of a 16-bit integer
+	* @param layer index of the layer of the node (e.g. a sprite layer) or 0 if it has none
+	*/
+	void Push(Renderable* node, int zIndex, int layer = 0);
+
+	/**
+	* Sorts the nodes by their keys
+	*/
+	void Sort();
+
+	/**
+	* Gets number of nodes in the queue
+	*/
+	int GetSize() const {
+		return keys.size();
+	}
+
+	/**
+	* Gets node at given position in the sorted order
+	*/
+	Renderable* GetNode(int index) const {
+		// the lowest bits of the key are the index of the node
+		return nodes[(uint32_t)keys[index]];
+	}
+
+	/**
+	* Gets layer of the node at given position in the sorted order
+	*/
+	int GetLayer(int index) const {
+		return (int)((keys[index] >> 32) & 0xFFFF);
+	}
+};
@@ -1,5 +1,8 @@
 #include "Renderable.h"
 #include "ofRectangle.h"
+#include "ofxTextLabel.h"
+#include <algorithm>
+#include <cmath>
 
 void Renderable::UpdateBoundingBox() {
 	auto absPos = ofVec2f(this->transform.absPos.x, this->transform.absPos.y);
@@ -7,6 +10,114 @@ void Renderable::UpdateBoundingBox() {
 	this->boundingBox.topRight = ofVec2f(absPos.x + this->GetWidth() * this->transform.absScale.x, absPos.y);
 	this->boundingBox.bottomLeft = ofVec2f(absPos.x, absPos.y + this->GetHeight() * this->transform.absScale.y);
 	this->boundingBox.bottomRight = ofVec2f(this->boundingBox.bottomLeft.x + this->GetWidth()* this->transform.absScale.x, this->boundingBox.bottomLeft.y);
+	UpdateDrawBounds();
+}
+
+/**
+* Sets all corners of a bounding box from two opposite corners
+*/
+static void SetBoxCorners(BoundingBox& box, float x1, float y1, float x2, float y2) {
+	float minX = min(x1, x2);
+	float minY = min(y1, y2);
+	float maxX = max(x1, x2);
+	float maxY = max(y1, y2);
+	box.topLeft = ofVec2f(minX, minY);
+	box.topRight = ofVec2f(maxX, minY);
+	box.bottomLeft = ofVec2f(minX, maxY);
+	box.bottomRight = ofVec2f(maxX, maxY);
+}
+
+void Renderable::UpdateDrawBounds() {
+	auto& trans = this->transform;
+	float width = GetWidth();
+	float height = GetHeight();
+	// area of the mesh in its local space
+	float minX = 0;
+	float minY = 0;
+	float maxX = width;
+	float maxY = height;
+
+	switch (meshType) {
+	case MeshType::CIRCLE:
+		// circle is drawn around its origin
+		minX = -width / 2;
+		minY = -height / 2;
+		maxX = width / 2;
+		maxY = height / 2;
+		// continues as any other mesh drawn by its absolute matrix
+	case MeshType::RECTANGLE:
+	case MeshType::IMAGE:
+	{
+		// the mesh is drawn by its absolute matrix, the bounds enclose all its transformed corners
+		auto& matrix = trans.GetAbsMatrix();
+		ofVec2f corners[4] = { matrix.Transform(minX, minY), matrix.Transform(maxX, minY),
+			matrix.Transform(minX, maxY), matrix.Transform(maxX, maxY) };
+		ofVec2f boundsMin = corners[0];
+		ofVec2f boundsMax = corners[0];
+
+		for (int i = 1; i < 4; i++) {
+			boundsMin.x = min(boundsMin.x, corners[i].x);
+			boundsMin.y = min(boundsMin.y, corners[i].y);
+			boundsMax.x = max(boundsMax.x, corners[i].x);
+			boundsMax.y = max(boundsMax.y, corners[i].y);
+		}
+
+		SetBoxCorners(drawBounds, boundsMin.x, boundsMin.y, boundsMax.x, boundsMax.y);
+		hasDrawBounds = true;
+		break;
+	}
+	case MeshType::SPRITE:
+	{
+		// sprite is scaled and then rotated around its center, see Renderer::RenderSprite
+		float extentX = abs(trans.absScale.x * width / 2);
+		float extentY = abs(trans.absScale.y * height / 2);
+		float centerX = trans.absPos.x + trans.absScale.x * width / 2;
+		float centerY = trans.absPos.y + trans.absScale.y * height / 2;
+
+		if (trans.rotation != 0) {
+			extentX = extentY = sqrt(extentX * extentX + extentY * extentY);
+		}
+
+		SetBoxCorners(drawBounds, centerX - extentX, centerY - extentY, centerX + extentX, centerY + extentY);
+		hasDrawBounds = true;
+		break;
+	}
+	case MeshType::TILEMAP:
+	{
+		// tiles are scaled, but they aren't rotated, see Renderer::BakeChunk; rotated maps aren't drawn
+		if (trans.absRotation != 0) {
+			hasDrawBounds = false;
+			break;
+		}
+
+		float x = trans.absPos.x;
+		float y = trans.absPos.y;
+		SetBoxCorners(drawBounds, x, y, x + trans.absScale.x * width, y + trans.absScale.y * height);
+		hasDrawBounds = true;
+		break;
+	}
+	default:
+		// labels aren't transformed, texts may have more lines and sprites of a multisprite
+		// can be placed anywhere around their owner
+		hasDrawBounds = false;
+		break;
+	}
+}
+
+bool Renderable::RefreshBoundingBox() {
+	float width = GetWidth();
+	float height = GetHeight();
+
+	if (isBoundingBoxCalculated && boundingBoxVersion == transform.absVersion && boundingBoxWidth == width && boundingBoxHeight == height) {
+		return false;
+	}
+
+	UpdateBoundingBox();
+	boundingBoxVersion = transform.absVersion;
+	boundingBoxWidth = width;
+	boundingBoxHeight = height;
+	isBoundingBoxCalculated = true;
+	return true;
 }
 
 void MultiSpriteMesh::Recalc() {
@@ -51,4 +162,126 @@ void MultiSpriteMesh::RefreshZIndex() {
 		[](const Sprite*  a, const Sprite* b) -> bool {
 		return a->GetZIndex() < b->GetZIndex();
 	});
+
+	// the order of instances has changed
+	areInstancesValid = false;
+}
+
+TileMapMesh::TileMapMesh(string layerName, SpriteSheet* spriteSheet, int columns, int rows, float tileWidth, float tileHeight)
+	: Renderable(MeshType::TILEMAP), spriteSheet(spriteSheet), layerName(layerName), columns(columns), rows(rows),
+	tileWidth(tileWidth), tileHeight(tileHeight) {
+
+	layerHandle = SpriteSheetRenderer::GetLayerHandle(layerName);
+	tiles.resize(columns * rows, -1);
+	width = (columns - 1) * tileWidth + spriteSheet->GetSpriteWidth();
+	height = (rows - 1) * tileHeight + spriteSheet->GetSpriteHeight();
+
+	chunkColumns = (columns + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+	chunkRows = (rows + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+
+	for (int i = 0; i < chunkColumns * chunkRows; i++) {
+		chunks.push_back(new SpriteChunk());
+	}
+}
+
+TileMapMesh::~TileMapMesh() {
+	for (auto chunk : chunks) {
+		delete chunk;
+	}
+}
+
+void TileMapMesh::SetTile(int column, int row, int frame) {
+	if (!IsInside(column, row)) {
+		ofLogError("Mesh", "Tile [%d, %d] is outside of the map of size %dx%d!", column, row, columns, rows);
+		return;
+	}
+
+	int& tile = tiles[row * columns + column];
+
+	if (tile != frame) {
+		tile = frame;
+		chunks[(row / TILEMAP_CHUNK_SIZE) * chunkColumns + column / TILEMAP_CHUNK_SIZE]->isBaked = false;
+	}
+}
+
+void TileMapMesh::Clear() {
+	for (int row = 0; row < rows; row++) {
+		for (int column = 0; column < columns; column++) {
+			SetTile(column, row, -1);
+		}
+	}
+}
+
+void TileMapMesh::PlaceChunks() {
+	for (auto chunk : chunks) {
+		chunk->isBaked = false;
+	}
+
+	areChunksPlaced = true;
+	chunksVersion = transform.absVersion;
+}
+
+void Text::CalcSize() const {
+	textWidth = font->stringWidth(text);
+	// Height of Ay pair should cover the height
+	// of all possible bounding boxes
+	textHeight = font->stringHeight("Ay");
+	isSizeValid = true;
+}
+
+const vector<GlyphVertex>& Text::GetGlyphs() {
+	if (!isLayoutValid) {
+		glyphs.clear();
+		// the baseline is in the middle of the first line
+		TextBatcher::LayoutString(font, text, 0, font->getLineHeight() / 2, glyphs);
+		isLayoutValid = true;
+	}
+
+	return glyphs;
+}
+
+const vector<string>& Label::GetLines() {
+	if (!areLinesValid) {
+		lines.clear();
+		ofRectangle textBounds = ofRectangle();
+		ofxTextLabel::stringToLines(*font, text, labelWidth, lines, textBounds);
+		areLinesValid = true;
+		// glyphs are laid out from the lines
+		isLayoutValid = false;
+	}
+
+	return lines;
+}
+
+int Label::GetFirstVisibleLine(float height) {
+	auto& lines = GetLines();
+	// a little hack -> measure height of the text according to the height of "Ay" word that should cover all possible letters
+	int lineHeight = GetTextHeight();
+
+	if (lineHeight <= 0) {
+		return 0;
+	}
+
+	int linesToDraw = (height / (1.5f*lineHeight));
+	return max(0, (int)lines.size() - linesToDraw);
+}
+
+const vector<GlyphVertex>& Label::GetLineGlyphs(int firstLine) {
+	auto& lines = GetLines();
+
+	if (!isLayoutValid || glyphsFirstLine != firstLine) {
+		glyphs.clear();
+		float lineY = 0;
+
+		for (int i = firstLine; i < (int)lines.size(); i++) {
+			// the first baseline is at the height of the ascender
+			lineY += (i == firstLine) ? GetTextHeight() : font->getLineHeight();
+			TextBatcher::LayoutString(font, lines[i], 0, lineY, glyphs);
+		}
+
+		glyphsFirstLine = firstLine;
+		isLayoutValid = true;
+	}
+
+	return glyphs;
 }
@@ -8,9 +8,16 @@
 #include "Transform.h"
 #include "Sprite.h"
 #include "BoundingBox.h"
+#include "SceneAllocator.h"
+#include "SpriteSheetRenderer.h"
+#include "TextBatcher.h"
+#include "SpriteAtlas.h"
 
 using namespace std;
 
+// number of tiles along each side of a chunk of a tile map
+#define TILEMAP_CHUNK_SIZE 32
+
 enum class MeshType {
 	NONE,
 	RECTANGLE,			// rectangle
@@ -19,13 +26,14 @@ enum class MeshType {
 	TEXT,				// text
 	SPRITE,				// single sprite
 	MULTISPRITE,		// collection of sprites
-	CIRCLE				// circle
+	CIRCLE,				// circle
+	TILEMAP				// grid of sprites baked into chunks
 };
 
 /**
 * Base class for meshes
 */
-class Renderable {
+class Renderable : public SceneAllocated {
 protected:
 	Trans transform;
 	MeshType meshType = MeshType::NONE;
@@ -33,6 +41,14 @@ protected:
 	float width = 1;
 	float height = 1;
 	BoundingBox boundingBox = BoundingBox();
+	// values the bounding box was calculated from
+	unsigned boundingBoxVersion = 0;
+	float boundingBoxWidth = 0;
+	float boundingBoxHeight = 0;
+	bool isBoundingBoxCalculated = false;
+	// area the mesh is drawn into, calculated together with the bounding box
+	BoundingBox drawBounds = BoundingBox();
+	bool hasDrawBounds = false;
 	bool isVisible = true;
 public:
 
@@ -71,8 +87,28 @@ public:
 		return boundingBox;
 	}
 
+	/**
+	* Gets area the mesh is drawn into, including its rotation
+	* Valid only if HasDrawBounds returns true
+	*/
+	const BoundingBox& GetDrawBounds() const {
+		return drawBounds;
+	}
+
+	/**
+	* Returns true, if the area the mesh is drawn into is known; it isn't known for labels, texts
+	* and multisprites, nor for meshes whose bounding box hasn't been calculated yet
+	*/
+	bool HasDrawBounds() const {
+		return hasDrawBounds;
+	}
+
 	void SetTransform(Trans& trans) {
+		// the copy is recalculated by the next update; its version has to keep growing,
+		// otherwise the children wouldn't notice the change
+		unsigned version = this->transform.absVersion;
 		this->transform = trans;
+		this->transform.absVersion = version;
 	}
 
 	void SetColor(ofColor color) {
@@ -105,6 +141,17 @@ public:
 
 	void UpdateBoundingBox();
 
+	/**
+	* Updates the bounding box only if the absolute transformation or the size has changed since the last update
+	* @return true, if the bounding box has been updated
+	*/
+	bool RefreshBoundingBox();
+
+	/**
+	* Updates the area the mesh is drawn into, called by UpdateBoundingBox
+	*/
+	void UpdateDrawBounds();
+
 	friend class GameObject;
 
 };
@@ -209,12 +256,23 @@ public:
 class ImageMesh : public Renderable {
 private:
 	ofImage* image;
+	// part of the image that is displayed, used for images packed into a sprite atlas
+	AtlasRegion region;
+	bool hasRegion = false;
 public:
 
 	ImageMesh(ofImage* img) : Renderable(MeshType::IMAGE) {
 		this->image = img; 
 	}
 
+	/**
+	* Creates a mesh of an image packed into a sprite atlas
+	* @param path path of the original image, added to the atlas
+	*/
+	ImageMesh(SpriteAtlas* atlas, const string& path) : Renderable(MeshType::IMAGE) {
+		SetImage(atlas, path);
+	}
+
 
 	ofImage* GetImage() const {
 		return image;
@@ -222,14 +280,46 @@ public:
 
 	void SetImage(ofImage* img) {
 		this->image = img;
+		this->hasRegion = false;
+	}
+
+	/**
+	* Sets an image packed into a sprite atlas; the mesh will display only its region
+	* @param path path of the original image, added to the atlas
+	*/
+	void SetImage(SpriteAtlas* atlas, const string& path) {
+		auto found = atlas->GetRegion(path);
+
+		if (found == nullptr) {
+			ofLogError("Mesh", "Image %s not found in the atlas!", path.c_str());
+			return;
+		}
+
+		this->image = atlas->GetImage();
+		this->region = *found;
+		this->hasRegion = true;
+	}
+
+	/**
+	* Returns true, if only a part of the image is displayed
+	*/
+	bool HasRegion() const {
+		return hasRegion;
+	}
+
+	/**
+	* Gets the displayed part of the image, valid only if HasRegion returns true
+	*/
+	const AtlasRegion& GetRegion() const {
+		return region;
 	}
 
 	float GetWidth() const override {
-		return image->getWidth();
+		return hasRegion ? region.width : image->getWidth();
 	}
 
 	float GetHeight() const override {
-		return image->getHeight();
+		return hasRegion ? region.height : image->getHeight();
 	}
 
 	void SetWidth(float width) override {
@@ -243,11 +333,19 @@ public:
 
 /**
 * 2D text
+* Size and layout of the text are cached and recalculated only when the text or the font changes
 */
 class Text : public Renderable {
 protected:
 	ofTrueTypeFont* font;
-	stringstream stream;
+	string text;
+	// cached size of the text
+	mutable float textWidth = 0;
+	mutable float textHeight = 0;
+	mutable bool isSizeValid = false;
+	// glyphs of the text laid out in its local space
+	vector<GlyphVertex> glyphs;
+	bool isLayoutValid = false;
 public:
 
 	Text(ofTrueTypeFont* font) : Renderable(MeshType::TEXT) {
@@ -256,7 +354,7 @@ public:
 
 	Text(ofTrueTypeFont* font, string& text) : Renderable(MeshType::TEXT) {
 		this->font = font;
-		stream << text;
+		this->text = text;
 	}
 
 	ofTrueTypeFont* GetFont() const {
@@ -265,6 +363,7 @@ public:
 
 	void SetFont(ofTrueTypeFont* font) {
 		this->font = font;
+		InvalidateLayout();
 	}
 
 	float GetWidth() const override {
@@ -287,43 +386,74 @@ public:
 	* Gets raster width of the current string
 	*/
 	float GetTextWidth() const {
-		return font->stringWidth(stream.str());
-
+		if (!isSizeValid) {
+			CalcSize();
+		}
+		return textWidth;
 	}
 
 	/**
 	* Gets raster height of the current string
 	*/
 	float GetTextHeight() const {
-		// Height of Ay pair should cover the height
-		// of all possible bounding boxes
-		return font->stringHeight("Ay");
+		if (!isSizeValid) {
+			CalcSize();
+		}
+		return textHeight;
 	}
 
-	string GetText() const {
-		return stream.str();
+	const string& GetText() const {
+		return text;
 	}
 
-	void SetText(string text) {
-		stream.str("");
-		stream << text;
+	void SetText(const string& text) {
+		// texts are usually set every frame, mostly to the same value
+		if (this->text != text) {
+			this->text = text;
+			InvalidateLayout();
+		}
 	}
 
-	void AppendText(string text) {
-		stream << text;
+	void AppendText(const string& text) {
+		this->text += text;
+		InvalidateLayout();
 	}
 
-	void AppendLine(string text) {
-		stream << text << endl;
+	void AppendLine(const string& text) {
+		this->text += text;
+		this->text += '\n';
+		InvalidateLayout();
 	}
+
+	/**
+	* Gets glyphs of the text, laid out the same way as the text is drawn
+	*/
+	const vector<GlyphVertex>& GetGlyphs();
+
+protected:
+	/**
+	* Invalidates cached size and layout
+	*/
+	virtual void InvalidateLayout() {
+		isSizeValid = false;
+		isLayoutValid = false;
+	}
+
+	void CalcSize() const;
 };
 
 /**
-* Text not affected by transformations
+* Text that isn't affected by transformations; it is wrapped into lines
+* and drawn at its absolute position
 */
 class Label : public Text {
 protected:
 	int labelWidth;
+	// wrapped lines, recalculated only when the text, the font or the width changes
+	vector<string> lines;
+	bool areLinesValid = false;
+	// index of the first line whose glyphs are laid out
+	int glyphsFirstLine = 0;
 public:
 
 	/**
@@ -341,7 +471,10 @@ public:
 	* Sets absolute label width in pixels
 	*/
 	void SetLabelWidth(int width) {
-		this->labelWidth = width;
+		if (this->labelWidth != width) {
+			this->labelWidth = width;
+			InvalidateLayout();
+		}
 	}
 
 	/**
@@ -351,14 +484,6 @@ public:
 		return labelWidth;
 	}
 
-	ofTrueTypeFont* GetFont() const {
-		return font;
-	}
-
-	void SetFont(ofTrueTypeFont* font) {
-		this->font = font;
-	}
-
 	float GetWidth() const override {
 		return 1;
 	}
@@ -374,6 +499,27 @@ public:
 	void SetHeight(float height) override {
 		ofLogError("Mesh", "Height of mesh of type Label can't be changed!");
 	}
+
+	/**
+	* Gets lines of the text wrapped according to the width of the label
+	*/
+	const vector<string>& GetLines();
+
+	/**
+	* Gets index of the first line that is drawn; only the last lines that fit into given height are drawn
+	*/
+	int GetFirstVisibleLine(float height);
+
+	/**
+	* Gets glyphs of all lines starting with given line, laid out relative to the top-left corner of the label
+	*/
+	const vector<GlyphVertex>& GetLineGlyphs(int firstLine);
+
+protected:
+	void InvalidateLayout() override {
+		Text::InvalidateLayout();
+		areLinesValid = false;
+	}
 };
 
 /**
@@ -385,10 +531,13 @@ private:
 	Sprite sprite;
 	// name of layer or sprite sheet this sprite belongs to
 	string layerName;
+	// handle of the layer, resolved once from its name
+	int layerHandle;
 public:
 
 	SpriteMesh(const Sprite& sprite, string layerName)
 		: Renderable(MeshType::SPRITE), sprite(sprite), layerName(layerName) {
+		layerHandle = SpriteSheetRenderer::GetLayerHandle(layerName);
 	}
 
 	/**
@@ -399,6 +548,13 @@ public:
 		return layerName;
 	}
 
+	/**
+	* Gets handle of the layer this sprite belongs to
+	*/
+	int GetLayerHandle() const {
+		return layerHandle;
+	}
+
 	Sprite& GetSprite() {
 		return sprite;
 	}
@@ -433,18 +589,32 @@ private:
 	vector<Sprite*> sprites;
 	// name of the layer or sprite sheet this sprites belong to
 	string layerName;
+	// handle of the layer, resolved once from its name
+	int layerHandle;
+	// indicator whether the sprites are drawn by instancing
+	bool instanced = false;
+	// indicator whether the sprites never change, hence their instances are made only once
+	bool isStatic = false;
+	// instances of the sprites, kept between frames
+	SpriteInstanceBuffer instanceBuffer;
+	// indicator whether the instances of a static mesh are up to date
+	bool areInstancesValid = false;
+	// version of the absolute transformation of the mesh the static instances were made for
+	unsigned instancesVersion = 0;
 
 public:
 	MultiSpriteMesh(string layerName)
 		: Renderable(MeshType::MULTISPRITE), layerName(layerName) {
 		width = 1;
 		height = 1;
+		layerHandle = SpriteSheetRenderer::GetLayerHandle(layerName);
 	}
 
 	MultiSpriteMesh(string layerName, vector<Sprite*>& sprites)
 		: Renderable(MeshType::MULTISPRITE), layerName(layerName), sprites(sprites) {
 		width = 1;
 		height = 1;
+		layerHandle = SpriteSheetRenderer::GetLayerHandle(layerName);
 		Recalc();
 	}
 
@@ -470,10 +640,64 @@ public:
 	*/
 	void RefreshZIndex();
 
+	/**
+	* Enables or disables drawing by instancing
+	* Instances are drawn by one call on top of the other sprites of the layer and only those that have changed
+	* are uploaded; the sprites are culled only as a whole mesh
+	* If the backend doesn't support instancing, the sprites are drawn as quads
+	*/
+	void SetInstanced(bool instanced) {
+		this->instanced = instanced;
+	}
+
+	bool IsInstanced() const {
+		return instanced;
+	}
+
+	/**
+	* Sets whether the sprites never change, so that their instances are made and uploaded only once
+	* Instances are made again only if sprites are added or removed, if the mesh moves or if they are invalidated
+	*/
+	void SetStatic(bool isStatic) {
+		this->isStatic = isStatic;
+		areInstancesValid = false;
+	}
+
+	bool IsStatic() const {
+		return isStatic;
+	}
+
+	/**
+	* Makes instances of a static mesh again, must be called whenever any of its sprites changes
+	*/
+	void InvalidateInstances() {
+		areInstancesValid = false;
+	}
+
+	/**
+	* Returns true, if the mesh is static and its instances have been made since it last changed
+	*/
+	bool AreStaticInstancesValid() const {
+		return isStatic && areInstancesValid && instancesVersion == transform.absVersion;
+	}
+
+	/**
+	* Marks instances as made for the actual state of the mesh
+	*/
+	void ValidateInstances() {
+		areInstancesValid = true;
+		instancesVersion = transform.absVersion;
+	}
+
+	SpriteInstanceBuffer& GetInstanceBuffer() {
+		return instanceBuffer;
+	}
+
 	/**
 	* Adds a new sprite	*/
 	void AddSprite(Sprite* sprite) {
 		sprites.push_back(sprite);
+		areInstancesValid = false;
 	}
 
 	/**
@@ -488,6 +712,8 @@ public:
 		if(erase) {
 			delete sprite;
 		}
+
+		areInstancesValid = false;
 	}
 
 	void RemoveAllSprites(bool erase = true) {
@@ -497,12 +723,20 @@ public:
 			}
 		}
 		sprites.clear();
+		areInstancesValid = false;
 	}
 
-	string& GetLayerName() {
+	const string& GetLayerName() const {
 		return layerName;
 	}
 
+	/**
+	* Gets handle of the layer the sprites belong to
+	*/
+	int GetLayerHandle() const {
+		return layerHandle;
+	}
+
 	/**
 	* Gets width of the whole sprite set
 	*/
@@ -524,4 +758,166 @@ public:
 	void SetHeight(float height) override {
 		ofLogError("Mesh", "Height of mesh of type MultiSprite can't be changed!");
 	}
-};
\ No newline at end of file
+};
+
+/**
+* Grid of tiles, each of them a frame of one sprite sheet
+* Tiles are baked into chunks of TILEMAP_CHUNK_SIZE x TILEMAP_CHUNK_SIZE tiles, each of them drawn from its own
+* buffer object by one call; a chunk is baked again only when any of its tiles changes or when the map moves.
+* Chunks are drawn below the other sprites of the layer and those outside the viewport are culled
+* The map is positioned and scaled by its transform; a rotated map is rejected by the renderer and not drawn
+*/
+class TileMapMesh : public Renderable {
+private:
+	SpriteSheet* spriteSheet;
+	// name of the layer or sprite sheet the tiles belong to
+	string layerName;
+	// handle of the layer, resolved once from its name
+	int layerHandle;
+	int columns;
+	int rows;
+	// distance between two neighboring tiles
+	float tileWidth;
+	float tileHeight;
+	// frame of each tile, row by row; -1 for empty tiles
+	vector<int> tiles;
+	// number of chunks along each axis
+	int chunkColumns;
+	int chunkRows;
+	vector<SpriteChunk*> chunks;
+	// indicator whether the chunks have been baked for the actual transformation
+	bool areChunksPlaced = false;
+	// version of the absolute transformation of the map the chunks were baked for
+	unsigned chunksVersion = 0;
+
+public:
+	/**
+	* Creates an empty map
+	* @param tileWidth distance between two neighboring tiles, frames of the sprite sheet may be larger
+	* @param tileHeight distance between two neighboring tiles, frames of the sprite sheet may be larger
+	*/
+	TileMapMesh(string layerName, SpriteSheet* spriteSheet, int columns, int rows, float tileWidth, float tileHeight);
+
+	~TileMapMesh();
+
+	/**
+	* Sets frame of a tile; the chunk of the tile will be baked again if the frame differs
+	* @param frame index of a frame on the sprite sheet, -1 for an empty tile
+	*/
+	void SetTile(int column, int row, int frame);
+
+	/**
+	* Gets frame of a tile, -1 for an empty tile
+	*/
+	int GetTile(int column, int row) const {
+		if (!IsInside(column, row)) {
+			ofLogError("Mesh", "Tile [%d, %d] is outside of the map of size %dx%d!", column, row, columns, rows);
+			return -1;
+		}
+
+		return tiles[row * columns + column];
+	}
+
+	/**
+	* Returns true, if given tile lies within the map
+	*/
+	bool IsInside(int column, int row) const {
+		return column >= 0 && column < columns && row >= 0 && row < rows;
+	}
+
+	/**
+	* Makes a tile empty
+	*/
+	void ClearTile(int column, int row) {
+		SetTile(column, row, -1);
+	}
+
+	/**
+	* Makes all tiles empty
+	*/
+	void Clear();
+
+	int GetColumns() const {
+		return columns;
+	}
+
+	int GetRows() const {
+		return rows;
+	}
+
+	float GetTileWidth() const {
+		return tileWidth;
+	}
+
+	float GetTileHeight() const {
+		return tileHeight;
+	}
+
+	SpriteSheet* GetSpriteSheet() const {
+		return spriteSheet;
+	}
+
+	const string& GetLayerName() const {
+		return layerName;
+	}
+
+	/**
+	* Gets handle of the layer the tiles belong to
+	*/
+	int GetLayerHandle() const {
+		return layerHandle;
+	}
+
+	int GetChunkColumns() const {
+		return chunkColumns;
+	}
+
+	int GetChunkRows() const {
+		return chunkRows;
+	}
+
+	/**
+	* Gets chunk at given index, chunks are ordered row by row
+	*/
+	SpriteChunk* GetChunk(int index) {
+		return chunks[index];
+	}
+
+	int GetChunksNum() const {
+		return chunks.size();
+	}
+
+	/**
+	* Returns true, if the chunks have been baked for the actual position and scale of the map
+	*/
+	bool AreChunksPlaced() const {
+		return areChunksPlaced && chunksVersion == transform.absVersion;
+	}
+
+	/**
+	* Marks all chunks to be baked again for the actual position and scale of the map
+	*/
+	void PlaceChunks();
+
+	/**
+	* Gets width of the whole map, including frames of the last column that overlap the grid
+	*/
+	float GetWidth() const override {
+		return static_cast<float>(width);
+	}
+
+	/**
+	* Gets height of the whole map, including frames of the last row that overlap the grid
+	*/
+	float GetHeight() const override {
+		return static_cast<float>(height);
+	}
+
+	void SetWidth(float) override {
+		ofLogError("Mesh", "Width of mesh of type TileMap can't be changed!");
+	}
+
+	void SetHeight(float) override {
+		ofLogError("Mesh", "Height of mesh of type TileMap can't be changed!");
+	}
+};
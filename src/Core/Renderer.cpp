@@ -1,18 +1,65 @@
 #include "Renderer.h"
 #include "ofGraphics.h"
 #include "Renderable.h"
-#include "ofxTextLabel.h"
 #include "Transform.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+/**
+* Fills a tile with data of a sprite and its absolute transformation
+*/
+static inline void FillSpriteTile(const Sprite& sprite, const Trans& trans, SpriteTile& tile) {
+	tile.width = sprite.GetWidth();
+	tile.height = sprite.GetHeight();
+	tile.offsetX = sprite.GetOffsetX();
+	tile.offsetY = sprite.GetOffsetY();
+
+	tile.posX = trans.absPos.x + trans.absScale.x*tile.width / 2.0f;  // [0,0] is topleft corner
+	tile.posY = trans.absPos.y + trans.absScale.y*tile.height / 2.0f;
+	tile.posZ = trans.absPos.z;
+	tile.rotation = trans.rotation*DEG_TO_RAD;
+	tile.scaleX = trans.absScale.x;
+	tile.scaleY = trans.absScale.y;
+}
+
+/**
+* Returns number of sprites of a node that are drawn as quads of its layer; instanced multisprites
+* and tile maps have none, they are drawn from their own buffer objects
+* @param instancing whether the backend supports instancing, otherwise instanced multisprites are drawn as quads
+*/
+static inline int GetQuadSpritesNum(Renderable* node, bool instancing) {
+	if (node->GetMeshType() == MeshType::TILEMAP) {
+		return 0;
+	}
+
+	if (node->GetMeshType() != MeshType::MULTISPRITE) {
+		return 1;
+	}
+
+	auto shape = static_cast<MultiSpriteMesh*>(node);
+	return (shape->IsInstanced() && instancing) ? 0 : shape->GetSpritesNum();
+}
 
 void Renderer::OnInit() {
-	zIndexImageBuffer = map<int, vector<Renderable*>>();
-	zIndexSheetBuffer = map<int, vector<Renderable*>>();
 	renderer = new SpriteSheetRenderer();
+	renderer->SetBackend(backend);
 	rendererLayers = vector<string>();
 
 	if (virtualWidth == 0 || virtualHeight == 0) {
-		virtualWidth = ofGetWindowWidth();
-		virtualHeight = ofGetWindowHeight();
+		virtualWidth = backend->GetScreenWidth();
+		virtualHeight = backend->GetScreenHeight();
+	}
+}
+
+void Renderer::SetBackend(RenderBackend* backend) {
+	this->backend = backend;
+	shapeBatcher.SetBackend(backend);
+	textBatcher.SetBackend(backend);
+	imageBatcher.SetBackend(backend);
+
+	if (renderer != nullptr) {
+		renderer->SetBackend(backend);
 	}
 }
 
@@ -30,78 +77,94 @@ void Renderer::RemoveTileLayer(string name) {
 }
 
 void Renderer::ClearBuffers() {
-	zIndexImageBuffer = map<int, vector<Renderable*>>();
-	zIndexSheetBuffer = map<int, vector<Renderable*>>();
+	imageQueue.Clear();
+	sheetQueue.Clear();
+	culledNodes = 0;
+	drawnNodes = 0;
+	culledSprites = 0;
+	shapeBatcher.ClearCounters();
+	textBatcher.ClearCounters();
+	imageBatcher.ClearCounters();
 }
 
 void Renderer::PushNode(Renderable* node) {
 	if (node->IsVisible()) {
-		auto renderType = node->GetMeshType();
-		auto& buffer = (renderType == MeshType::SPRITE || renderType == MeshType::MULTISPRITE)
-			? zIndexSheetBuffer : zIndexImageBuffer;
+		if (cullingEnabled && node->HasDrawBounds() && !IsInViewport(node->GetDrawBounds())) {
+			culledNodes++;
+			return;
+		}
 
+		drawnNodes++;
+		auto renderType = node->GetMeshType();
 
 		Trans& tr = node->GetTransform();
 		// zIndex will be taken always from local position
 		int zIndex = (int)(tr.localPos.z);
 
-		auto it = buffer.find(zIndex);
-		if (it != buffer.end()) {
-			(*it).second.push_back(node);
+		// sprites are grouped by their layers within the same z-index, which doesn't change
+		// the order of sprites of any layer
+		if (renderType == MeshType::SPRITE) {
+			sheetQueue.Push(node, zIndex, static_cast<SpriteMesh*>(node)->GetLayerHandle());
+		}
+		else if (renderType == MeshType::MULTISPRITE) {
+			sheetQueue.Push(node, zIndex, static_cast<MultiSpriteMesh*>(node)->GetLayerHandle());
+		}
+		else if (renderType == MeshType::TILEMAP) {
+			sheetQueue.Push(node, zIndex, static_cast<TileMapMesh*>(node)->GetLayerHandle());
 		}
 		else {
-			buffer[zIndex].push_back(node);
+			imageQueue.Push(node, zIndex);
 		}
 	}
 }
 
+
 void Renderer::BeginRender() {
 	// set projection and clear background with black color
-	ofSetupScreenOrtho(virtualWidth, virtualHeight, -1000.0f, 1000.0f);
-	ofBackground(0);
+	backend->BeginFrame(virtualWidth, virtualHeight);
 
 	// init viewport
-	int screenWidth = ofGetWindowWidth();
-	int screenHeight = ofGetWindowHeight();
+	int screenWidth = backend->GetScreenWidth();
+	int screenHeight = backend->GetScreenHeight();
 
 	// handle custom aspect ratio
 	if (virtualWidth != screenWidth) {
-		ofViewport((screenWidth - virtualWidth) / 2, 0, (float)virtualWidth, (float)virtualHeight);
+		backend->SetViewport((screenWidth - virtualWidth) / 2, 0, (float)virtualWidth, (float)virtualHeight);
 	}
 	else if (virtualHeight != screenHeight) {
-		ofViewport(0, (screenHeight - virtualHeight) / 2, (float)virtualWidth, (float)virtualHeight);
+		backend->SetViewport(0, (screenHeight - virtualHeight) / 2, (float)virtualWidth, (float)virtualHeight);
 	}
 	else {
 		// back to actual viewport
-		ofViewport(0, 0, virtualWidth, virtualHeight);
+		backend->SetViewport(0, 0, virtualWidth, virtualHeight);
 	}
 }
 
 void Renderer::EndRender() {
-	ofVec2f screenSize = ofGetWindowSize();
+	ofVec2f screenSize = ofVec2f(backend->GetScreenWidth(), backend->GetScreenHeight());
 
-	ofLoadMatrix(ofMatrix4x4::newIdentityMatrix());
-	ofSetColor(0);
+	backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
+	backend->SetColor(ofColor(0));
 
 	// draw black rectangles that will cover oversized viewport
 	if (virtualWidth != screenSize.x) {
 		// draw left and right
-		ofViewport(0.0f, 0.0f, (screenSize.x - virtualWidth) / 2, virtualHeight);
-		ofDrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
-		ofViewport(screenSize.x - (screenSize.x - virtualWidth) / 2, 0.0f, (screenSize.x - virtualWidth) / 2, virtualHeight);
-		ofDrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
+		backend->SetViewport(0.0f, 0.0f, (screenSize.x - virtualWidth) / 2, virtualHeight);
+		backend->DrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
+		backend->SetViewport(screenSize.x - (screenSize.x - virtualWidth) / 2, 0.0f, (screenSize.x - virtualWidth) / 2, virtualHeight);
+		backend->DrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
 
 		// back to actual viewport
-		ofViewport((screenSize.x - virtualWidth) / 2, 0.0f, virtualWidth, virtualHeight);
+		backend->SetViewport((screenSize.x - virtualWidth) / 2, 0.0f, virtualWidth, virtualHeight);
 	}
 	else if (virtualHeight != screenSize.y) {
 		// draw top and bottom
-		ofViewport(0.0f, 0.0f, virtualWidth, (screenSize.y - virtualHeight) / 2);
-		ofDrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
-		ofViewport(0.0f, screenSize.y - (screenSize.y - virtualHeight) / 2, virtualWidth, (screenSize.y - virtualHeight) / 2);
-		ofDrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
+		backend->SetViewport(0.0f, 0.0f, virtualWidth, (screenSize.y - virtualHeight) / 2);
+		backend->DrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
+		backend->SetViewport(0.0f, screenSize.y - (screenSize.y - virtualHeight) / 2, virtualWidth, (screenSize.y - virtualHeight) / 2);
+		backend->DrawRectangle(0.0f, 0.0f, screenSize.x, screenSize.y);
 		// back to actual viewport
-		ofViewport((screenSize.x - virtualWidth) / 2, 0.0f, virtualWidth, virtualHeight);
+		backend->SetViewport((screenSize.x - virtualWidth) / 2, 0.0f, virtualWidth, virtualHeight);
 	}
 }
 
@@ -116,12 +179,46 @@ void Renderer::Render() {
 		}
 
 		// draw sprites
-		for (auto it = zIndexSheetBuffer.begin(); it != zIndexSheetBuffer.end(); ++it) {
+		sheetQueue.Sort();
 
-			vector<Renderable*>& arr = (*it).second;
+		// count sprites of all nodes
+		nodeFirstSprites.resize(sheetQueue.GetSize() + 1);
+		int spritesNum = 0;
+		bool instancing = backend->SupportsInstancing();
 
-			for (auto it2 = arr.begin(); it2 != arr.end(); ++it2) {
-				Renderable* node = (*it2);
+		for (int i = 0; i < sheetQueue.GetSize(); i++) {
+			Renderable* node = sheetQueue.GetNode(i);
+			nodeFirstSprites[i] = spritesNum;
+			spritesNum += GetQuadSpritesNum(node, instancing);
+		}
+
+		nodeFirstSprites[sheetQueue.GetSize()] = spritesNum;
+
+		// the main thread is one of the workers
+		int workers = workersNum >= 0 ? workersNum : max(0, (int)thread::hardware_concurrency() - 1);
+
+		if (workers > 0 && spritesNum >= SPRITE_PARALLEL_MIN_SPRITES) {
+			if (workerPool == nullptr) {
+				workerPool = new WorkerPool(workers);
+			}
+
+			RenderSpritesParallel();
+
+			// instanced multisprites and tile maps have no quads, they are drawn on top of or below their layers anyway
+			for (int i = 0; i < sheetQueue.GetSize(); i++) {
+				Renderable* node = sheetQueue.GetNode(i);
+
+				if (node->GetMeshType() == MeshType::TILEMAP) {
+					RenderTileMap(node);
+				}
+				else if (instancing && node->GetMeshType() == MeshType::MULTISPRITE && static_cast<MultiSpriteMesh*>(node)->IsInstanced()) {
+					RenderMultiSpriteInstanced(node);
+				}
+			}
+		}
+		else {
+			for (int i = 0; i < sheetQueue.GetSize(); i++) {
+				Renderable* node = sheetQueue.GetNode(i);
 
 				switch (node->GetMeshType()) {
 				case MeshType::IMAGE:
@@ -137,144 +234,185 @@ void Renderer::Render() {
 				case MeshType::MULTISPRITE:
 					RenderMultiSprite(node);
 					break;
+				case MeshType::TILEMAP:
+					RenderTileMap(node);
+					break;
 				}
 			}
 		}
 
 		// call sprite sheet renderer at the very end
-		ofLoadMatrix(ofMatrix4x4::newIdentityMatrix());
-		ofFill();
+		backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
+		backend->SetFill(true);
 		renderer->Draw();
 	}
 
 	// draw images, planes, texts and labels
-	for (auto it = zIndexImageBuffer.begin(); it != zIndexImageBuffer.end(); ++it) {
-
-		vector<Renderable*>& arr = (*it).second;
-
-		for (auto it2 = arr.begin(); it2 != arr.end(); ++it2) {
-			Renderable* node = (*it2);
-
-			switch (node->GetMeshType()) {
-			case MeshType::IMAGE:
-				RenderImage(node);
-				break;
-			case MeshType::RECTANGLE:
-				RenderRectangle(node);
-				break;
-			case MeshType::CIRCLE:
-				RenderCircle(node);
-				break;
-			case MeshType::TEXT:
-				RenderText(node);
-				break;
-			case MeshType::LABEL:
-				RenderLabel(node);
-				break;
-			case MeshType::SPRITE:
-			case MeshType::MULTISPRITE:
-				ofLogError("Trying to render sprite node with default renderer!");
-			}
+	imageQueue.Sort();
+
+	for (int i = 0; i < imageQueue.GetSize(); i++) {
+		Renderable* node = imageQueue.GetNode(i);
+		auto meshType = node->GetMeshType();
+
+		if (shapeBatchingEnabled && (meshType == MeshType::RECTANGLE || meshType == MeshType::CIRCLE)) {
+			// shapes are collected until a node of another type is drawn
+			textBatcher.Flush();
+			imageBatcher.Flush();
+			BatchShape(node);
+			continue;
+		}
+
+		if (textBatchingEnabled && (meshType == MeshType::TEXT || meshType == MeshType::LABEL)) {
+			shapeBatcher.Flush();
+			imageBatcher.Flush();
+			BatchText(node);
+			continue;
+		}
+
+		if (imageBatchingEnabled && meshType == MeshType::IMAGE) {
+			shapeBatcher.Flush();
+			textBatcher.Flush();
+			BatchImage(node);
+			continue;
+		}
+
+		// all batched shapes, texts and images lie below this node
+		shapeBatcher.Flush();
+		textBatcher.Flush();
+		imageBatcher.Flush();
+
+		switch (meshType) {
+		case MeshType::IMAGE:
+			RenderImage(node);
+			break;
+		case MeshType::RECTANGLE:
+			RenderRectangle(node);
+			break;
+		case MeshType::CIRCLE:
+			RenderCircle(node);
+			break;
+		case MeshType::TEXT:
+			RenderText(node);
+			break;
+		case MeshType::LABEL:
+			RenderLabel(node);
+			break;
+		case MeshType::SPRITE:
+		case MeshType::MULTISPRITE:
+		case MeshType::TILEMAP:
+			ofLogError("Trying to render sprite node with default renderer!");
 		}
 	}
+
+	shapeBatcher.Flush();
+	textBatcher.Flush();
+	imageBatcher.Flush();
 }
 
 void Renderer::RenderImage(Renderable* owner) {
-	// load absolute matrix
-	ofMatrix4x4 absM = owner->GetTransform().CalcAbsMatrix();
-	ofLoadMatrix(absM);
+	// load absolute matrix, calculated with the transformation
+	auto& trans = owner->GetTransform();
+	backend->LoadMatrix(trans.GetAbsMatrix().ToMatrix4x4(trans.absPos.z));
+
+	backend->SetColor(ofColor(255));
+	ImageMesh* imgShp = static_cast<ImageMesh*>(owner);
+
+	// image packed into an atlas is drawn only partially
+	backend->DrawImage(imgShp->GetImage(), imgShp->HasRegion() ? &imgShp->GetRegion() : nullptr);
+}
 
-	ofSetColor(0x000000ff);
-	ImageMesh* imgShp = dynamic_cast<ImageMesh*>(owner);
+void Renderer::BatchImage(Renderable* owner) {
+	ImageMesh* imgShp = static_cast<ImageMesh*>(owner);
 	auto image = imgShp->GetImage();
-	image->draw(0, 0);
+	auto& matrix = owner->GetTransform().GetAbsMatrix();
+
+	if (imgShp->HasRegion()) {
+		auto& region = imgShp->GetRegion();
+		imageBatcher.AddImage(&image->getTexture(), matrix, region.x, region.y, region.width, region.height);
+	}
+	else {
+		imageBatcher.AddImage(&image->getTexture(), matrix, 0, 0, image->getWidth(), image->getHeight());
+	}
 }
 
 void Renderer::RenderRectangle(Renderable* owner) {
-	FRect* rect = dynamic_cast<FRect*>(owner);
+	FRect* rect = static_cast<FRect*>(owner);
 
 	if (rect->IsRenderable()) {
-		// calc absolute matrix
-		ofMatrix4x4 absM = owner->GetTransform().CalcAbsMatrix();
-		ofLoadMatrix(absM);
-
-		ofSetColor(0x000000ff);
-
-
-		ofColor color = rect->GetColor();
-		ofSetColor(color);
-
-
-		if (rect->IsNoFill()) {
-			// render just border
-			ofNoFill();
-			ofSetLineWidth(1);
-		}
-		else {
-			ofFill();
-			ofSetLineWidth(0);
-		}
-
-		ofRect(0, 0, 0, rect->GetWidth(), rect->GetHeight());
+		// load absolute matrix, calculated with the transformation
+		auto& trans = owner->GetTransform();
+		backend->LoadMatrix(trans.GetAbsMatrix().ToMatrix4x4(trans.absPos.z));
+		backend->SetColor(rect->GetColor());
+
+		// render just border if the rectangle isn't filled
+		backend->SetFill(!rect->IsNoFill());
+		backend->DrawRectangle(0, 0, rect->GetWidth(), rect->GetHeight());
 	}
 }
 
 void Renderer::RenderCircle(Renderable* owner) {
-	FCircle* circ = dynamic_cast<FCircle*>(owner);
-	// calc absolute matrix
-	ofMatrix4x4 absM = owner->GetTransform().CalcAbsMatrix();
-	ofLoadMatrix(absM);
-
-	ofSetColor(0x000000ff);
+	FCircle* circ = static_cast<FCircle*>(owner);
+	// load absolute matrix, calculated with the transformation
+	auto& trans = owner->GetTransform();
+	backend->LoadMatrix(trans.GetAbsMatrix().ToMatrix4x4(trans.absPos.z));
+	backend->SetColor(circ->GetColor());
+	backend->SetFill(!circ->IsNoFill());
+	backend->DrawCircle(0, 0, circ->GetRadius());
+}
 
+void Renderer::BatchShape(Renderable* owner) {
+	auto& matrix = owner->GetTransform().GetAbsMatrix();
 
-	ofColor color = circ->GetColor();
-	ofSetColor(color);
+	if (owner->GetMeshType() == MeshType::RECTANGLE) {
+		FRect* rect = static_cast<FRect*>(owner);
+		if (rect->IsRenderable()) {
+			shapeBatcher.AddRect(matrix, rect->GetWidth(), rect->GetHeight(), rect->GetColor(), rect->IsNoFill());
+		}
+	}
+	else {
+		FCircle* circ = static_cast<FCircle*>(owner);
+		shapeBatcher.AddCircle(matrix, circ->GetRadius(), circ->GetColor(), circ->IsNoFill());
+	}
+}
 
+void Renderer::BatchText(Renderable* owner) {
+	auto& trans = owner->GetTransform();
 
-	if (circ->IsNoFill()) {
-		ofNoFill();
-		ofSetLineWidth(1);
+	if (owner->GetMeshType() == MeshType::TEXT) {
+		auto shape = static_cast<Text*>(owner);
+		textBatcher.AddText(shape->GetFont(), trans.GetAbsMatrix(), shape->GetGlyphs(), shape->GetColor());
 	}
 	else {
-		ofFill();
-		ofSetLineWidth(0);
+		// label doesn't depend on transform, only on its absolute position
+		auto shape = static_cast<Label*>(owner);
+		int firstLine = shape->GetFirstVisibleLine(backend->GetScreenHeight() - trans.absPos.y);
+		AffineMatrix matrix;
+		matrix.tx = trans.absPos.x;
+		matrix.ty = trans.absPos.y;
+		textBatcher.AddText(shape->GetFont(), matrix, shape->GetLineGlyphs(firstLine), shape->GetColor());
 	}
-
-	ofCircle(0, 0, circ->GetRadius());
 }
 
 void Renderer::RenderText(Renderable* owner) {
-	// load absolute matrix
-	ofMatrix4x4 absM = owner->GetTransform().CalcAbsMatrix();
-	ofLoadMatrix(absM);
-	auto shape = dynamic_cast<Text*>(owner);
-	ofSetColor(shape->GetColor());
+	// load absolute matrix, calculated with the transformation
+	auto& trans = owner->GetTransform();
+	backend->LoadMatrix(trans.GetAbsMatrix().ToMatrix4x4(trans.absPos.z));
+	auto shape = static_cast<Text*>(owner);
+	backend->SetColor(shape->GetColor());
 
 	ofTrueTypeFont* font = shape->GetFont();
-	font->drawString(shape->GetText(), 0, font->getLineHeight() / 2);
+	backend->DrawString(font, shape->GetText(), 0, font->getLineHeight() / 2);
 }
 
 void Renderer::RenderSprite(Renderable* owner) {
 
-	auto shape = dynamic_cast<SpriteMesh*>(owner);
+	auto shape = static_cast<SpriteMesh*>(owner);
 	Sprite& sprite = shape->GetSprite();
 	Trans& trans = owner->GetTransform();
-	renderer->SetActualBuffer(shape->GetLayerName());
+	renderer->SetActualBuffer(shape->GetLayerHandle());
 
 	// fill tile with  data and send it to the sprite manager
-	spriteTile.width = sprite.GetWidth();
-	spriteTile.height = sprite.GetHeight();
-	spriteTile.offsetX = sprite.GetOffsetX();
-	spriteTile.offsetY = sprite.GetOffsetY();
-
-	spriteTile.posX = trans.absPos.x + trans.absScale.x*spriteTile.width / 2.0f;  // [0,0] is topleft corner
-	spriteTile.posY = trans.absPos.y + trans.absScale.y*spriteTile.height / 2.0f;
-	spriteTile.posZ = trans.absPos.z;
-	spriteTile.rotation = trans.rotation*DEG_TO_RAD;
-	spriteTile.scaleX = trans.absScale.x;
-	spriteTile.scaleY = trans.absScale.y;
-
+	FillSpriteTile(sprite, trans, spriteTile);
 	renderer->AddTile(spriteTile);
 }
 
@@ -283,34 +421,356 @@ void Renderer::RenderMultiSprite(Renderable* owner) {
 	// Multi-sprites are clear choice when drawing thousands of objects, because they 
 	// are all rendered at once 
 
-	auto shape = dynamic_cast<MultiSpriteMesh*>(owner);
-	renderer->SetActualBuffer(shape->GetLayerName());
+	auto shape = static_cast<MultiSpriteMesh*>(owner);
+
+	if (shape->IsInstanced() && backend->SupportsInstancing()) {
+		RenderMultiSpriteInstanced(owner);
+		return;
+	}
+
+	renderer->SetActualBuffer(shape->GetLayerHandle());
 
 	auto& sprites = shape->GetSprites();
 	Trans& ownerTransform = owner->GetTransform();
 
-	// calc absolute transform
+	// calc absolute transform, only for sprites that have moved or whose owner has moved
 	for (int i = 0; i < sprites.size(); i++) {
-		sprites[i]->GetTransform().CalcAbsTransform(ownerTransform);
+		Trans& trans = sprites[i]->GetTransform();
+		if (!trans.IsAbsTransformValid(ownerTransform)) {
+			trans.CalcAbsTransform(ownerTransform);
+		}
 	}
 
+	spriteTiles.resize(sprites.size());
+	int tilesNum = 0;
+
 	for (int i = 0; i < sprites.size(); i++) {
 		Sprite* sprite = sprites[i];
-		Trans& trans = sprite->GetTransform();
+		SpriteTile& tile = spriteTiles[tilesNum];
+		FillSpriteTile(*sprite, sprite->GetTransform(), tile);
 
-		spriteTile.width = sprite->GetWidth();
-		spriteTile.height = sprite->GetHeight();
-		spriteTile.offsetX = sprite->GetOffsetX();
-		spriteTile.offsetY = sprite->GetOffsetY();
+		// the whole multisprite can't be culled, but its sprites can
+		if (cullingEnabled && !IsTileInViewport(tile)) {
+			culledSprites++;
+		}
+		else {
+			tilesNum++;
+		}
+	}
+
+	// all sprites are added at once, their corners are calculated in batches
+	if (tilesNum != 0) {
+		renderer->AddTiles(spriteTiles.data(), tilesNum);
+	}
+}
 
-		spriteTile.posX = trans.absPos.x + trans.absScale.x*spriteTile.width / 2.0f;  // [0,0] is topleft corner
-		spriteTile.posY = trans.absPos.y + trans.absScale.y*spriteTile.height / 2.0f;
-		spriteTile.posZ = trans.absPos.z;
-		spriteTile.rotation = trans.rotation*DEG_TO_RAD;
-		spriteTile.scaleX = trans.absScale.x;
-		spriteTile.scaleY = trans.absScale.y;
+void Renderer::RenderMultiSpriteInstanced(Renderable* owner) {
+	auto shape = static_cast<MultiSpriteMesh*>(owner);
+	renderer->SetActualBuffer(shape->GetLayerHandle());
+	SpriteInstanceBuffer& instances = shape->GetInstanceBuffer();
+
+	if (!shape->AreStaticInstancesValid()) {
+		auto& sprites = shape->GetSprites();
+		Trans& ownerTransform = owner->GetTransform();
+		spriteTiles.resize(sprites.size());
+		spriteInstances.resize(sprites.size());
+
+		for (int i = 0; i < (int)sprites.size(); i++) {
+			Trans& trans = sprites[i]->GetTransform();
+			if (!trans.IsAbsTransformValid(ownerTransform)) {
+				trans.CalcAbsTransform(ownerTransform);
+			}
+
+			// sprites aren't culled, the instances would differ each time the view moves
+			FillSpriteTile(*sprites[i], trans, spriteTiles[i]);
+		}
 
-		renderer->AddTile(spriteTile);
+		// only instances that differ from those of the previous frame will be uploaded
+		renderer->MakeInstances(spriteInstances.data(), spriteTiles.data(), sprites.size());
+		instances.Update(spriteInstances.data(), sprites.size());
+		shape->ValidateInstances();
+	}
+
+	renderer->AddInstances(&instances);
+}
+
+void Renderer::RenderTileMap(Renderable* owner) {
+	auto map = static_cast<TileMapMesh*>(owner);
+	renderer->SetActualBuffer(map->GetLayerHandle());
+
+	// chunks are baked in absolute coordinates, hence all of them have to be baked again when the map moves
+	if (!map->AreChunksPlaced()) {
+		map->PlaceChunks();
+
+		if (map->GetTransform().absRotation != 0) {
+			// tiles are baked axis-aligned, the error is reported only once for each transformation
+			ofLogError("Renderer", "Tile maps can't be rotated, the map won't be drawn!");
+		}
+	}
+
+	if (map->GetTransform().absRotation != 0) {
+		return;
+	}
+
+	for (int i = 0; i < map->GetChunksNum(); i++) {
+		SpriteChunk* chunk = map->GetChunk(i);
+
+		if (!chunk->isBaked) {
+			BakeChunk(map, i);
+		}
+
+		if (cullingEnabled && !chunk->quads.empty() && !IsInViewport(chunk->bounds)) {
+			culledSprites += chunk->quads.size();
+		}
+		else {
+			renderer->AddChunk(chunk);
+		}
+	}
+}
+
+void Renderer::BakeChunk(TileMapMesh* map, int chunkIndex) {
+	SpriteChunk* chunk = map->GetChunk(chunkIndex);
+	Trans& trans = map->GetTransform();
+	int firstColumn = (chunkIndex % map->GetChunkColumns()) * TILEMAP_CHUNK_SIZE;
+	int firstRow = (chunkIndex / map->GetChunkColumns()) * TILEMAP_CHUNK_SIZE;
+	int lastColumn = min(firstColumn + TILEMAP_CHUNK_SIZE, map->GetColumns());
+	int lastRow = min(firstRow + TILEMAP_CHUNK_SIZE, map->GetRows());
+
+	// offsets of a frame are calculated only when the frame differs from the previous tile
+	Sprite sprite(map->GetSpriteSheet(), 0);
+	spriteTiles.clear();
+
+	for (int row = firstRow; row < lastRow; row++) {
+		for (int column = firstColumn; column < lastColumn; column++) {
+			int frame = map->GetTile(column, row);
+
+			if (frame < 0) {
+				continue;
+			}
+
+			if (frame != sprite.GetFrame()) {
+				sprite.SetFrame(frame);
+			}
+
+			SpriteTile tile;
+			tile.width = sprite.GetWidth();
+			tile.height = sprite.GetHeight();
+			tile.offsetX = sprite.GetOffsetX();
+			tile.offsetY = sprite.GetOffsetY();
+
+			// the same as a sprite of a multisprite placed at the tile, see FillSpriteTile
+			float tileX = (column * map->GetTileWidth()) * trans.absScale.x + trans.absPos.x;
+			float tileY = (row * map->GetTileHeight()) * trans.absScale.y + trans.absPos.y;
+			tile.posX = tileX + trans.absScale.x*tile.width / 2.0f;
+			tile.posY = tileY + trans.absScale.y*tile.height / 2.0f;
+			tile.posZ = trans.absPos.z;
+			tile.scaleX = trans.absScale.x;
+			tile.scaleY = trans.absScale.y;
+			spriteTiles.push_back(tile);
+		}
+	}
+
+	chunk->quads.resize(spriteTiles.size());
+	renderer->MakeQuads(chunk->quads.data(), spriteTiles.data(), spriteTiles.size());
+
+	// bounds of the quads, so that the whole chunk can be culled
+	if (!chunk->quads.empty()) {
+		ofVec2f boundsMin = ofVec2f(chunk->quads[0].vertices[0].x, chunk->quads[0].vertices[0].y);
+		ofVec2f boundsMax = boundsMin;
+
+		for (auto& quad : chunk->quads) {
+			for (auto& vertex : quad.vertices) {
+				boundsMin.x = min(boundsMin.x, vertex.x);
+				boundsMin.y = min(boundsMin.y, vertex.y);
+				boundsMax.x = max(boundsMax.x, vertex.x);
+				boundsMax.y = max(boundsMax.y, vertex.y);
+			}
+		}
+
+		chunk->bounds.topLeft = boundsMin;
+		chunk->bounds.topRight = ofVec2f(boundsMax.x, boundsMin.y);
+		chunk->bounds.bottomLeft = ofVec2f(boundsMin.x, boundsMax.y);
+		chunk->bounds.bottomRight = boundsMax;
+	}
+
+	chunk->isBaked = true;
+	chunk->isDirty = true;
+}
+
+void Renderer::RenderSpritesParallel() {
+	int spritesNum = nodeFirstSprites.back();
+	int chunksNum = (spritesNum + SPRITE_CHUNK_SIZE - 1) / SPRITE_CHUNK_SIZE;
+	int layersNum = renderer->GetLayerHandlesNum();
+
+	spriteTiles.resize(spritesNum);
+	tileLayers.resize(spritesNum);
+	chunkTiles.assign(chunksNum, 0);
+	chunkCulled.assign(chunksNum, 0);
+	chunkLayerTiles.assign(chunksNum * layersNum, 0);
+	chunkLayerOffsets.assign(chunksNum * layersNum, 0);
+	layerFirstSprites.assign(layersNum, 0);
+	layerSprites.assign(layersNum, 0);
+
+	// 1) tiles of all chunks
+	workerPool->Run(chunksNum, [this, layersNum](int chunk) {
+		FillChunkTiles(chunk, layersNum);
+	});
+
+	// 2) prefix sums of tiles of each layer over the chunks
+	for (int layer = 0; layer < layersNum; layer++) {
+		int total = 0;
+
+		for (int chunk = 0; chunk < chunksNum; chunk++) {
+			chunkLayerOffsets[chunk * layersNum + layer] = total;
+			total += chunkLayerTiles[chunk * layersNum + layer];
+		}
+
+		if (total != 0) {
+			int first = renderer->AppendSprites(layer, total);
+			layerFirstSprites[layer] = first;
+			layerSprites[layer] = total;
+
+			for (int chunk = 0; chunk < chunksNum; chunk++) {
+				chunkLayerOffsets[chunk * layersNum + layer] += first;
+			}
+		}
+	}
+
+	for (int chunk = 0; chunk < chunksNum; chunk++) {
+		culledSprites += chunkCulled[chunk];
+	}
+
+	// 3) quads of all chunks, written directly into the layers
+	chunkLayerDirty.resize(chunksNum * layersNum * 2);
+	for (int i = 0; i < (int)chunkLayerDirty.size(); i += 2) {
+		chunkLayerDirty[i] = INT_MAX;
+		chunkLayerDirty[i + 1] = 0;
+	}
+
+	workerPool->Run(chunksNum, [this, layersNum](int chunk) {
+		WriteChunkQuads(chunk, layersNum);
+	});
+
+	// 4) changed sprites of each layer
+	for (int layer = 0; layer < layersNum; layer++) {
+		if (layerSprites[layer] != 0) {
+			int dirtyFrom = INT_MAX;
+			int dirtyTo = 0;
+
+			for (int chunk = 0; chunk < chunksNum; chunk++) {
+				int index = (chunk * layersNum + layer) * 2;
+				dirtyFrom = min(dirtyFrom, chunkLayerDirty[index]);
+				dirtyTo = max(dirtyTo, chunkLayerDirty[index + 1]);
+			}
+
+			renderer->EndAppendedSprites(layer, layerFirstSprites[layer], layerSprites[layer], dirtyFrom, max(dirtyFrom, dirtyTo));
+		}
+	}
+}
+
+void Renderer::FillChunkTiles(int chunk, int layersNum) {
+	int first = chunk * SPRITE_CHUNK_SIZE;
+	int last = min(first + SPRITE_CHUNK_SIZE, nodeFirstSprites.back());
+	int* layerTiles = &chunkLayerTiles[chunk * layersNum];
+	// visible tiles are moved to the beginning of the chunk
+	int tilesNum = first;
+	int culled = 0;
+
+	// node that contains the first sprite of the chunk
+	int node = upper_bound(nodeFirstSprites.begin(), nodeFirstSprites.end(), first) - nodeFirstSprites.begin() - 1;
+
+	for (int index = first; index < last; node++) {
+		Renderable* owner = sheetQueue.GetNode(node);
+		int nodeLast = min(nodeFirstSprites[node + 1], last);
+
+		if (owner->GetMeshType() == MeshType::SPRITE) {
+			auto shape = static_cast<SpriteMesh*>(owner);
+			int layer = shape->GetLayerHandle();
+
+			// sprites of layers that haven't been loaded are skipped, as AddTile does
+			SpriteLayer* spriteLayer = renderer->GetLayer(layer);
+			if (spriteLayer != nullptr && spriteLayer->texture != nullptr) {
+				FillSpriteTile(shape->GetSprite(), owner->GetTransform(), spriteTiles[tilesNum]);
+				tileLayers[tilesNum++] = layer;
+				layerTiles[layer]++;
+			}
+		}
+		else if (owner->GetMeshType() == MeshType::MULTISPRITE) {
+			auto shape = static_cast<MultiSpriteMesh*>(owner);
+			int layer = shape->GetLayerHandle();
+			auto& sprites = shape->GetSprites();
+			Trans& ownerTransform = owner->GetTransform();
+
+			SpriteLayer* spriteLayer = renderer->GetLayer(layer);
+			bool isLoaded = spriteLayer != nullptr && spriteLayer->texture != nullptr;
+
+			for (int i = index - nodeFirstSprites[node]; isLoaded && i < nodeLast - nodeFirstSprites[node]; i++) {
+				// only this task calculates transform of the sprite
+				Trans& trans = sprites[i]->GetTransform();
+				if (!trans.IsAbsTransformValid(ownerTransform)) {
+					trans.CalcAbsTransform(ownerTransform);
+				}
+
+				SpriteTile& tile = spriteTiles[tilesNum];
+				FillSpriteTile(*sprites[i], trans, tile);
+
+				if (cullingEnabled && !IsTileInViewport(tile)) {
+					culled++;
+				}
+				else {
+					tileLayers[tilesNum++] = layer;
+					layerTiles[layer]++;
+				}
+			}
+		}
+
+		index = nodeLast;
+	}
+
+	chunkTiles[chunk] = tilesNum - first;
+	chunkCulled[chunk] = culled;
+}
+
+void Renderer::WriteChunkQuads(int chunk, int layersNum) {
+	int first = chunk * SPRITE_CHUNK_SIZE;
+	int last = first + chunkTiles[chunk];
+	int* offsets = &chunkLayerOffsets[chunk * layersNum];
+	int* dirty = &chunkLayerDirty[chunk * layersNum * 2];
+	bool compare = renderer->IsGpuBuffersEnabled();
+	// data of overwritten sprites, one buffer per thread
+	static thread_local vector<SpriteQuad> previousQuads;
+
+	// consecutive tiles of the same layer are written at once
+	for (int run = first; run < last;) {
+		int layerHandle = tileLayers[run];
+		int runLast = run + 1;
+		while (runLast < last && tileLayers[runLast] == layerHandle) {
+			runLast++;
+		}
+
+		int count = runLast - run;
+		int offset = offsets[layerHandle];
+		offsets[layerHandle] += count;
+		SpriteLayer* layer = renderer->GetLayer(layerHandle);
+		SpriteQuad* quads = &layer->quads[offset];
+
+		if (compare) {
+			int compared = max(0, min(count, layer->writtenSprites - offset));
+			previousQuads.assign(quads, quads + compared);
+			renderer->MakeQuads(quads, &spriteTiles[run], count);
+
+			for (int i = 0; i < count; i++) {
+				if (i >= compared || memcmp(&previousQuads[i], &quads[i], sizeof(SpriteQuad)) != 0) {
+					dirty[layerHandle * 2] = min(dirty[layerHandle * 2], offset + i);
+					dirty[layerHandle * 2 + 1] = max(dirty[layerHandle * 2 + 1], offset + i + 1);
+				}
+			}
+		}
+		else {
+			renderer->MakeQuads(quads, &spriteTiles[run], count);
+		}
+
+		run = runLast;
 	}
 }
 
@@ -319,41 +779,43 @@ void Renderer::RenderLabel(Renderable* owner) {
 	auto& trans = owner->GetTransform();
 
 	// label doesn't depend on transform !
-	ofLoadMatrix(ofMatrix4x4::newIdentityMatrix());
+	backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
 
-	auto shape = dynamic_cast<Label*>(owner);
-	ofSetColor(shape->GetColor());
+	auto shape = static_cast<Label*>(owner);
+	backend->SetColor(shape->GetColor());
 
 	auto font = shape->GetFont();
 
-	vector<string> textLines;
-	ofRectangle textBounds = ofRectangle();
-	// use absolute positions
-	ofRectangle drawBounds = ofRectangle(trans.absPos.x, trans.absPos.y, shape->GetLabelWidth(), ofGetWindowHeight() - trans.absPos.y);
-	ofxTextLabel::stringToLines(*font, shape->GetText(), drawBounds.width, textLines, textBounds);
-	auto text = shape->GetText();
-
-	// draw lines one by one and calculate offsets for each line
-	float lineX, lineY;
-	lineX = drawBounds.x;
-	lineY = drawBounds.y;
-	int counter = 0;
-
-	// a little hack -> measure height of the text according to the height of "Ay" word that should cover all possible letters
-	int lineHeight = font->stringHeight("Ay");
-	int linesToDraw = (drawBounds.height / (1.5f*lineHeight));
-	int startingIndex = textLines.size() - linesToDraw;
-	if (startingIndex < 0) startingIndex = 0;
+	// lines are wrapped by the label only when its text changes
+	auto& textLines = shape->GetLines();
+	int startingIndex = shape->GetFirstVisibleLine(backend->GetScreenHeight() - trans.absPos.y);
+
+	// draw lines one by one and calculate offsets for each line, using absolute positions
+	float lineX = trans.absPos.x;
+	float lineY = trans.absPos.y;
 
 	// draw only lines that should be drawn
-	for (auto it = (textLines.begin() + startingIndex); it != textLines.end(); ++it) {
-		if (counter++ == 0) {
-			lineY += font->stringHeight("Ay");  // easiest way to get ascender height.
+	for (int i = startingIndex; i < (int)textLines.size(); i++) {
+		if (i == startingIndex) {
+			lineY += shape->GetTextHeight();  // easiest way to get ascender height.
 		}
 		else {
 			lineY += font->getLineHeight();
 		}
 
-		font->drawString(*it, lineX, lineY);
+		backend->DrawString(font, textLines[i], lineX, lineY);
 	}
+}
+
+bool Renderer::IsTileInViewport(const SpriteTile& tile) const {
+	float extentX = abs(tile.scaleX * tile.width / 2);
+	float extentY = abs(tile.scaleY * tile.height / 2);
+
+	if (tile.rotation != 0) {
+		// rotated tile lies within a circle around its center
+		extentX = extentY = sqrt(extentX * extentX + extentY * extentY);
+	}
+
+	return tile.posX + extentX >= 0 && tile.posX - extentX <= virtualWidth
+		&& tile.posY + extentY >= 0 && tile.posY - extentY <= virtualHeight;
 }
\ No newline at end of file
@@ -3,8 +3,18 @@
 
 #include "SpriteSheetRenderer.h"
 #include "Renderable.h"
+#include "RenderQueue.h"
+#include "ShapeBatcher.h"
+#include "TextBatcher.h"
+#include "ImageBatcher.h"
+#include "WorkerPool.h"
+#include "GLRenderBackend.h"
 #include "AphMain.h"
 
+// number of sprites whose quads are generated by one task of the worker pool
+#define SPRITE_CHUNK_SIZE 2048
+// minimal number of sprites in a frame for which the quads are generated in parallel
+#define SPRITE_PARALLEL_MIN_SPRITES 8192
 
 /**
 * Rendering engine using a sprite sheet manager
@@ -12,30 +22,76 @@
 class Renderer {
 
 protected:
-	// buffer for z-indices of nodes that will be rendered a standard way
-	map<int, vector<Renderable*>> zIndexImageBuffer;
-	// buffer for z-indices of nodes that will be rendered using the SpriteSheetRenderer
-	map<int, vector<Renderable*>> zIndexSheetBuffer;
+	// queue of nodes that will be rendered a standard way
+	RenderQueue imageQueue;
+	// queue of nodes that will be rendered using the SpriteSheetRenderer
+	RenderQueue sheetQueue;
 
 	SpriteSheetRenderer* renderer = nullptr;
+	// graphics API everything is drawn by, not owned by the renderer
+	RenderBackend* backend = GLRenderBackend::GetInstance();
 	// tile regularly filled with data and sent to sprite sheet renderer
 	SpriteTile spriteTile;
+	// tiles of a multisprite, sent to sprite sheet renderer in one batch
+	vector<SpriteTile> spriteTiles;
+	// instances of an instanced multisprite, compared with those of the previous frame
+	vector<SpriteInstance> spriteInstances;
 	// layers used in sprite sheet renderer
 	vector<string> rendererLayers;
+	// rectangles and circles drawn in batches
+	ShapeBatcher shapeBatcher;
+	bool shapeBatchingEnabled = true;
+	// texts and labels drawn in batches, using glyph atlases of their fonts
+	TextBatcher textBatcher;
+	bool textBatchingEnabled = true;
+	// images drawn in batches, mostly parts of sprite atlases
+	ImageBatcher imageBatcher;
+	bool imageBatchingEnabled = true;
 	int virtualWidth = 0;
 	int virtualHeight = 0;
+	// indicator whether nodes out of the virtual viewport are skipped
+	bool cullingEnabled = true;
+	// statistics of the current frame
+	int culledNodes = 0;
+	int drawnNodes = 0;
+	int culledSprites = 0;
+
+	// threads generating quads of sprites, created when a frame has enough sprites
+	WorkerPool* workerPool = nullptr;
+	// number of threads besides the main one, -1 for one less than the number of cores
+	int workersNum = -1;
+	// index of the first sprite of each node of the sheet queue, followed by the total number of sprites
+	vector<int> nodeFirstSprites;
+	// handle of the layer of each tile in spriteTiles; tiles of each chunk are compacted to its beginning
+	vector<int> tileLayers;
+	// number of tiles of each chunk that haven't been culled
+	vector<int> chunkTiles;
+	vector<int> chunkCulled;
+	// number of tiles of each chunk in each layer, and their index in the layer
+	vector<int> chunkLayerTiles;
+	vector<int> chunkLayerOffsets;
+	// range of changed sprites of each chunk in each layer, two values per layer
+	vector<int> chunkLayerDirty;
+	// first sprite and number of sprites added into each layer by the parallel pass
+	vector<int> layerFirstSprites;
+	vector<int> layerSprites;
 
 public:
 	Renderer() {
 	}
 
+	~Renderer() {
+		delete renderer;
+		delete workerPool;
+	}
+
 	void OnInit();
 
 	/**
 	* Adds a new tile layer for sprite sheet renderer
 	* @param img layer image
 	* @param name name of the layer
-	* @param bufferSize maximum number of sprites in the layer
+	* @param bufferSize initial number of sprites in the layer, the layer grows when more sprites are drawn
 	* @param zindex absolute z-index of the layer
 	*/
 	void AddTileLayer(ofImage* img, string name, int bufferSize, int zindex);
@@ -46,7 +102,7 @@ public:
 	void RemoveTileLayer(string name);
 
 	/**
-	* Clears all sprite buffers
+	* Clears all render queues
 	*/
 	void ClearBuffers();
 
@@ -54,12 +110,147 @@ public:
 		return renderer;
 	}
 
+	/**
+	* Sets backend that draws everything, e.g. a software backend for headless benchmarks
+	* The backend isn't owned by the renderer and it has to outlive it
+	*/
+	void SetBackend(RenderBackend* backend);
+
+	RenderBackend* GetBackend() const {
+		return backend;
+	}
+
 	/**
 	* Pushes node that will be later rendered
 	* together will all other nodes
+	* Nodes whose draw bounds don't overlap the virtual viewport are culled
 	*/
 	void PushNode(Renderable* node);
 
+	/**
+	* Returns true, if given area overlaps the virtual viewport
+	*/
+	bool IsInViewport(const BoundingBox& bounds) const {
+		return bounds.bottomRight.x >= 0 && bounds.topLeft.x <= virtualWidth
+			&& bounds.bottomRight.y >= 0 && bounds.topLeft.y <= virtualHeight;
+	}
+
+	/**
+	* Culls a whole subtree of the scene if its bounds don't overlap the virtual viewport;
+	* its nodes are then recorded as culled without being pushed
+	* @param hasBounds whether the subtree has any bounds, a subtree without them is never culled
+	* @param visibleNodes number of visible nodes of the subtree
+	* @return true, if the subtree has been culled and none of its nodes should be pushed
+	*/
+	bool CullSubtree(bool hasBounds, const BoundingBox& bounds, int visibleNodes) {
+		if (!cullingEnabled || !hasBounds || IsInViewport(bounds)) {
+			return false;
+		}
+
+		culledNodes += visibleNodes;
+		return true;
+	}
+
+	/**
+	* Gets batcher of rectangles and circles, e.g. for its statistics
+	*/
+	const ShapeBatcher& GetShapeBatcher() const {
+		return shapeBatcher;
+	}
+
+	bool IsShapeBatchingEnabled() const {
+		return shapeBatchingEnabled;
+	}
+
+	/**
+	* Enables or disables batching of rectangles and circles; if disabled, each shape is drawn separately
+	*/
+	void SetShapeBatchingEnabled(bool enabled) {
+		this->shapeBatchingEnabled = enabled;
+	}
+
+	/**
+	* Gets batcher of texts and labels, e.g. for its statistics
+	*/
+	const TextBatcher& GetTextBatcher() const {
+		return textBatcher;
+	}
+
+	bool IsTextBatchingEnabled() const {
+		return textBatchingEnabled;
+	}
+
+	/**
+	* Enables or disables batching of texts and labels; if disabled, each text is drawn by its font
+	*/
+	void SetTextBatchingEnabled(bool enabled) {
+		this->textBatchingEnabled = enabled;
+	}
+
+	/**
+	* Gets batcher of images, e.g. for its statistics
+	*/
+	const ImageBatcher& GetImageBatcher() const {
+		return imageBatcher;
+	}
+
+	bool IsImageBatchingEnabled() const {
+		return imageBatchingEnabled;
+	}
+
+	/**
+	* Enables or disables batching of images; if disabled, each image is drawn separately
+	*/
+	void SetImageBatchingEnabled(bool enabled) {
+		this->imageBatchingEnabled = enabled;
+	}
+
+	bool IsCullingEnabled() const {
+		return cullingEnabled;
+	}
+
+	void SetCullingEnabled(bool enabled) {
+		this->cullingEnabled = enabled;
+	}
+
+	/**
+	* Gets number of visible nodes culled in the current frame
+	*/
+	int GetCulledNodes() const {
+		return culledNodes;
+	}
+
+	/**
+	* Gets number of nodes pushed in the current frame
+	*/
+	int GetDrawnNodes() const {
+		return drawnNodes;
+	}
+
+	/**
+	* Gets number of sprites of multisprites culled in the current frame
+	*/
+	int GetCulledSprites() const {
+		return culledSprites;
+	}
+
+	/**
+	* Sets number of worker threads that generate quads of sprites together with the main thread
+	* Quads are generated in parallel only if a frame has at least SPRITE_PARALLEL_MIN_SPRITES sprites
+	* @param workersNum number of threads besides the main one, 0 if the main thread should generate everything,
+	* -1 for one less than the number of cores
+	*/
+	void SetWorkersNum(int workersNum) {
+		this->workersNum = workersNum;
+		// the pool is created again with the new number of threads
+		delete workerPool;
+		workerPool = nullptr;
+	}
+
+	int GetWorkersNum() const {
+		return workersNum;
+	}
+
 	/**
 	* Begins the rendering procedure
 	*/
@@ -98,6 +289,11 @@ protected:
 	*/
 	void RenderImage(Renderable* owner);
 
+	/**
+	* Adds an image into the image batch
+	*/
+	void BatchImage(Renderable* owner);
+
 	/**
 	* Renders a rectangle
 	*/
@@ -108,11 +304,21 @@ protected:
 	*/
 	void RenderCircle(Renderable* owner);
 
+	/**
+	* Adds a rectangle or a circle into the shape batch
+	*/
+	void BatchShape(Renderable* owner);
+
 	/**
 	* Renders a text
 	*/
 	void RenderText(Renderable* owner);
 
+	/**
+	* Adds a text or a label into the text batch
+	*/
+	void BatchText(Renderable* owner);
+
 	/**
 	* Renders a sprite
 	*/
@@ -123,8 +329,46 @@ protected:
 	*/
 	void RenderMultiSprite(Renderable* owner);
 
+	/**
+	* Renders a multisprite by instancing; instances of a static multisprite are made only when it changes
+	*/
+	void RenderMultiSpriteInstanced(Renderable* owner);
+
+	/**
+	* Renders visible chunks of a tile map, baking those whose tiles have changed
+	*/
+	void RenderTileMap(Renderable* owner);
+
+	/**
+	* Creates quads of all tiles of a chunk of a tile map, in absolute coordinates
+	*/
+	void BakeChunk(TileMapMesh* map, int chunkIndex);
+
 	/**
 	* Renders a label (text that is not affected by transformations)
 	*/
 	void RenderLabel(Renderable* owner);
+
+	/**
+	* Generates quads of all sprites in the sheet queue by the worker pool
+	* Each task fills and culls tiles of one chunk of sprites; the tiles of each layer are then placed
+	* one after another by prefix sums over the chunks, so that the tasks can write their quads directly
+	* into the layers in the same order as if they were added one by one
+	*/
+	void RenderSpritesParallel();
+
+	/**
+	* Fills, culls and compacts tiles of one chunk of sprites
+	*/
+	void FillChunkTiles(int chunk, int layersNum);
+
+	/**
+	* Writes quads of visible tiles of one chunk into their layers
+	*/
+	void WriteChunkQuads(int chunk, int layersNum);
+
+	/**
+	* Returns true, if a sprite tile overlaps the virtual viewport
+	*/
+	bool IsTileInViewport(const SpriteTile& tile) const;
 };
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "ShapeBatcher.h"
+#include "GLRenderBackend.h"
+#include <cmath>
+
+ShapeBatcher::ShapeBatcher() : backend(GLRenderBackend::GetInstance()) {
+	for (int i = 0; i < SHAPE_CIRCLE_SEGMENTS; i++) {
+		float angle = TWO_PI * i / SHAPE_CIRCLE_SEGMENTS;
+		circleCos[i] = cos(angle);
+		circleSin[i] = sin(angle);
+	}
+}
+
+void ShapeBatcher::AddRect(const AffineMatrix& matrix, float width, float height, const ofColor& color, bool noFill) {
+	ofVec2f corners[4] = { matrix.Transform(0, 0), matrix.Transform(width, 0),
+		matrix.Transform(0, height), matrix.Transform(width, height) };
+	shapesNum++;
+
+	if (noFill) {
+		AddLine(corners[0], corners[1], color);
+		AddLine(corners[1], corners[3], color);
+		AddLine(corners[3], corners[2], color);
+		AddLine(corners[2], corners[0], color);
+	}
+	else {
+		// two triangles, the same as sprite quads
+		ShapeVertex* vertex = AddVertices(6);
+		SetVertex(vertex[0], corners[0], color);
+		SetVertex(vertex[1], corners[1], color);
+		SetVertex(vertex[2], corners[2], color);
+		SetVertex(vertex[3], corners[1], color);
+		SetVertex(vertex[4], corners[2], color);
+		SetVertex(vertex[5], corners[3], color);
+	}
+}
+
+void ShapeBatcher::AddCircle(const AffineMatrix& matrix, float radius, const ofColor& color, bool noFill) {
+	ofVec2f points[SHAPE_CIRCLE_SEGMENTS];
+	for (int i = 0; i < SHAPE_CIRCLE_SEGMENTS; i++) {
+		points[i] = matrix.Transform(radius * circleCos[i], radius * circleSin[i]);
+	}
+	shapesNum++;
+
+	if (noFill) {
+		for (int i = 0; i < SHAPE_CIRCLE_SEGMENTS; i++) {
+			AddLine(points[i], points[(i + 1) % SHAPE_CIRCLE_SEGMENTS], color);
+		}
+	}
+	else {
+		// triangle fan around the center, split into separate triangles
+		ofVec2f center = matrix.Transform(0, 0);
+		ShapeVertex* vertex = AddVertices(SHAPE_CIRCLE_SEGMENTS * 3);
+		for (int i = 0; i < SHAPE_CIRCLE_SEGMENTS; i++) {
+			SetVertex(*vertex++, center, color);
+			SetVertex(*vertex++, points[i], color);
+			SetVertex(*vertex++, points[(i + 1) % SHAPE_CIRCLE_SEGMENTS], color);
+		}
+	}
+}
+
+void ShapeBatcher::Flush() {
+	if (vertices.empty()) {
+		return;
+	}
+
+	backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
+	backend->DrawShapes(vertices.data(), vertices.size());
+	drawCalls++;
+	vertices.clear();
+}
+
+ShapeVertex* ShapeBatcher::AddVertices(int count) {
+	int first = vertices.size();
+	vertices.resize(first + count);
+	return &vertices[first];
+}
+
+void ShapeBatcher::AddLine(const ofVec2f& start, const ofVec2f& end, const ofColor& color) {
+	ofVec2f direction = end - start;
+	float length = direction.length();
+
+	if (length == 0) {
+		return;
+	}
+
+	// half a unit to both sides and beyond both ends, hence the corners of outlines are closed
+	direction *= 0.5f / length;
+	ofVec2f normal = ofVec2f(-direction.y, direction.x);
+	ofVec2f first = start - direction;
+	ofVec2f last = end + direction;
+
+	ShapeVertex* vertex = AddVertices(6);
+	SetVertex(vertex[0], first + normal, color);
+	SetVertex(vertex[1], last + normal, color);
+	SetVertex(vertex[2], first - normal, color);
+	SetVertex(vertex[3], last + normal, color);
+	SetVertex(vertex[4], first - normal, color);
+	SetVertex(vertex[5], last - normal, color);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include "ofColor.h"
+#include "AffineMatrix.h"
+
+using namespace std;
+
+class RenderBackend;
+
+// number of segments of tessellated circles, the same as the default circle resolution of openFrameworks
+#define SHAPE_CIRCLE_SEGMENTS 20
+
+/**
+* Vertex of a batched shape, already transformed into absolute coordinates
+*/
+struct ShapeVertex {
+	float x;
+	float y;
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+/**
+* Collects rectangles and circles, both filled and outlined, into one vertex buffer
+* and draws them by one call
+*
+* All shapes are tessellated into triangles in the order they were added; outlines are made of quads
+* one unit wide, which is one pixel of the virtual viewport, hence they look the same as the lines
+* drawn by openFrameworks. The buffer is reused by each batch, so nothing is allocated once it has grown large enough
+*/
+class ShapeBatcher {
+private:
+	vector<ShapeVertex> vertices;
+	// unit circle, calculated once
+	float circleCos[SHAPE_CIRCLE_SEGMENTS];
+	float circleSin[SHAPE_CIRCLE_SEGMENTS];
+	// statistics of the current frame
+	int shapesNum = 0;
+	int drawCalls = 0;
+	// backend that draws the batches, not owned by the batcher
+	RenderBackend* backend;
+
+public:
+	ShapeBatcher();
+
+	/**
+	* Sets backend that draws the batches, OpenGL by default
+	*/
+	void SetBackend(RenderBackend* backend) {
+		this->backend = backend;
+	}
+
+	/**
+	* Adds a rectangle with top-left corner at the origin of given matrix
+	* @param matrix absolute transformation of the rectangle
+	* @param noFill indicator whether only borders should be drawn
+	*/
+	void AddRect(const AffineMatrix& matrix, float width, float height, const ofColor& color, bool noFill);
+
+	/**
+	* Adds a circle with center at the origin of given matrix
+	* @param matrix absolute transformation of the circle
+	* @param noFill indicator whether only borders should be drawn
+	*/
+	void AddCircle(const AffineMatrix& matrix, float radius, const ofColor& color, bool noFill);
+
+	/**
+	* Returns true, if there are shapes that haven't been drawn yet
+	*/
+	bool IsEmpty() const {
+		return vertices.empty();
+	}
+
+	/**
+	* Draws all collected shapes and clears the batch
+	* The vertices are already absolute, hence the matrix of the backend is reset to identity
+	*/
+	void Flush();
+
+	/**
+	* Resets statistics of the frame
+	*/
+	void ClearCounters() {
+		shapesNum = 0;
+		drawCalls = 0;
+	}
+
+	/**
+	* Gets number of shapes drawn in the current frame
+	*/
+	int GetShapesNum() const {
+		return shapesNum;
+	}
+
+	/**
+	* Gets number of draw calls issued in the current frame
+	*/
+	int GetDrawCalls() const {
+		return drawCalls;
+	}
+
+	/**
+	* Gets collected vertices, valid until the next flush
+	*/
+	const vector<ShapeVertex>& GetVertices() const {
+		return vertices;
+	}
+
+private:
+	/**
+	* Reserves vertices for a shape and returns a pointer to the first one
+	*/
+	ShapeVertex* AddVertices(int count);
+
+	/**
+	* Adds a line segment as a quad one unit wide
+	*/
+	void AddLine(const ofVec2f& start, const ofVec2f& end, const ofColor& color);
+
+	static void SetVertex(ShapeVertex& vertex, const ofVec2f& position, const ofColor& color) {
+		vertex.x = position.x;
+		vertex.y = position.y;
+		vertex.r = color.r;
+		vertex.g = color.g;
+		vertex.b = color.b;
+		vertex.a = color.a;
+	}
+};
@@ -0,0 +1,490 @@
+#include "SoftwareRenderBackend.h"
+#include "SpriteSheetRenderer.h"
+#include "ofMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+SoftwareRenderBackend::SoftwareRenderBackend(int screenWidth, int screenHeight)
+	: screenWidth(screenWidth), screenHeight(screenHeight) {
+	viewportWidth = projectionWidth = screenWidth;
+	viewportHeight = projectionHeight = screenHeight;
+}
+
+void SoftwareRenderBackend::SetRasterizationEnabled(bool enabled) {
+	rasterizationEnabled = enabled;
+
+	if (enabled && (framebuffer.getWidth() != screenWidth || framebuffer.getHeight() != screenHeight)) {
+		framebuffer.allocate(screenWidth, screenHeight, OF_PIXELS_RGBA);
+		framebuffer.set(0);
+	}
+}
+
+void SoftwareRenderBackend::SetTexturePixels(const ofTexture* texture, const ofPixels* pixels) {
+	if (pixels != nullptr) {
+		texturePixels[texture] = pixels;
+	}
+	else {
+		texturePixels.erase(texture);
+	}
+}
+
+unsigned int SoftwareRenderBackend::GetFramebufferHash() {
+	unsigned int hash = 2166136261u;
+	const unsigned char* data = framebuffer.getData();
+	int size = framebuffer.getWidth() * framebuffer.getHeight() * 4;
+
+	for (int i = 0; i < size && data != nullptr; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+void SoftwareRenderBackend::BeginFrame(int virtualWidth, int virtualHeight) {
+	ClearStats();
+	drawCalls.clear();
+	projectionWidth = virtualWidth;
+	projectionHeight = virtualHeight;
+	viewportX = viewportY = 0;
+	viewportWidth = screenWidth;
+	viewportHeight = screenHeight;
+	matrix = AffineMatrix();
+
+	if (rasterizationEnabled) {
+		// opaque black
+		unsigned char* data = framebuffer.getData();
+		for (int i = 0; i < screenWidth * screenHeight; i++) {
+			data[i * 4] = data[i * 4 + 1] = data[i * 4 + 2] = 0;
+			data[i * 4 + 3] = 255;
+		}
+	}
+}
+
+void SoftwareRenderBackend::SetViewport(float x, float y, float width, float height) {
+	stats.stateChanges++;
+	viewportX = x;
+	viewportY = y;
+	viewportWidth = width;
+	viewportHeight = height;
+}
+
+void SoftwareRenderBackend::LoadMatrix(const ofMatrix4x4& matrix) {
+	stats.stateChanges++;
+	// only the 2D part matters, vertices are drawn in the order they come
+	ofMatrix4x4 copy = matrix;
+	const float* values = copy.getPtr();
+	this->matrix.a = values[0];
+	this->matrix.b = values[1];
+	this->matrix.c = values[4];
+	this->matrix.d = values[5];
+	this->matrix.tx = values[12];
+	this->matrix.ty = values[13];
+}
+
+void SoftwareRenderBackend::SetColor(const ofColor& color) {
+	stats.stateChanges++;
+	this->color = color;
+}
+
+void SoftwareRenderBackend::SetFill(bool fill) {
+	stats.stateChanges++;
+	this->fill = fill;
+}
+
+void SoftwareRenderBackend::DrawRectangle(float x, float y, float width, float height) {
+	RecordDrawCall(DrawCallType::RECTANGLE, nullptr, 4);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	if (fill) {
+		AddVertex(x, y, 0, 0, color);
+		AddVertex(x + width, y, 0, 0, color);
+		AddVertex(x, y + height, 0, 0, color);
+		AddVertex(x + width, y, 0, 0, color);
+		AddVertex(x, y + height, 0, 0, color);
+		AddVertex(x + width, y + height, 0, 0, color);
+	}
+	else {
+		AddLine(x, y, x + width, y);
+		AddLine(x + width, y, x + width, y + height);
+		AddLine(x + width, y + height, x, y + height);
+		AddLine(x, y + height, x, y);
+	}
+
+	RasterizeTriangles(nullptr);
+}
+
+void SoftwareRenderBackend::DrawCircle(float x, float y, float radius) {
+	RecordDrawCall(DrawCallType::CIRCLE, nullptr, SHAPE_CIRCLE_SEGMENTS);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	for (int i = 0; i < SHAPE_CIRCLE_SEGMENTS; i++) {
+		float angle1 = TWO_PI * i / SHAPE_CIRCLE_SEGMENTS;
+		float angle2 = TWO_PI * (i + 1) / SHAPE_CIRCLE_SEGMENTS;
+		float x1 = x + radius * cos(angle1);
+		float y1 = y + radius * sin(angle1);
+		float x2 = x + radius * cos(angle2);
+		float y2 = y + radius * sin(angle2);
+
+		if (fill) {
+			AddVertex(x, y, 0, 0, color);
+			AddVertex(x1, y1, 0, 0, color);
+			AddVertex(x2, y2, 0, 0, color);
+		}
+		else {
+			AddLine(x1, y1, x2, y2);
+		}
+	}
+
+	RasterizeTriangles(nullptr);
+}
+
+void SoftwareRenderBackend::DrawImage(ofImage* image, const AtlasRegion* region) {
+	stats.textureBinds++;
+	RecordDrawCall(DrawCallType::IMAGE, &image->getTexture(), 4);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	// images keep their pixels in memory, hence they don't have to be registered
+	ofPixels& pixels = image->getPixels();
+	const ofPixels* texels = pixels.getWidth() > 0 ? &pixels : GetTexturePixels(&image->getTexture());
+	float u = region != nullptr ? region->x : 0;
+	float v = region != nullptr ? region->y : 0;
+	float width = region != nullptr ? region->width : image->getWidth();
+	float height = region != nullptr ? region->height : image->getHeight();
+
+	AddVertex(0, 0, u, v, color);
+	AddVertex(width, 0, u + width, v, color);
+	AddVertex(0, height, u, v + height, color);
+	AddVertex(width, 0, u + width, v, color);
+	AddVertex(0, height, u, v + height, color);
+	AddVertex(width, height, u + width, v + height, color);
+	RasterizeTriangles(texels);
+}
+
+void SoftwareRenderBackend::DrawString(ofTrueTypeFont* font, const string& text, float x, float y) {
+	stats.textureBinds++;
+
+	if (!rasterizationEnabled) {
+		RecordDrawCall(DrawCallType::STRING, &font->getFontTexture(), text.size() * 6);
+		return;
+	}
+
+	// the font lays out its glyphs without any graphics API
+	vector<GlyphVertex> glyphs;
+	TextBatcher::LayoutString(font, text, x, y, glyphs);
+	RecordDrawCall(DrawCallType::STRING, &font->getFontTexture(), glyphs.size());
+
+	const ofPixels* texels = GetTexturePixels(&font->getFontTexture());
+	float scaleX, scaleY;
+	GetTexelScale(&font->getFontTexture(), texels, scaleX, scaleY);
+
+	for (auto& glyph : glyphs) {
+		AddVertex(glyph.x, glyph.y, glyph.u * scaleX, glyph.v * scaleY, color);
+	}
+
+	RasterizeTriangles(texels);
+}
+
+void SoftwareRenderBackend::DrawShapes(const ShapeVertex* vertices, int count) {
+	RecordDrawCall(DrawCallType::SHAPES, nullptr, count);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	for (int i = 0; i < count; i++) {
+		auto& vertex = vertices[i];
+		AddVertex(vertex.x, vertex.y, 0, 0, ofColor(vertex.r, vertex.g, vertex.b, vertex.a));
+	}
+
+	RasterizeTriangles(nullptr);
+}
+
+void SoftwareRenderBackend::DrawTexts(ofTexture* texture, const TextVertex* vertices, int count) {
+	stats.textureBinds++;
+	RecordDrawCall(DrawCallType::TEXTS, texture, count);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	const ofPixels* texels = GetTexturePixels(texture);
+	float scaleX, scaleY;
+	GetTexelScale(texture, texels, scaleX, scaleY);
+
+	for (int i = 0; i < count; i++) {
+		auto& vertex = vertices[i];
+		AddVertex(vertex.x, vertex.y, vertex.u * scaleX, vertex.v * scaleY, ofColor(vertex.r, vertex.g, vertex.b, vertex.a));
+	}
+
+	RasterizeTriangles(texels);
+}
+
+void SoftwareRenderBackend::DrawImages(ofTexture* texture, const ImageVertex* vertices, int count) {
+	stats.textureBinds++;
+	RecordDrawCall(DrawCallType::IMAGES, texture, count);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	const ofPixels* texels = GetTexturePixels(texture);
+	float scaleX, scaleY;
+	GetTexelScale(texture, texels, scaleX, scaleY);
+
+	for (int i = 0; i < count; i++) {
+		auto& vertex = vertices[i];
+		AddVertex(vertex.x, vertex.y, vertex.u * scaleX, vertex.v * scaleY, color);
+	}
+
+	RasterizeTriangles(texels);
+}
+
+unsigned int SoftwareRenderBackend::CreateBuffer(int size) {
+	buffers[++lastBuffer].resize(size);
+	return lastBuffer;
+}
+
+void SoftwareRenderBackend::DeleteBuffer(unsigned int buffer) {
+	buffers.erase(buffer);
+}
+
+void SoftwareRenderBackend::UpdateBuffer(unsigned int buffer, int offset, int size, const void* data) {
+	stats.uploadedBytes += size;
+	memcpy(&buffers[buffer][offset], data, size);
+}
+
+void SoftwareRenderBackend::DrawSpriteQuads(SpriteLayer* layer, unsigned int buffer, int count) {
+	stats.textureBinds++;
+	RecordDrawCall(DrawCallType::SPRITES, layer->texture, count * 4);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	// quads of a buffer object are drawn as they were uploaded, even if the layer has changed since
+	const SpriteQuad* quads = buffer != 0 ? (const SpriteQuad*)buffers[buffer].data() : layer->quads;
+	const ofPixels* texels = GetTexturePixels(layer->texture);
+	// two triangles of each quad, the same as the indices of the GL backend
+	int indices[6] = { 0, 1, 2, 1, 2, 3 };
+
+	for (int i = 0; i < count; i++) {
+		for (int index : indices) {
+			auto& vertex = quads[i].vertices[index];
+			// texture coordinates are stored in halves of texels
+			AddVertex(vertex.x, vertex.y, vertex.u * 0.5f, vertex.v * 0.5f, ofColor(vertex.r, vertex.g, vertex.b, vertex.a));
+		}
+	}
+
+	RasterizeTriangles(texels);
+}
+
+void SoftwareRenderBackend::DrawSpriteInstances(SpriteLayer* layer, unsigned int buffer, int count) {
+	stats.textureBinds++;
+	RecordDrawCall(DrawCallType::SPRITE_INSTANCES, layer->texture, count * 4);
+
+	if (!rasterizationEnabled) {
+		return;
+	}
+
+	const SpriteInstance* instances = (const SpriteInstance*)buffers[buffer].data();
+	const ofPixels* texels = GetTexturePixels(layer->texture);
+	// corners of the unit quad in the order of quad vertices, each corner is drawn by two triangles
+	float cornersX[4] = { -1, 1, -1, 1 };
+	float cornersY[4] = { -1, -1, 1, 1 };
+	int indices[6] = { 0, 1, 2, 1, 2, 3 };
+
+	for (int i = 0; i < count; i++) {
+		const SpriteInstance& instance = instances[i];
+		// the same operations as SpriteSheetRenderer::MakeQuad, hence the corners are equal
+		float c = instance.rotation == 0 ? 1 : cosf(instance.rotation);
+		float s = instance.rotation == 0 ? 0 : sinf(instance.rotation);
+		float wc = instance.halfWidth*c;
+		float hs = instance.halfHeight*s;
+		float ws = instance.halfWidth*s;
+		float hc = instance.halfHeight*c;
+		ofColor color(instance.r, instance.g, instance.b, instance.a);
+
+		for (int index : indices) {
+			float x = instance.posX + cornersX[index] * wc - cornersY[index] * hs;
+			float y = instance.posY + cornersX[index] * ws + cornersY[index] * hc;
+			// texture coordinates are stored in halves of texels
+			float u = (cornersX[index] < 0 ? instance.u1 : instance.u2) * 0.5f;
+			float v = (cornersY[index] < 0 ? instance.v1 : instance.v2) * 0.5f;
+			AddVertex(x, y, u, v, color);
+		}
+	}
+
+	RasterizeTriangles(texels);
+}
+
+void SoftwareRenderBackend::RecordDrawCall(DrawCallType type, const void* texture, int vertices) {
+	stats.drawCalls++;
+	stats.vertices += vertices;
+	DrawCallRecord record;
+	record.type = type;
+	record.texture = texture;
+	record.vertices = vertices;
+	drawCalls.push_back(record);
+}
+
+void SoftwareRenderBackend::AddVertex(float x, float y, float u, float v, const ofColor& color) {
+	ofVec2f position = matrix.Transform(x, y);
+	RasterVertex vertex;
+	// projection maps the virtual size onto the viewport
+	vertex.x = viewportX + position.x * viewportWidth / projectionWidth;
+	vertex.y = viewportY + position.y * viewportHeight / projectionHeight;
+	vertex.u = u;
+	vertex.v = v;
+	vertex.r = color.r;
+	vertex.g = color.g;
+	vertex.b = color.b;
+	vertex.a = color.a;
+	triangles.push_back(vertex);
+}
+
+void SoftwareRenderBackend::AddLine(float x1, float y1, float x2, float y2) {
+	float dirX = x2 - x1;
+	float dirY = y2 - y1;
+	float length = sqrt(dirX * dirX + dirY * dirY);
+
+	if (length == 0) {
+		return;
+	}
+
+	// half a unit to both sides and beyond both ends
+	dirX *= 0.5f / length;
+	dirY *= 0.5f / length;
+	float normalX = -dirY;
+	float normalY = dirX;
+
+	AddVertex(x1 - dirX + normalX, y1 - dirY + normalY, 0, 0, color);
+	AddVertex(x2 + dirX + normalX, y2 + dirY + normalY, 0, 0, color);
+	AddVertex(x1 - dirX - normalX, y1 - dirY - normalY, 0, 0, color);
+	AddVertex(x2 + dirX + normalX, y2 + dirY + normalY, 0, 0, color);
+	AddVertex(x1 - dirX - normalX, y1 - dirY - normalY, 0, 0, color);
+	AddVertex(x2 + dirX - normalX, y2 + dirY - normalY, 0, 0, color);
+}
+
+void SoftwareRenderBackend::GetTexelScale(ofTexture* texture, const ofPixels* pixels, float& scaleX, float& scaleY) {
+	scaleX = scaleY = 1;
+
+	if (pixels != nullptr) {
+		// coordinates of the bottom-right corner are either [1, 1] or the size of the texture
+		ofVec2f corner = texture->getCoordFromPoint(texture->getWidth(), texture->getHeight());
+		scaleX = corner.x != 0 ? pixels->getWidth() / corner.x : 1;
+		scaleY = corner.y != 0 ? pixels->getHeight() / corner.y : 1;
+	}
+}
+
+const ofPixels* SoftwareRenderBackend::GetTexturePixels(const ofTexture* texture) const {
+	auto found = texturePixels.find(texture);
+	return found != texturePixels.end() ? found->second : nullptr;
+}
+
+void SoftwareRenderBackend::RasterizeTriangles(const ofPixels* texels) {
+	for (int i = 0; i + 2 < (int)triangles.size(); i += 3) {
+		RasterizeTriangle(triangles[i], triangles[i + 1], triangles[i + 2], texels);
+	}
+
+	triangles.clear();
+}
+
+void SoftwareRenderBackend::RasterizeTriangle(const RasterVertex& first, const RasterVertex& second, const RasterVertex& third, const ofPixels* texels) {
+	auto edge = [](const RasterVertex& from, const RasterVertex& to, float x, float y) {
+		return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+	};
+
+	// vertices are ordered so that the area is positive
+	const RasterVertex* v0 = &first;
+	const RasterVertex* v1 = &second;
+	const RasterVertex* v2 = &third;
+	float area = edge(*v0, *v1, v2->x, v2->y);
+
+	if (area == 0) {
+		return;
+	}
+
+	if (area < 0) {
+		swap(v1, v2);
+		area = -area;
+	}
+
+	// pixels lying exactly on an edge belong to only one of two triangles that share it
+	auto isIncluded = [](const RasterVertex& from, const RasterVertex& to, float weight) {
+		return weight > 0 || (weight == 0 && (to.y < from.y || (to.y == from.y && to.x > from.x)));
+	};
+
+	// the viewport clips everything
+	int minX = max((int)floor(min(v0->x, min(v1->x, v2->x))), max(0, (int)viewportX));
+	int minY = max((int)floor(min(v0->y, min(v1->y, v2->y))), max(0, (int)viewportY));
+	int maxX = min((int)ceil(max(v0->x, max(v1->x, v2->x))), min(screenWidth, (int)(viewportX + viewportWidth)));
+	int maxY = min((int)ceil(max(v0->y, max(v1->y, v2->y))), min(screenHeight, (int)(viewportY + viewportHeight)));
+
+	unsigned char* pixels = framebuffer.getData();
+	const unsigned char* texelData = texels != nullptr ? texels->getData() : nullptr;
+	int texelChannels = texels != nullptr ? texels->getNumChannels() : 0;
+
+	for (int y = minY; y < maxY; y++) {
+		for (int x = minX; x < maxX; x++) {
+			// pixels are sampled at their centers
+			float centerX = x + 0.5f;
+			float centerY = y + 0.5f;
+			float w0 = edge(*v1, *v2, centerX, centerY);
+			float w1 = edge(*v2, *v0, centerX, centerY);
+			float w2 = edge(*v0, *v1, centerX, centerY);
+
+			if (!isIncluded(*v1, *v2, w0) || !isIncluded(*v2, *v0, w1) || !isIncluded(*v0, *v1, w2)) {
+				continue;
+			}
+
+			w0 /= area;
+			w1 /= area;
+			w2 /= area;
+
+			float r = w0 * v0->r + w1 * v1->r + w2 * v2->r;
+			float g = w0 * v0->g + w1 * v1->g + w2 * v2->g;
+			float b = w0 * v0->b + w1 * v1->b + w2 * v2->b;
+			float a = w0 * v0->a + w1 * v1->a + w2 * v2->a;
+
+			if (texelData != nullptr && texelChannels > 0) {
+				// nearest texel, clamped to the edges
+				int texelX = (int)ofClamp((int)floor(w0 * v0->u + w1 * v1->u + w2 * v2->u), 0, texels->getWidth() - 1);
+				int texelY = (int)ofClamp((int)floor(w0 * v0->v + w1 * v1->v + w2 * v2->v), 0, texels->getHeight() - 1);
+				const unsigned char* texel = &texelData[(texelY * texels->getWidth() + texelX) * texelChannels];
+
+				if (texelChannels >= 3) {
+					r *= texel[0] / 255.0f;
+					g *= texel[1] / 255.0f;
+					b *= texel[2] / 255.0f;
+				}
+				else {
+					// luminance, possibly with alpha
+					r *= texel[0] / 255.0f;
+					g *= texel[0] / 255.0f;
+					b *= texel[0] / 255.0f;
+				}
+
+				if (texelChannels == 4 || texelChannels == 2) {
+					a *= texel[texelChannels - 1] / 255.0f;
+				}
+			}
+
+			// source-over blending, the same as the default blend mode of openFrameworks
+			unsigned char* pixel = &pixels[(y * screenWidth + x) * 4];
+			float alpha = a / 255.0f;
+			pixel[0] = (unsigned char)(r * alpha + pixel[0] * (1 - alpha) + 0.5f);
+			pixel[1] = (unsigned char)(g * alpha + pixel[1] * (1 - alpha) + 0.5f);
+			pixel[2] = (unsigned char)(b * alpha + pixel[2] * (1 - alpha) + 0.5f);
+		}
+	}
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include "RenderBackend.h"
+#include "AffineMatrix.h"
+
+using namespace std;
+
+/**
+* Type of a primitive drawn by a backend
+*/
+enum class DrawCallType {
+	RECTANGLE = 0,
+	CIRCLE = 1,
+	IMAGE = 2,
+	STRING = 3,
+	SHAPES = 4,
+	TEXTS = 5,
+	IMAGES = 6,
+	SPRITES = 7,
+	SPRITE_INSTANCES = 8
+};
+
+/**
+* Draw call recorded by the software backend
+*/
+struct DrawCallRecord {
+	DrawCallType type;
+	// texture the call was drawn with, nullptr if none
+	const void* texture;
+	int vertices;
+};
+
+/**
+* Vertex of a triangle being rasterized, in pixels of the framebuffer
+*/
+struct RasterVertex {
+	float x;
+	float y;
+	// texture coordinates in texels
+	float u;
+	float v;
+	float r;
+	float g;
+	float b;
+	float a;
+};
+
+/**
+* Backend that draws without any graphics API, for headless benchmarks and regression tests
+*
+* Each draw call is recorded with its type, texture and number of vertices. If rasterization is enabled,
+* triangles are rasterized into a framebuffer in memory with alpha blending and nearest texels,
+* hence the framebuffer can be compared with one of a previous run. Textures live in the GPU memory,
+* thus they are sampled only if their pixels have been registered; other triangles are drawn with
+* their vertex colors only. Without rasterization, the backend works as a null backend
+* Buffer objects are emulated by copies in memory, so that partial updates are drawn the same way as by OpenGL
+*/
+class SoftwareRenderBackend : public RenderBackend {
+private:
+	int screenWidth;
+	int screenHeight;
+	bool rasterizationEnabled = false;
+	ofPixels framebuffer;
+	// size of the orthographic projection
+	int projectionWidth = 1;
+	int projectionHeight = 1;
+	// viewport, outside of which nothing is drawn
+	float viewportX = 0;
+	float viewportY = 0;
+	float viewportWidth = 0;
+	float viewportHeight = 0;
+	// 2D part of the loaded matrix
+	AffineMatrix matrix;
+	ofColor color;
+	bool fill = true;
+	vector<DrawCallRecord> drawCalls;
+	// emulated buffer objects
+	map<unsigned int, vector<char>> buffers;
+	unsigned int lastBuffer = 0;
+	// pixels of textures, registered by the user
+	map<const ofTexture*, const ofPixels*> texturePixels;
+	// transformed vertices of the triangles that are being drawn
+	vector<RasterVertex> triangles;
+
+public:
+	/**
+	* Creates a backend for a screen of given size
+	*/
+	SoftwareRenderBackend(int screenWidth, int screenHeight);
+
+	/**
+	* Enables or disables rasterization into the framebuffer
+	*/
+	void SetRasterizationEnabled(bool enabled);
+
+	bool IsRasterizationEnabled() const {
+		return rasterizationEnabled;
+	}
+
+	/**
+	* Registers pixels of a texture, so that triangles drawn with the texture sample them
+	* @param pixels pixels of the same size as the texture, or nullptr to unregister them
+	*/
+	void SetTexturePixels(const ofTexture* texture, const ofPixels* pixels);
+
+	/**
+	* Gets RGBA pixels drawn since the beginning of the frame
+	*/
+	const ofPixels& GetFramebuffer() const {
+		return framebuffer;
+	}
+
+	/**
+	* Calculates FNV-1a hash of the framebuffer, so that frames of two runs can be compared
+	*/
+	unsigned int GetFramebufferHash();
+
+	/**
+	* Gets draw calls recorded since the beginning of the frame
+	*/
+	const vector<DrawCallRecord>& GetDrawCalls() const {
+		return drawCalls;
+	}
+
+	/**
+	* Gets number of existing buffer objects
+	*/
+	int GetBuffersNum() const {
+		return buffers.size();
+	}
+
+	void BeginFrame(int virtualWidth, int virtualHeight) override;
+
+	int GetScreenWidth() override {
+		return screenWidth;
+	}
+
+	int GetScreenHeight() override {
+		return screenHeight;
+	}
+
+	void SetViewport(float x, float y, float width, float height) override;
+
+	void LoadMatrix(const ofMatrix4x4& matrix) override;
+
+	void SetColor(const ofColor& color) override;
+
+	void SetFill(bool fill) override;
+
+	void DrawRectangle(float x, float y, float width, float height) override;
+
+	void DrawCircle(float x, float y, float radius) override;
+
+	void DrawImage(ofImage* image, const AtlasRegion* region) override;
+
+	void DrawString(ofTrueTypeFont* font, const string& text, float x, float y) override;
+
+	void DrawShapes(const ShapeVertex* vertices, int count) override;
+
+	void DrawTexts(ofTexture* texture, const TextVertex* vertices, int count) override;
+
+	void DrawImages(ofTexture* texture, const ImageVertex* vertices, int count) override;
+
+	unsigned int CreateBuffer(int size) override;
+
+	void DeleteBuffer(unsigned int buffer) override;
+
+	void UpdateBuffer(unsigned int buffer, int offset, int size, const void* data) override;
+
+	void DrawSpriteQuads(SpriteLayer* layer, unsigned int buffer, int count) override;
+
+	void DrawSpriteInstances(SpriteLayer* layer, unsigned int buffer, int count) override;
+
+private:
+	void RecordDrawCall(DrawCallType type, const void* texture, int vertices);
+
+	/**
+	* Transforms a vertex by the loaded matrix and the viewport and adds it to the triangles being drawn
+	* @param u x-coordinate in the texture, in texels
+	* @param v y-coordinate in the texture, in texels
+	*/
+	void AddVertex(float x, float y, float u, float v, const ofColor& color);
+
+	/**
+	* Adds two triangles of a line one unit wide, the same as outlines of batched shapes
+	*/
+	void AddLine(float x1, float y1, float x2, float y2);
+
+	/**
+	* Gets ratio of texels to texture coordinates, which are either normalized or in texels, depending on the texture target
+	*/
+	void GetTexelScale(ofTexture* texture, const ofPixels* pixels, float& scaleX, float& scaleY);
+
+	/**
+	* Gets registered pixels of a texture or nullptr
+	*/
+	const ofPixels* GetTexturePixels(const ofTexture* texture) const;
+
+	/**
+	* Rasterizes all added triangles and clears them
+	* @param texels pixels sampled by the triangles, nullptr if they have no texture
+	*/
+	void RasterizeTriangles(const ofPixels* texels);
+
+	void RasterizeTriangle(const RasterVertex& first, const RasterVertex& second, const RasterVertex& third, const ofPixels* texels);
+};
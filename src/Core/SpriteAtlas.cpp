@@ -0,0 +1,349 @@
+#include "SpriteAtlas.h"
+#include "jsonxx.h"
+#include "ofLog.h"
+#include <algorithm>
+#include <fstream>
+#include <climits>
+#include <sys/stat.h>
+
+/**
+* Gets time of the last modification of a file in the data folder, or -1 if it doesn't exist
+*/
+static double GetModificationTime(const string& path) {
+	struct stat info;
+
+	if (stat(ofToDataPath(path).c_str(), &info) != 0) {
+		return -1;
+	}
+
+	return (double)info.st_mtime;
+}
+
+MaxRectsPacker::MaxRectsPacker(int width, int height) : width(width), height(height) {
+	AtlasRegion whole;
+	whole.width = width;
+	whole.height = height;
+	freeRects.push_back(whole);
+}
+
+bool MaxRectsPacker::Insert(int width, int height, AtlasRegion& output) {
+	int bestShortSide = INT_MAX;
+	int bestLongSide = INT_MAX;
+	const AtlasRegion* best = nullptr;
+
+	for (auto& free : freeRects) {
+		if (free.width >= width && free.height >= height) {
+			int leftoverX = free.width - width;
+			int leftoverY = free.height - height;
+			int shortSide = min(leftoverX, leftoverY);
+			int longSide = max(leftoverX, leftoverY);
+
+			if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+				best = &free;
+			}
+		}
+	}
+
+	if (best == nullptr) {
+		return false;
+	}
+
+	output.x = best->x;
+	output.y = best->y;
+	output.width = width;
+	output.height = height;
+	usedArea += width * height;
+
+	SplitFreeRects(output);
+	PruneFreeRects();
+	return true;
+}
+
+void MaxRectsPacker::SplitFreeRects(const AtlasRegion& used) {
+	newFreeRects.clear();
+
+	for (auto& free : freeRects) {
+		if (used.x >= free.x + free.width || used.x + used.width <= free.x
+			|| used.y >= free.y + free.height || used.y + used.height <= free.y) {
+			// no intersection
+			newFreeRects.push_back(free);
+			continue;
+		}
+
+		// each part is as large as possible, hence the parts may overlap each other
+		if (used.x > free.x) {
+			AtlasRegion left = free;
+			left.width = used.x - free.x;
+			newFreeRects.push_back(left);
+		}
+
+		if (used.x + used.width < free.x + free.width) {
+			AtlasRegion right = free;
+			right.x = used.x + used.width;
+			right.width = free.x + free.width - right.x;
+			newFreeRects.push_back(right);
+		}
+
+		if (used.y > free.y) {
+			AtlasRegion top = free;
+			top.height = used.y - free.y;
+			newFreeRects.push_back(top);
+		}
+
+		if (used.y + used.height < free.y + free.height) {
+			AtlasRegion bottom = free;
+			bottom.y = used.y + used.height;
+			bottom.height = free.y + free.height - bottom.y;
+			newFreeRects.push_back(bottom);
+		}
+	}
+
+	freeRects.swap(newFreeRects);
+}
+
+void MaxRectsPacker::PruneFreeRects() {
+	auto contains = [](const AtlasRegion& outer, const AtlasRegion& inner) {
+		return inner.x >= outer.x && inner.y >= outer.y
+			&& inner.x + inner.width <= outer.x + outer.width
+			&& inner.y + inner.height <= outer.y + outer.height;
+	};
+
+	newFreeRects.clear();
+
+	for (int i = 0; i < (int)freeRects.size(); i++) {
+		bool isContained = false;
+
+		for (int j = 0; j < (int)freeRects.size() && !isContained; j++) {
+			// of two identical rectangles, only the first one is kept
+			isContained = i != j && contains(freeRects[j], freeRects[i]) && (j < i || !contains(freeRects[i], freeRects[j]));
+		}
+
+		if (!isContained) {
+			newFreeRects.push_back(freeRects[i]);
+		}
+	}
+
+	freeRects.swap(newFreeRects);
+}
+
+void SpriteAtlas::AddImage(const string& path) {
+	if (find(paths.begin(), paths.end(), path) == paths.end()) {
+		paths.push_back(path);
+	}
+}
+
+bool SpriteAtlas::Pack() {
+	vector<ofPixels> pixels(paths.size());
+	vector<AtlasRegion> packed(paths.size());
+
+	for (int i = 0; i < (int)paths.size(); i++) {
+		if (!ofLoadImage(pixels[i], paths[i])) {
+			ofLogError("SpriteAtlas", "Image %s couldn't be loaded", paths[i].c_str());
+			return false;
+		}
+		pixels[i].setImageType(OF_IMAGE_COLOR_ALPHA);
+		packed[i].width = pixels[i].getWidth();
+		packed[i].height = pixels[i].getHeight();
+	}
+
+	int atlasWidth, atlasHeight;
+
+	if (!Layout(packed, padding, atlasWidth, atlasHeight)) {
+		ofLogError("SpriteAtlas", "Images don't fit into an atlas of size %d", SPRITE_ATLAS_MAX_SIZE);
+		return false;
+	}
+
+	// copy all images into one transparent image
+	ofPixels atlasPixels;
+	atlasPixels.allocate(atlasWidth, atlasHeight, OF_PIXELS_RGBA);
+	atlasPixels.set(0);
+	regions.clear();
+
+	for (int i = 0; i < (int)paths.size(); i++) {
+		pixels[i].pasteInto(atlasPixels, packed[i].x, packed[i].y);
+		regions[paths[i]] = packed[i];
+	}
+
+	image.setFromPixels(atlasPixels);
+	return true;
+}
+
+bool SpriteAtlas::LoadCache(const string& path) {
+	ifstream fin;
+	fin.open(ofToDataPath(path + ".json").c_str());
+
+	if (!fin.is_open()) {
+		return false;
+	}
+
+	jsonxx::Object o;
+	bool parsed = o.parse(fin);
+	fin.close();
+
+	if (!parsed || !o.has<jsonxx::Array>("regions")) {
+		return false;
+	}
+
+	map<string, AtlasRegion> cachedRegions;
+	auto& cached = o.get<jsonxx::Array>("regions");
+
+	for (int i = 0; i < (int)cached.size(); i++) {
+		auto& obj = cached.get<jsonxx::Object>(i);
+		AtlasRegion region;
+		region.x = obj.get<jsonxx::Number>("x");
+		region.y = obj.get<jsonxx::Number>("y");
+		region.width = obj.get<jsonxx::Number>("width");
+		region.height = obj.get<jsonxx::Number>("height");
+		auto& imagePath = obj.get<jsonxx::String>("name");
+
+		// the cache is outdated if any image has been modified since it was packed
+		if (!obj.has<jsonxx::Number>("modified") || obj.get<jsonxx::Number>("modified") != GetModificationTime(imagePath)) {
+			ofLogNotice("SpriteAtlas", "Image %s has changed since the atlas was packed", imagePath.c_str());
+			return false;
+		}
+
+		cachedRegions[imagePath] = region;
+	}
+
+	// the cache is outdated if the set of images has changed
+	if (cachedRegions.size() != paths.size()) {
+		return false;
+	}
+
+	for (auto& imagePath : paths) {
+		if (cachedRegions.find(imagePath) == cachedRegions.end()) {
+			return false;
+		}
+	}
+
+	if (!image.load(path + ".png")) {
+		return false;
+	}
+
+	// the atlas image has to have the size it was saved with, and all regions have to lie within it
+	int atlasWidth = image.getWidth();
+	int atlasHeight = image.getHeight();
+
+	if (atlasWidth != o.get<jsonxx::Number>("width", -1) || atlasHeight != o.get<jsonxx::Number>("height", -1)) {
+		return false;
+	}
+
+	for (auto& pair : cachedRegions) {
+		auto& region = pair.second;
+
+		if (region.x < 0 || region.y < 0 || region.x + region.width > atlasWidth || region.y + region.height > atlasHeight) {
+			return false;
+		}
+	}
+
+	regions = cachedRegions;
+	return true;
+}
+
+bool SpriteAtlas::SaveCache(const string& path) {
+	jsonxx::Array cached;
+
+	for (auto& imagePath : paths) {
+		auto& region = regions[imagePath];
+		jsonxx::Object obj;
+		obj << "name" << imagePath;
+		obj << "x" << region.x;
+		obj << "y" << region.y;
+		obj << "width" << region.width;
+		obj << "height" << region.height;
+		obj << "modified" << GetModificationTime(imagePath);
+		cached << obj;
+	}
+
+	jsonxx::Object o;
+	o << "image" << (path + ".png");
+	o << "width" << image.getWidth();
+	o << "height" << image.getHeight();
+	o << "regions" << cached;
+
+	ofstream fout;
+	fout.open(ofToDataPath(path + ".json").c_str());
+
+	if (!fout.is_open()) {
+		ofLogError("SpriteAtlas", "Cache %s couldn't be saved", path.c_str());
+		return false;
+	}
+
+	fout << o.json();
+	fout.close();
+	return image.save(path + ".png");
+}
+
+bool SpriteAtlas::LoadOrPack(const string& cachePath) {
+	if (LoadCache(cachePath)) {
+		return true;
+	}
+
+	ofLogNotice("SpriteAtlas", "Packing %d images into atlas %s", paths.size(), cachePath.c_str());
+
+	if (!Pack()) {
+		return false;
+	}
+
+	// the atlas can be used even if the cache couldn't be saved
+	SaveCache(cachePath);
+	return true;
+}
+
+bool SpriteAtlas::Layout(vector<AtlasRegion>& regions, int padding, int& atlasWidth, int& atlasHeight) {
+	int totalArea = 0;
+	int maxWidth = 1;
+	int maxHeight = 1;
+
+	for (auto& region : regions) {
+		totalArea += (region.width + padding) * (region.height + padding);
+		maxWidth = max(maxWidth, region.width + padding);
+		maxHeight = max(maxHeight, region.height + padding);
+	}
+
+	// large rectangles are placed first, small ones fill the gaps
+	vector<int> order(regions.size());
+	for (int i = 0; i < (int)order.size(); i++) {
+		order[i] = i;
+	}
+
+	sort(order.begin(), order.end(), [&regions](int a, int b) {
+		int sideA = max(regions[a].width, regions[a].height);
+		int sideB = max(regions[b].width, regions[b].height);
+		return sideA != sideB ? sideA > sideB : (regions[a].width * regions[a].height) > (regions[b].width * regions[b].height);
+	});
+
+	// start with the smallest power-of-two area that can contain all rectangles
+	atlasWidth = ofNextPow2(maxWidth);
+	atlasHeight = ofNextPow2(maxHeight);
+
+	while (atlasWidth * atlasHeight < totalArea) {
+		if (atlasWidth <= atlasHeight) atlasWidth *= 2;
+		else atlasHeight *= 2;
+	}
+
+	while (atlasWidth <= SPRITE_ATLAS_MAX_SIZE && atlasHeight <= SPRITE_ATLAS_MAX_SIZE) {
+		MaxRectsPacker packer(atlasWidth, atlasHeight);
+		bool fits = true;
+
+		for (int i = 0; i < (int)order.size() && fits; i++) {
+			auto& region = regions[order[i]];
+			AtlasRegion placed;
+			fits = packer.Insert(region.width + padding, region.height + padding, placed);
+			region.x = placed.x;
+			region.y = placed.y;
+		}
+
+		if (fits) {
+			return true;
+		}
+
+		// try a larger atlas
+		if (atlasWidth <= atlasHeight) atlasWidth *= 2;
+		else atlasHeight *= 2;
+	}
+
+	return false;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include "ofImage.h"
+
+using namespace std;
+
+// maximum size of a packed atlas in pixels, supported by all common GPUs
+#define SPRITE_ATLAS_MAX_SIZE 4096
+
+/**
+* Area of an image in a sprite atlas, in pixels
+*/
+struct AtlasRegion {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/**
+* Packs rectangles into a fixed area using the MaxRects algorithm
+* Keeps a list of maximal free rectangles and places each new rectangle
+* into the one that leaves the shortest side of the remaining space (best short side fit)
+*/
+class MaxRectsPacker {
+private:
+	int width;
+	int height;
+	int usedArea = 0;
+	vector<AtlasRegion> freeRects;
+	// new free rectangles, created by splitting
+	vector<AtlasRegion> newFreeRects;
+
+public:
+	MaxRectsPacker(int width, int height);
+
+	/**
+	* Finds a place for a rectangle of given size and marks it as used
+	* @param output region of the placed rectangle
+	* @return false if there is no free space large enough
+	*/
+	bool Insert(int width, int height, AtlasRegion& output);
+
+	/**
+	* Gets ratio of used area to the whole area
+	*/
+	float GetOccupancy() const {
+		return ((float)usedArea) / (width * height);
+	}
+
+private:
+	/**
+	* Splits all free rectangles that overlap the used one into at most four parts
+	*/
+	void SplitFreeRects(const AtlasRegion& used);
+
+	/**
+	* Removes free rectangles that are contained in other free rectangles
+	*/
+	void PruneFreeRects();
+};
+
+/**
+* Texture atlas created from several images, so that they can be drawn from one texture
+* and hence in one draw call
+*
+* Images are packed when the game starts, or loaded from a cached atlas file that has been packed before:
+* the cache consists of a PNG image and a JSON file with regions and modification times of all images.
+* The cache is used only if it contains exactly the images added to the atlas, none of them has been
+* modified since and the regions fit the cached image; otherwise they are packed again
+* Images are identified by their paths, so that each path can be replaced by its region
+*/
+class SpriteAtlas {
+private:
+	// paths of images in the order they were added
+	vector<string> paths;
+	map<string, AtlasRegion> regions;
+	ofImage image;
+	// empty space between images, prevents bleeding of neighbouring pixels when filtered
+	int padding = 1;
+
+public:
+
+	/**
+	* Adds an image that will be packed into the atlas
+	* @param path path to the image, relative to the data folder
+	*/
+	void AddImage(const string& path);
+
+	/**
+	* Sets number of empty pixels between packed images
+	*/
+	void SetPadding(int padding) {
+		this->padding = padding;
+	}
+
+	/**
+	* Loads all added images and packs them into one atlas
+	* @return false if some image couldn't be loaded or the images don't fit into the maximum size
+	*/
+	bool Pack();
+
+	/**
+	* Loads the atlas from cache files [path].json and [path].png
+	* @return false if the cache doesn't exist, doesn't contain the same images or any of them has been modified
+	*/
+	bool LoadCache(const string& path);
+
+	/**
+	* Saves the packed atlas into cache files [path].json and [path].png
+	*/
+	bool SaveCache(const string& path);
+
+	/**
+	* Loads the atlas from cache files; if not possible, packs the images and saves the cache
+	*/
+	bool LoadOrPack(const string& cachePath);
+
+	/**
+	* Calculates positions of rectangles of given sizes and the smallest power-of-two size of an atlas they fit in
+	* @param regions rectangles to pack; their sizes are read and their positions are written
+	* @param padding empty space between rectangles
+	* @param atlasWidth output width of the atlas
+	* @param atlasHeight output height of the atlas
+	* @return false if the rectangles don't fit into the maximum size
+	*/
+	static bool Layout(vector<AtlasRegion>& regions, int padding, int& atlasWidth, int& atlasHeight);
+
+	/**
+	* Gets the image of the whole atlas
+	*/
+	ofImage* GetImage() {
+		return &image;
+	}
+
+	/**
+	* Gets region of an image in the atlas or nullptr if the image isn't in the atlas
+	* @param path path of the image, the same as used in AddImage
+	*/
+	const AtlasRegion* GetRegion(const string& path) const {
+		auto found = regions.find(path);
+		return found != regions.end() ? &found->second : nullptr;
+	}
+
+	/**
+	* Gets number of images in the atlas
+	*/
+	int GetImagesNum() const {
+		return paths.size();
+	}
+};
@@ -1,5 +1,6 @@
 #include "SpriteSheetBuilder.h"
 #include "SpriteSheet.h"
+#include "SpriteAtlas.h"
 #include "jsonxx.h"
 
 void SpriteSheetBuilder::LoadFromJson(jsonxx::Object& obj) {
@@ -20,6 +21,21 @@ void SpriteSheetBuilder::LoadFromJson(jsonxx::Object& obj) {
 	this->totalFrames = obj.get<jsonxx::Number>("frames", 1);
 }
 
+SpriteSheetBuilder& SpriteSheetBuilder::Region(SpriteAtlas* atlas, const string& path) {
+	auto region = atlas->GetRegion(path);
+
+	if (region == nullptr) {
+		throw std::invalid_argument("Image not found in the atlas");
+	}
+
+	this->image = atlas->GetImage();
+	this->offsetPxX = region->x;
+	this->offsetPxY = region->y;
+	this->spriteSheetWidth = region->width;
+	this->spriteSheetHeight = region->height;
+	return *this;
+}
+
 SpriteSheet* SpriteSheetBuilder::BuildAndReset() {
 	auto output = Build();
 	InitValues();
@@ -103,8 +119,8 @@ SpriteSheet* SpriteSheetBuilder::Build() {
 			throw std::invalid_argument("The size of the sprite sheet should be a multiple of the sprite size.");
 		}
 
-		columns = spriteSheetWidth % spriteWidth;
-		rows = spriteSheetHeight % spriteHeight;
+		columns = spriteSheetWidth / spriteWidth;
+		rows = spriteSheetHeight / spriteHeight;
 		this->totalFrames = columns * rows;
 	}
 
@@ -9,6 +9,7 @@ namespace jsonxx {
 using namespace std;
 
 class SpriteSheet;
+class SpriteAtlas;
 
 /**
  * Builds sprite sheets from various attributes. Some of them are calculated from others.
@@ -38,6 +39,13 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Appends a region of a packed sprite atlas as the whole sprite sheet
+	 * Offsets are taken from the place the image was packed to, hence the sheet is built the same way as from the original image
+	 * @param path path of the original image, added to the atlas
+	 */
+	SpriteSheetBuilder& Region(SpriteAtlas* atlas, const string& path);
+
 	/**
 	 * Appends an offset in number of blocks
 	 * Note that size of block is the same as size of one sprite declared with spriteWidth and spriteHeight
@@ -116,11 +124,13 @@ private:
 		image = nullptr;
 		offsetPxX = 0;
 		offsetPxY = 0;
+		offsetBlockX = 0;
+		offsetBlockY = 0;
 		spriteWidth = 0;
 		spriteHeight = 0;
 		spriteSheetWidth = 0;
 		spriteSheetHeight = 0;
 		totalFrames = 0;
-		string name = "";
+		name = "";
 	}
 };
\ No newline at end of file
@@ -1,10 +1,167 @@
 #include "SpriteSheetRenderer.h"
+#include "GLRenderBackend.h"
 #include "AphUtils.h"
 #include "ofLog.h"
+#include <cstring>
+
+#if !defined(SPRITE_SIMD_DISABLED)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define SPRITE_SIMD_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPRITE_SIMD_NEON
+#endif
+#endif
+
+/**
+* Gets corners of the tile on the texture, in texels
+*/
+static inline void GetTileTexCoords(const SpriteTile& tile, float& x1, float& y1, float& x2, float& y2) {
+	switch (tile.dir) {
+	case NONE:
+	default:
+		// rounding errors elimination
+		x1 = tile.offsetX + 0.5f;
+		y1 = tile.offsetY + 0.5f;
+		x2 = tile.offsetX + tile.width - 0.5f;
+		y2 = tile.offsetY + tile.height - 0.5f;
+		break;
+	case HORIZONTALLY:
+		x1 = tile.offsetX + tile.width;
+		y1 = tile.offsetY;
+		x2 = tile.offsetX;
+		y2 = tile.offsetY + tile.height;
+		break;
+	case VERTICALLY:
+		x1 = tile.offsetX;
+		y1 = tile.offsetY + tile.height;
+		x2 = tile.offsetX + tile.width;
+		y2 = tile.offsetY;
+		break;
+	case HORIZ_VERT:
+		x1 = tile.offsetX + tile.width;
+		y1 = tile.offsetY + tile.height;
+		x2 = tile.offsetX;
+		y2 = tile.offsetY;
+		break;
+	}
+}
+
+/**
+* Converts a coordinate in texels into halves of texels stored in a vertex
+*/
+static inline short ToTexCoord(float coord) {
+	// all coordinates of tiles are multiples of a half
+	return (short)(coord * 2 + 0.5f);
+}
+
+#if defined(SPRITE_SIMD_SSE) || defined(SPRITE_SIMD_NEON)
+// thin wrapper over 4-wide float vectors of the platform
+#ifdef SPRITE_SIMD_SSE
+typedef __m128 Float4;
+
+inline Float4 Load4(const float* ptr) { return _mm_loadu_ps(ptr); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+
+// transposes i-th lanes of all components into a vertex of i-th quad
+inline void StoreVertices(SpriteQuad* quads, int vertex, Float4 x, Float4 y, Float4 uv, Float4 color) {
+	Float4 xy01 = _mm_unpacklo_ps(x, y);
+	Float4 xy23 = _mm_unpackhi_ps(x, y);
+	Float4 uc01 = _mm_unpacklo_ps(uv, color);
+	Float4 uc23 = _mm_unpackhi_ps(uv, color);
+	_mm_storeu_ps(&quads[0].vertices[vertex].x, _mm_movelh_ps(xy01, uc01));
+	_mm_storeu_ps(&quads[1].vertices[vertex].x, _mm_movehl_ps(uc01, xy01));
+	_mm_storeu_ps(&quads[2].vertices[vertex].x, _mm_movelh_ps(xy23, uc23));
+	_mm_storeu_ps(&quads[3].vertices[vertex].x, _mm_movehl_ps(uc23, xy23));
+}
+#else
+typedef float32x4_t Float4;
+
+inline Float4 Load4(const float* ptr) { return vld1q_f32(ptr); }
+inline Float4 Add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+
+// transposes i-th lanes of all components into a vertex of i-th quad
+inline void StoreVertices(SpriteQuad* quads, int vertex, Float4 x, Float4 y, Float4 uv, Float4 color) {
+	float32x4x2_t xy = vzipq_f32(x, y);
+	float32x4x2_t uc = vzipq_f32(uv, color);
+	vst1q_f32(&quads[0].vertices[vertex].x, vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(uc.val[0])));
+	vst1q_f32(&quads[1].vertices[vertex].x, vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(uc.val[0])));
+	vst1q_f32(&quads[2].vertices[vertex].x, vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(uc.val[1])));
+	vst1q_f32(&quads[3].vertices[vertex].x, vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(uc.val[1])));
+}
+#endif
+
+/**
+* Packs two values of a vertex into a lane of a float vector, their bits are only moved
+*/
+template<typename T>
+static inline float PackLane(T first, T second) {
+	T values[2] = { first, second };
+	float lane;
+	memcpy(&lane, values, sizeof(lane));
+	return lane;
+}
+
+/**
+* Creates complete quads of SPRITE_SIMD_WIDTH tiles at once
+* Corners are calculated in the same order of operations as SpriteSheetRenderer::MakeQuad, hence the results are equal;
+* whole vertices are then written by 16-byte stores
+*/
+static void MakeQuadsSimd(SpriteQuad* quads, const SpriteTile* tiles) {
+	float x[SPRITE_SIMD_WIDTH], y[SPRITE_SIMD_WIDTH], w[SPRITE_SIMD_WIDTH], h[SPRITE_SIMD_WIDTH];
+	float cosines[SPRITE_SIMD_WIDTH], sines[SPRITE_SIMD_WIDTH];
+	// texture coordinates of each corner and colors, packed as in SpriteVertex
+	float uv[4][SPRITE_SIMD_WIDTH], colors[SPRITE_SIMD_WIDTH];
+
+	for (int i = 0; i < SPRITE_SIMD_WIDTH; i++) {
+		const SpriteTile& tile = tiles[i];
+		x[i] = tile.posX;
+		y[i] = tile.posY;
+		w[i] = tile.width*tile.scaleX / 2.0f;
+		h[i] = tile.height*tile.scaleY / 2.0f;
+		cosines[i] = tile.rotation == 0 ? 1 : cosf(tile.rotation);
+		sines[i] = tile.rotation == 0 ? 0 : sinf(tile.rotation);
+
+		float x1, y1, x2, y2;
+		GetTileTexCoords(tile, x1, y1, x2, y2);
+		short u1 = ToTexCoord(x1), v1 = ToTexCoord(y1), u2 = ToTexCoord(x2), v2 = ToTexCoord(y2);
+		uv[0][i] = PackLane(u1, v1);
+		uv[1][i] = PackLane(u2, v1);
+		uv[2][i] = PackLane(u1, v2);
+		uv[3][i] = PackLane(u2, v2);
+		unsigned char rgba[4] = { tile.col.r, tile.col.g, tile.col.b, tile.col.a };
+		memcpy(&colors[i], rgba, sizeof(float));
+	}
+
+	Float4 posX = Load4(x);
+	Float4 posY = Load4(y);
+	Float4 halfW = Load4(w);
+	Float4 halfH = Load4(h);
+	Float4 c = Load4(cosines);
+	Float4 s = Load4(sines);
+	Float4 color = Load4(colors);
+
+	Float4 wc = Mul4(halfW, c);
+	Float4 hs = Mul4(halfH, s);
+	Float4 ws = Mul4(halfW, s);
+	Float4 hc = Mul4(halfH, c);
+
+	StoreVertices(quads, 0, Add4(Sub4(posX, wc), hs), Sub4(Sub4(posY, ws), hc), Load4(uv[0]), color);
+	StoreVertices(quads, 1, Add4(Add4(posX, wc), hs), Sub4(Add4(posY, ws), hc), Load4(uv[1]), color);
+	StoreVertices(quads, 2, Sub4(Sub4(posX, wc), hs), Add4(Sub4(posY, ws), hc), Load4(uv[2]), color);
+	StoreVertices(quads, 3, Sub4(Add4(posX, wc), hs), Add4(Add4(posY, ws), hc), Load4(uv[3]), color);
+}
+#endif
 
 SpriteSheetRenderer::SpriteSheetRenderer() {
 	buffers = map<string, SpriteLayer*>();
 	actualBuffer = nullptr;
+	backend = GLRenderBackend::GetInstance();
 }
 
 SpriteSheetRenderer::~SpriteSheetRenderer() {
@@ -14,9 +171,29 @@ SpriteSheetRenderer::~SpriteSheetRenderer() {
 }
 
 
+int SpriteSheetRenderer::GetLayerHandle(const string& sheetName) {
+	static map<string, int> handles;
+
+	auto found = handles.find(sheetName);
+	if (found != handles.end()) {
+		return found->second;
+	}
+
+	int handle = handles.size();
+	handles[sheetName] = handle;
+	return handle;
+}
+
 void SpriteSheetRenderer::LoadTexture(ofTexture * texture, string sheetName, int bufferSize, int zIndex, bool isExternal) {
 	if (buffers.count(sheetName) == 0) {
-		buffers[sheetName] = new SpriteLayer(zIndex);
+		auto layer = new SpriteLayer(zIndex, backend);
+		buffers[sheetName] = layer;
+
+		int handle = GetLayerHandle(sheetName);
+		if (handle >= (int)layersByHandle.size()) {
+			layersByHandle.resize(handle + 1, nullptr);
+		}
+		layersByHandle[handle] = layer;
 	}
 
 	ClearCounters(sheetName);
@@ -30,23 +207,14 @@ void SpriteSheetRenderer::LoadTexture(ofTexture * texture, string sheetName, int
 void SpriteSheetRenderer::ReallocateBuffer(string sheetName, int bufferSize) {
 	SetActualBuffer(sheetName);
 
-	actualBuffer->bufferSize = bufferSize;
-
-	if (actualBuffer->verts != nullptr)
-		delete[] actualBuffer->verts;
-	if (actualBuffer->coords != nullptr)
-		delete[] actualBuffer->coords;
-	if (actualBuffer->colors != nullptr)
-		delete[] actualBuffer->colors;
-
-	// 18 vertices for one quad (2 triangles and 3 axis -> 2*3*3)
-	actualBuffer->verts = new float[actualBuffer->bufferSize * 18];
-	// 12 texture coordinates for one quad (2 triangles and 2 axis -> 2*3*2)
-	actualBuffer->coords = new float[actualBuffer->bufferSize * 12];
-	// 24 colors for one quad (2 triangles and 4 channels -> 2*3*4)
-	actualBuffer->colors = new unsigned char[actualBuffer->bufferSize * 24];
-
 	actualBuffer->numSprites = 0;
+	actualBuffer->writtenSprites = 0;
+	actualBuffer->minBufferSize = bufferSize;
+	actualBuffer->quietFrames = 0;
+	actualBuffer->Resize(bufferSize);
+	// statistics start with the new buffer
+	actualBuffer->peakSprites = 0;
+	actualBuffer->reallocations = 0;
 
 	ClearCounters(sheetName);
 	ClearTexture(sheetName);
@@ -58,23 +226,73 @@ bool SpriteSheetRenderer::AddTile(SpriteTile& tile) {
 		return false;
 	}
 
-	if (actualBuffer->numSprites >= actualBuffer->bufferSize) {
-		ofLogError(string_format("Texture buffer overflown! Maximum number of sprites is set to %d", actualBuffer->bufferSize));
+	ReserveSprites(1);
+	SpriteQuad& quad = GetActualQuad();
+
+	BeginSprite();
+	AddTexCoords(quad, tile);
+	MakeQuad(quad, tile);
+	MakeColorQuad(quad, tile.col);
+	EndSprite();
+
+	return true;
+}
+
+bool SpriteSheetRenderer::AddTiles(const SpriteTile* tiles, int count) {
+	if (actualBuffer == nullptr || actualBuffer->texture == nullptr) {
+		ofLogError("Cannot add tile since there is no texture loaded");
 		return false;
 	}
 
-	int vertexOffset = GetVertexOffset();
-	int colorOffset = GetColorOffset();
+	ReserveSprites(count);
+	int first = actualBuffer->numSprites;
+	SpriteQuad* quads = &actualBuffer->quads[first];
+	// number of sprites that are going to be overwritten and compared
+	int compared = 0;
+
+	if (gpuBuffersEnabled) {
+		compared = max(0, min(count, actualBuffer->writtenSprites - first));
+		previousQuads.assign(quads, quads + compared);
+	}
 
-	AddTexCoords(tile);
-	MakeQuad(vertexOffset, tile);
-	MakeColorQuad(colorOffset, tile.col);
+	MakeQuads(quads, tiles, count);
 
-	actualBuffer->numSprites++;
+	actualBuffer->numSprites += count;
+
+	if (gpuBuffersEnabled) {
+		for (int i = 0; i < count; i++) {
+			if (i >= compared || memcmp(&previousQuads[i], &quads[i], sizeof(SpriteQuad)) != 0) {
+				actualBuffer->MarkDirty(first + i);
+			}
+		}
+		actualBuffer->writtenSprites = max(actualBuffer->writtenSprites, first + count);
+	}
 
 	return true;
 }
 
+int SpriteSheetRenderer::AppendSprites(int layerHandle, int count) {
+	SetActualBuffer(layerHandle);
+	ReserveSprites(count);
+	int first = actualBuffer->numSprites;
+	actualBuffer->numSprites += count;
+	return first;
+}
+
+void SpriteSheetRenderer::EndAppendedSprites(int layerHandle, int first, int count, int dirtyFrom, int dirtyTo) {
+	if (gpuBuffersEnabled) {
+		SpriteLayer* layer = GetLayer(layerHandle);
+
+		if (dirtyFrom < dirtyTo) {
+			// both ends extend the dirty range to the whole interval
+			layer->MarkDirty(dirtyFrom);
+			layer->MarkDirty(dirtyTo - 1);
+		}
+
+		layer->writtenSprites = max(layer->writtenSprites, first + count);
+	}
+}
+
 bool SpriteSheetRenderer::AddRect(float x, float y, float z, float w, float h, float scale, float rot, ofColor& col) {
 
 	if (actualBuffer == nullptr || actualBuffer->texture == nullptr) {
@@ -82,34 +300,32 @@ bool SpriteSheetRenderer::AddRect(float x, float y, float z, float w, float h, f
 		return false;
 	}
 
-	if (actualBuffer->numSprites >= actualBuffer->bufferSize) {
-		ofLogError(string_format("Texture buffer overflown! Maximum number of sprites is set to %d", actualBuffer->bufferSize));
-		return false;
-	}
-
-	int vertexOffset = GetVertexOffset();
-	int colorOffset = GetColorOffset();
-	int coordOffset = GetCoordOffset();
+	ReserveSprites(1);
+	SpriteQuad& quad = GetActualQuad();
 
 	w = w*scale / 2;
 	h = h*scale / 2;
 
+	BeginSprite();
+
 	// create vertices
-	MakeQuad(vertexOffset, x + GetX(-w, -h, rot), y + GetY(-w, -h, rot), z,
-		x + GetX(w, -h, rot), y + GetY(w, -h, rot), z,
-		x + GetX(-w, h, rot), y + GetY(-w, h, rot), z,
-		x + GetX(w, h, rot), y + GetY(w, h, rot), z);
+	MakeQuad(quad, x + GetX(-w, -h, rot), y + GetY(-w, -h, rot),
+		x + GetX(w, -h, rot), y + GetY(w, -h, rot),
+		x + GetX(-w, h, rot), y + GetY(-w, h, rot),
+		x + GetX(w, h, rot), y + GetY(w, h, rot));
 
-	MakeColorQuad(colorOffset, col);
+	MakeColorQuad(quad, col);
 	int halfBrushSize = actualBuffer->textureCoeffX / 2;
-	AddTexCoords(coordOffset, brushX + halfBrushSize, brushY + halfBrushSize, brushX + halfBrushSize, brushY + halfBrushSize);
-	actualBuffer->numSprites++;
+	AddTexCoords(quad, brushX + halfBrushSize, brushY + halfBrushSize, brushX + halfBrushSize, brushY + halfBrushSize);
+	EndSprite();
 	return true;
 }
 
 void SpriteSheetRenderer::ClearCounters(string sheetName) {
 	SetActualBuffer(sheetName);
 	actualBuffer->numSprites = 0;
+	actualBuffer->instanceBuffers.clear();
+	actualBuffer->chunks.clear();
 }
 
 void SpriteSheetRenderer::ClearTexture(string sheetName) {
@@ -133,10 +349,29 @@ void SpriteSheetRenderer::SetActualBuffer(string sheetName) {
 	else actualBuffer = nullptr;
 }
 
+void SpriteSheetRenderer::SetGpuBuffersEnabled(bool enabled) {
+	gpuBuffersEnabled = enabled;
+
+	for (auto& buf : buffers) {
+		buf.second->ReleaseGpuBuffers();
+		// sprites written while the buffers were disabled weren't compared
+		buf.second->writtenSprites = 0;
+	}
+}
+
+void SpriteSheetRenderer::SetBackend(RenderBackend* backend) {
+	for (auto& buf : buffers) {
+		// buffer objects can be deleted only by the backend that has created them
+		buf.second->ReleaseGpuBuffers();
+		buf.second->backend = backend;
+		buf.second->writtenSprites = 0;
+	}
+
+	this->backend = backend;
+}
+
 void SpriteSheetRenderer::Draw() {
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	uploadedBytes = 0;
 
 	// copy layers into vector and sort it by z-index
 	vector<SpriteLayer*> buffs;
@@ -154,99 +389,193 @@ void SpriteSheetRenderer::Draw() {
 	for (auto it = buffs.begin(); it != buffs.end(); ++it) {
 		SpriteLayer* buff = (*it);
 
-		if (buff->numSprites > 0) {
-			glVertexPointer(3, GL_FLOAT, 0, &buff->verts[0]);
-			glColorPointer(4, GL_UNSIGNED_BYTE, 0, &buff->colors[0]);
-			glTexCoordPointer(2, GL_FLOAT, 0, &buff->coords[0]);
+		// baked chunks lie below the other sprites of the layer, e.g. a background
+		for (auto chunk : buff->chunks) {
+			unsigned int buffer = UploadChunk(chunk);
+			backend->DrawSpriteQuads(buff, buffer, chunk->quads.size());
+		}
+
+		if (gpuBuffersEnabled && buff->bufferSize > 0) {
+			// buffer objects cycle each frame, even if the layer is empty
+			unsigned int buffer = UploadGpuBuffer(buff);
 
-			buff->texture->bind();
-			glDrawArrays(GL_TRIANGLES, 0, buff->numSprites * 6);
-			buff->texture->unbind();
+			if (buff->numSprites > 0) {
+				backend->DrawSpriteQuads(buff, buffer, buff->numSprites);
+			}
 		}
+		else if (buff->numSprites > 0) {
+			backend->DrawSpriteQuads(buff, 0, buff->numSprites);
+			uploadedBytes += buff->numSprites * sizeof(SpriteQuad);
+		}
+
+		// instanced meshes are drawn from their own buffer objects, regardless of gpu buffers of the layer
+		for (auto instances : buff->instanceBuffers) {
+			unsigned int buffer = UploadInstances(instances);
+			backend->DrawSpriteInstances(buff, buffer, instances->instances.size());
+		}
+
+		EndLayerFrame(buff);
+	}
+}
+
+void SpriteSheetRenderer::EndLayerFrame(SpriteLayer* layer) {
+	layer->peakSprites = max(layer->peakSprites, layer->numSprites);
+
+	if (shrinkFrames == 0 || layer->bufferSize <= layer->minBufferSize
+		|| layer->numSprites * SPRITE_LAYER_QUIET_RATIO > layer->bufferSize) {
+		layer->quietFrames = 0;
+		return;
 	}
 
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	if (++layer->quietFrames >= shrinkFrames) {
+		// sprites of this frame have been drawn, but they stay in the buffer, since the next frame may only update them
+		layer->Resize(max(layer->minBufferSize, layer->bufferSize / 2));
+		layer->quietFrames = 0;
+	}
 }
 
+void SpriteSheetRenderer::BeginSprite() {
+	int index = actualBuffer->numSprites;
 
-void SpriteSheetRenderer::AddTexCoords(SpriteTile& tile) {
+	if (gpuBuffersEnabled && index < actualBuffer->writtenSprites) {
+		previousQuad = actualBuffer->quads[index];
+	}
+}
 
-	int coordOffset = GetCoordOffset();
+void SpriteSheetRenderer::EndSprite() {
+	int index = actualBuffer->numSprites++;
 
-	float x1, y1, x2, y2;
+	if (gpuBuffersEnabled) {
+		if (index >= actualBuffer->writtenSprites) {
+			// there is nothing to compare with
+			actualBuffer->writtenSprites = index + 1;
+			actualBuffer->MarkDirty(index);
+		}
+		else if (memcmp(&previousQuad, &actualBuffer->quads[index], sizeof(SpriteQuad)) != 0) {
+			actualBuffer->MarkDirty(index);
+		}
+	}
+}
 
-	switch (tile.dir) {
-	case NONE:
-		// rounding errors elimination
-		x1 = tile.offsetX + 0.5f;
-		y1 = tile.offsetY + 0.5f;
-		x2 = tile.offsetX + tile.width - 0.5f;
-		y2 = tile.offsetY + tile.height - 0.5f;
-		break;
-	case HORIZONTALLY:
-		x1 = tile.offsetX + tile.width;
-		y1 = tile.offsetY;
-		x2 = tile.offsetX;
-		y2 = tile.offsetY + tile.height;
-		break;
-	case VERTICALLY:
-		x1 = tile.offsetX;
-		y1 = tile.offsetY + tile.height;
-		x2 = tile.offsetX + tile.width;
-		y2 = tile.offsetY;
-		break;
-	case HORIZ_VERT:
-		x1 = tile.offsetX + tile.width;
-		y1 = tile.offsetY + tile.height;
-		x2 = tile.offsetX;
-		y2 = tile.offsetY;
-		break;
-	default:
-		break;
+unsigned int SpriteSheetRenderer::UploadGpuBuffer(SpriteLayer* layer) {
+	int current = layer->gpuCurrent = (layer->gpuCurrent + 1) % SPRITE_LAYER_GPU_BUFFERS;
+
+	if (layer->gpuBuffers[current] == 0) {
+		layer->gpuBuffers[current] = backend->CreateBuffer(sizeof(SpriteQuad) * layer->bufferSize);
+		layer->gpuValidSprites[current] = 0;
 	}
 
-	float* coords = actualBuffer->coords;
+	// sprites that have changed since this buffer was drawn the last time...
+	int from = layer->gpuDirtyFrom[current];
+	int to = min(layer->gpuDirtyTo[current], layer->numSprites);
 
-	coords[coordOffset] = coords[coordOffset + 4] = coords[coordOffset + 8] = x1*actualBuffer->textureCoeffX;
-	coords[coordOffset + 1] = coords[coordOffset + 3] = coords[coordOffset + 7] = y1*actualBuffer->textureCoeffY;
-	coords[coordOffset + 2] = coords[coordOffset + 6] = coords[coordOffset + 10] = x2*actualBuffer->textureCoeffX;
-	coords[coordOffset + 5] = coords[coordOffset + 9] = coords[coordOffset + 11] = y2*actualBuffer->textureCoeffY;
+	if (layer->gpuValidSprites[current] < layer->numSprites) {
+		// ...and sprites the buffer doesn't contain at all
+		from = (from < to) ? min(from, layer->gpuValidSprites[current]) : layer->gpuValidSprites[current];
+		to = layer->numSprites;
+	}
+
+	if (from < to) {
+		int count = to - from;
+		backend->UpdateBuffer(layer->gpuBuffers[current], sizeof(SpriteQuad) * from, sizeof(SpriteQuad) * count, &layer->quads[from]);
+		uploadedBytes += count * sizeof(SpriteQuad);
+	}
+
+	layer->gpuValidSprites[current] = layer->numSprites;
+	layer->gpuDirtyFrom[current] = layer->gpuDirtyTo[current] = 0;
+	return layer->gpuBuffers[current];
 }
 
-void SpriteSheetRenderer::AddTexCoords(FlipDirection f, float posX, float posY, float w, float h) {
-	int coordOffset = GetCoordOffset();
+unsigned int SpriteSheetRenderer::UploadInstances(SpriteInstanceBuffer* instances) {
+	int count = instances->instances.size();
+
+	if (instances->buffer == 0 || instances->backend != backend || instances->capacity < count) {
+		// the buffer grows geometrically, as the buffers of layers do
+		int capacity = max(count, instances->capacity * 2);
+		instances->Release();
+		instances->backend = backend;
+		instances->buffer = backend->CreateBuffer(sizeof(SpriteInstance) * capacity);
+		instances->capacity = capacity;
+		// the new buffer object contains nothing
+		instances->dirtyRuns.clear();
+		instances->dirtyRuns.push_back(0);
+		instances->dirtyRuns.push_back(count);
+	}
+
+	for (int i = 0; i < (int)instances->dirtyRuns.size(); i += 2) {
+		// instances may have been removed since the run was marked
+		int from = instances->dirtyRuns[i];
+		int to = min(instances->dirtyRuns[i + 1], count);
+
+		if (from < to) {
+			backend->UpdateBuffer(instances->buffer, sizeof(SpriteInstance) * from, sizeof(SpriteInstance) * (to - from), &instances->instances[from]);
+			uploadedBytes += (to - from) * sizeof(SpriteInstance);
+		}
+	}
+
+	instances->dirtyRuns.clear();
+	return instances->buffer;
+}
 
-	// for OPENGL-ES, the coefficients will clamp the w and h to range <0-1> 
-	w *= actualBuffer->textureCoeffX;
-	h *= actualBuffer->textureCoeffY;
+unsigned int SpriteSheetRenderer::UploadChunk(SpriteChunk* chunk) {
+	int count = chunk->quads.size();
+
+	if (chunk->buffer == 0 || chunk->backend != backend || chunk->capacity < count) {
+		int capacity = max(count, chunk->capacity * 2);
+		chunk->Release();
+		chunk->backend = backend;
+		chunk->buffer = backend->CreateBuffer(sizeof(SpriteQuad) * capacity);
+		chunk->capacity = capacity;
+	}
+
+	if (chunk->isDirty) {
+		// chunks are small and they change rarely, hence they are uploaded as a whole
+		backend->UpdateBuffer(chunk->buffer, 0, sizeof(SpriteQuad) * count, chunk->quads.data());
+		uploadedBytes += count * sizeof(SpriteQuad);
+		chunk->isDirty = false;
+	}
+
+	return chunk->buffer;
+}
+
+void SpriteSheetRenderer::AddTexCoords(SpriteQuad& quad, const SpriteTile& tile) {
+	float x1, y1, x2, y2;
+	GetTileTexCoords(tile, x1, y1, x2, y2);
+	AddTexCoords(quad, x1, y1, x2, y2);
+}
+
+void SpriteSheetRenderer::AddTexCoords(FlipDirection f, float posX, float posY, float w, float h) {
+	SpriteQuad& quad = GetActualQuad();
 
 	switch (f) {
 	case NONE:
-		AddTexCoords(coordOffset, posX, posY, posX + w, posY + h);
+		AddTexCoords(quad, posX, posY, posX + w, posY + h);
 		break;
 	case HORIZONTALLY:
-		AddTexCoords(coordOffset, posX + w, posY, posX, posY + h);
+		AddTexCoords(quad, posX + w, posY, posX, posY + h);
 		break;
 	case VERTICALLY:
-		AddTexCoords(coordOffset, posX, posY + h, posX + w, posY);
+		AddTexCoords(quad, posX, posY + h, posX + w, posY);
 		break;
 	case HORIZ_VERT:
-		AddTexCoords(coordOffset, posX + w, posY + h, posX, posY);
+		AddTexCoords(quad, posX + w, posY + h, posX, posY);
 		break;
 	default:
 		break;
 	}
 }
 
-void SpriteSheetRenderer::AddTexCoords(int offset, float x1, float y1, float x2, float y2) {
-
-	float* coords = actualBuffer->coords;
-	coords[offset] = coords[offset + 4] = coords[offset + 8] = x1;
-	coords[offset + 1] = coords[offset + 3] = coords[offset + 7] = y1;
-	coords[offset + 2] = coords[offset + 6] = coords[offset + 10] = x2;
-	coords[offset + 5] = coords[offset + 9] = coords[offset + 11] = y2;
+void SpriteSheetRenderer::AddTexCoords(SpriteQuad& quad, float x1, float y1, float x2, float y2) {
+	short u1 = ToTexCoord(x1);
+	short v1 = ToTexCoord(y1);
+	short u2 = ToTexCoord(x2);
+	short v2 = ToTexCoord(y2);
+
+	SpriteVertex* vertices = quad.vertices;
+	vertices[0].u = vertices[2].u = u1;
+	vertices[1].u = vertices[3].u = u2;
+	vertices[0].v = vertices[1].v = v1;
+	vertices[2].v = vertices[3].v = v2;
 }
 
 void SpriteSheetRenderer::SetTexCoeffs(int textureWidth, int textureHeight) {
@@ -259,68 +588,120 @@ void SpriteSheetRenderer::SetTexCoeffs(int textureWidth, int textureHeight) {
 #endif
 }
 
-void SpriteSheetRenderer::MakeQuad(int offset, SpriteTile& tile) {
+void SpriteSheetRenderer::MakeQuad(SpriteQuad& quad, const SpriteTile& tile) {
 
 	float w = tile.width*tile.scaleX / 2.0f;
 	float h = tile.height*tile.scaleY / 2.0f;
 	float x = tile.posX;
 	float y = tile.posY;
 	float rot = tile.rotation;
-	float* verts = actualBuffer->verts;
+	SpriteVertex* vertices = quad.vertices;
+
+	// corners rotated around the center, sin and cos are calculated only once
+	float c = rot == 0 ? 1 : cosf(rot);
+	float s = rot == 0 ? 0 : sinf(rot);
+	float wc = w*c;
+	float hs = h*s;
+	float ws = w*s;
+	float hc = h*c;
+
+	vertices[0].x = x - wc + hs;
+	vertices[0].y = y - ws - hc;
+	vertices[1].x = x + wc + hs;
+	vertices[1].y = y + ws - hc;
+	vertices[2].x = x - wc - hs;
+	vertices[2].y = y - ws + hc;
+	vertices[3].x = x + wc - hs;
+	vertices[3].y = y + ws + hc;
+}
 
-	verts[offset + 2] = verts[offset + 5] = verts[offset + 11] = verts[offset + 8] = verts[offset + 14] = verts[offset + 17] = tile.posZ;
+void SpriteSheetRenderer::MakeQuads(SpriteQuad* quads, const SpriteTile* tiles, int count) {
+	int i = 0;
 
-	if (rot == 0) {
-		// no rotation
-		verts[offset] = x + -w;
-		verts[offset + 1] = y + -h;
-		verts[offset + 3] = verts[offset + 9] = x + w;
-		verts[offset + 4] = verts[offset + 10] = y + -h;
-		verts[offset + 6] = verts[offset + 12] = x + -w;
-		verts[offset + 7] = verts[offset + 13] = y + h;
-		verts[offset + 15] = x + w;
-		verts[offset + 16] = y + h;
+#if defined(SPRITE_SIMD_SSE) || defined(SPRITE_SIMD_NEON)
+	for (; i + SPRITE_SIMD_WIDTH <= count; i += SPRITE_SIMD_WIDTH) {
+		MakeQuadsSimd(&quads[i], &tiles[i]);
 	}
-	else {
-		// calc with rotation
-		verts[offset] = x + GetX(-w, -h, rot);
-		verts[offset + 1] = y + GetY(-w, -h, rot);
-		verts[offset + 3] = verts[offset + 9] = x + GetX(w, -h, rot);
-		verts[offset + 4] = verts[offset + 10] = y + GetY(w, -h, rot);
-		verts[offset + 6] = verts[offset + 12] = x + GetX(-w, h, rot);
-		verts[offset + 7] = verts[offset + 13] = y + GetY(-w, h, rot);
-		verts[offset + 15] = x + GetX(w, h, rot);
-		verts[offset + 16] = y + GetY(w, h, rot);
+#endif
+
+	// the rest of the batch or the whole batch if there is no SIMD
+	for (; i < count; i++) {
+		MakeQuad(quads[i], tiles[i]);
+		AddTexCoords(quads[i], tiles[i]);
+		MakeColorQuad(quads[i], tiles[i].col);
 	}
 }
 
-void SpriteSheetRenderer::MakeQuad(int offset, float x1, float y1, float z1,
-	float x2, float y2, float z2, float x3, float y3, float z3, float x4, float y4, float z4) {
+void SpriteSheetRenderer::MakeInstances(SpriteInstance* instances, const SpriteTile* tiles, int count) {
+	for (int i = 0; i < count; i++) {
+		const SpriteTile& tile = tiles[i];
+		SpriteInstance& instance = instances[i];
+		instance.posX = tile.posX;
+		instance.posY = tile.posY;
+		instance.halfWidth = tile.width*tile.scaleX / 2.0f;
+		instance.halfHeight = tile.height*tile.scaleY / 2.0f;
+		instance.rotation = tile.rotation;
+
+		float x1, y1, x2, y2;
+		GetTileTexCoords(tile, x1, y1, x2, y2);
+		instance.u1 = ToTexCoord(x1);
+		instance.v1 = ToTexCoord(y1);
+		instance.u2 = ToTexCoord(x2);
+		instance.v2 = ToTexCoord(y2);
+
+		instance.r = tile.col.r;
+		instance.g = tile.col.g;
+		instance.b = tile.col.b;
+		instance.a = tile.col.a;
+	}
+}
 
-	float* verts = actualBuffer->verts;
+bool SpriteSheetRenderer::AddInstances(SpriteInstanceBuffer* instances) {
+	if (actualBuffer == nullptr || actualBuffer->texture == nullptr) {
+		ofLogError("Cannot add instances since there is no texture loaded");
+		return false;
+	}
+
+	if (!instances->instances.empty()) {
+		actualBuffer->instanceBuffers.push_back(instances);
+	}
 
-	verts[offset] = x1;
-	verts[offset + 1] = y1;
-	verts[offset + 2] = z1;
+	return true;
+}
 
-	verts[offset + 3] = verts[offset + 9] = x2;
-	verts[offset + 4] = verts[offset + 10] = y2;
-	verts[offset + 5] = verts[offset + 11] = z2;
+bool SpriteSheetRenderer::AddChunk(SpriteChunk* chunk) {
+	if (actualBuffer == nullptr || actualBuffer->texture == nullptr) {
+		ofLogError("Cannot add chunk since there is no texture loaded");
+		return false;
+	}
 
-	verts[offset + 6] = verts[offset + 12] = x3;
-	verts[offset + 7] = verts[offset + 13] = y3;
-	verts[offset + 8] = verts[offset + 14] = z3;
+	if (!chunk->quads.empty()) {
+		actualBuffer->chunks.push_back(chunk);
+	}
 
-	verts[offset + 15] = x4;
-	verts[offset + 16] = y4;
-	verts[offset + 17] = z4;
+	return true;
 }
 
-void SpriteSheetRenderer::MakeColorQuad(int offset, ofColor& col) {
-	unsigned char* colors = actualBuffer->colors;
+void SpriteSheetRenderer::MakeQuad(SpriteQuad& quad, float x1, float y1, float x2, float y2,
+	float x3, float y3, float x4, float y4) {
+
+	SpriteVertex* vertices = quad.vertices;
 
-	colors[offset] = colors[offset + 4] = colors[offset + 8] = colors[offset + 12] = colors[offset + 16] = colors[offset + 20] = col.r;
-	colors[offset + 1] = colors[offset + 5] = colors[offset + 9] = colors[offset + 13] = colors[offset + 17] = colors[offset + 21] = col.g;
-	colors[offset + 2] = colors[offset + 6] = colors[offset + 10] = colors[offset + 14] = colors[offset + 18] = colors[offset + 22] = col.b;
-	colors[offset + 3] = colors[offset + 7] = colors[offset + 11] = colors[offset + 15] = colors[offset + 19] = colors[offset + 23] = col.a;
+	vertices[0].x = x1;
+	vertices[0].y = y1;
+	vertices[1].x = x2;
+	vertices[1].y = y2;
+	vertices[2].x = x3;
+	vertices[2].y = y3;
+	vertices[3].x = x4;
+	vertices[3].y = y4;
+}
+
+void SpriteSheetRenderer::MakeColorQuad(SpriteQuad& quad, const ofColor& col) {
+	for (auto& vertex : quad.vertices) {
+		vertex.r = col.r;
+		vertex.g = col.g;
+		vertex.b = col.b;
+		vertex.a = col.a;
+	}
 }
@@ -1,10 +1,27 @@
 #pragma once
 
 #include "ofTexture.h"
+#include "RenderBackend.h"
+#include "BoundingBox.h"
 #include <map>
+#include <vector>
+#include <cstring>
+#include <algorithm>
 
 using namespace std;
 
+// number of buffer objects each layer cycles through when gpu buffers are enabled
+// the buffer that is being updated has been drawn two frames ago, hence the driver doesn't have to wait for it
+#define SPRITE_LAYER_GPU_BUFFERS 3
+// maximum number of sprites drawn by one call, limited by 16-bit indices of their vertices
+#define SPRITE_BATCH_MAX_SPRITES 16384
+// number of sprites whose corners are calculated at once by AddTiles
+#define SPRITE_SIMD_WIDTH 4
+// a frame is quiet for a layer if the layer uses at most 1/SPRITE_LAYER_QUIET_RATIO of its buffer
+#define SPRITE_LAYER_QUIET_RATIO 4
+// changed instances separated by at most this number of unchanged ones are uploaded by one update
+#define SPRITE_INSTANCE_UPLOAD_GAP 16
+
 
 /**
 * Flip direction of the rendered tile
@@ -63,6 +80,171 @@ struct SpriteTile {
 	ofColor col;
 };
 
+/**
+* Vertex of a sprite quad
+* Positions are two-dimensional, since layers are ordered by their z-index and sprites by the order they were added
+*/
+struct SpriteVertex {
+	float x;
+	float y;
+	// texture coordinates in halves of texels, they are scaled by the texture matrix when drawn
+	short u;
+	short v;
+	// vertex color
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+/**
+* Four vertices of a sprite: top-left, top-right, bottom-left and bottom-right
+* The quad is drawn as two triangles by a shared index buffer
+*/
+struct SpriteQuad {
+	SpriteVertex vertices[4];
+};
+
+/**
+* Sprite drawn by instancing; a unit quad is transformed by these data on the GPU
+* Corners are calculated in the same way as by SpriteSheetRenderer::MakeQuad
+*/
+struct SpriteInstance {
+	// center of the sprite
+	float posX;
+	float posY;
+	// halves of the scaled size
+	float halfWidth;
+	float halfHeight;
+	// rotation in radians
+	float rotation;
+	// texture coordinates of the top-left and the bottom-right corner in halves of texels, swapped if the sprite is flipped
+	short u1;
+	short v1;
+	short u2;
+	short v2;
+	// sprite color
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+/**
+* Instances of one mesh, kept in a buffer object between frames
+* Only runs of instances that have changed since the last upload are copied into the buffer object
+*/
+struct SpriteInstanceBuffer {
+	// instances of the last frame
+	vector<SpriteInstance> instances;
+	// pairs of the first and the end index of changed instances that haven't been uploaded yet
+	vector<int> dirtyRuns;
+	// backend that has created the buffer object
+	RenderBackend* backend = nullptr;
+	// buffer object, 0 if it hasn't been created yet
+	unsigned int buffer = 0;
+	// number of instances the buffer object can hold
+	int capacity = 0;
+
+	SpriteInstanceBuffer() {
+	}
+
+	// the buffer object can't be shared
+	SpriteInstanceBuffer(const SpriteInstanceBuffer&) = delete;
+	SpriteInstanceBuffer& operator=(const SpriteInstanceBuffer&) = delete;
+
+	/**
+	* Replaces the instances by new ones, marking those that differ as changed
+	*/
+	void Update(const SpriteInstance* data, int count) {
+		int compared = min(count, (int)instances.size());
+		instances.resize(count);
+
+		for (int i = 0; i < count; i++) {
+			if (i >= compared || memcmp(&instances[i], &data[i], sizeof(SpriteInstance)) != 0) {
+				instances[i] = data[i];
+				MarkDirty(i);
+			}
+		}
+	}
+
+	/**
+	* Marks instance at given index as changed; close runs are merged
+	*/
+	inline void MarkDirty(int index) {
+		int runs = dirtyRuns.size();
+
+		if (runs != 0 && index >= dirtyRuns[runs - 2] && index <= dirtyRuns[runs - 1] + SPRITE_INSTANCE_UPLOAD_GAP) {
+			dirtyRuns[runs - 1] = max(dirtyRuns[runs - 1], index + 1);
+		}
+		else {
+			dirtyRuns.push_back(index);
+			dirtyRuns.push_back(index + 1);
+		}
+	}
+
+	/**
+	* Deletes the buffer object; it will be created and filled again by the next draw
+	*/
+	void Release() {
+		if (buffer != 0) {
+			backend->DeleteBuffer(buffer);
+			buffer = 0;
+		}
+
+		capacity = 0;
+		dirtyRuns.clear();
+	}
+
+	~SpriteInstanceBuffer() {
+		Release();
+	}
+};
+
+/**
+* Quads baked once and drawn from their own buffer object, e.g. a chunk of a tile map
+* The quads are uploaded again only after they have been baked again
+*/
+struct SpriteChunk {
+	vector<SpriteQuad> quads;
+	// area covered by the quads, in absolute coordinates
+	BoundingBox bounds;
+	// indicator whether the quads are up to date
+	bool isBaked = false;
+	// indicator whether the quads have been baked since they were uploaded
+	bool isDirty = true;
+	// backend that has created the buffer object
+	RenderBackend* backend = nullptr;
+	// buffer object, 0 if it hasn't been created yet
+	unsigned int buffer = 0;
+	// number of quads the buffer object can hold
+	int capacity = 0;
+
+	SpriteChunk() {
+	}
+
+	// the buffer object can't be shared
+	SpriteChunk(const SpriteChunk&) = delete;
+	SpriteChunk& operator=(const SpriteChunk&) = delete;
+
+	/**
+	* Deletes the buffer object; it will be created and filled again by the next draw
+	*/
+	void Release() {
+		if (buffer != 0) {
+			backend->DeleteBuffer(buffer);
+			buffer = 0;
+		}
+
+		capacity = 0;
+		isDirty = true;
+	}
+
+	~SpriteChunk() {
+		Release();
+	}
+};
+
 /**
 * Buffer for one rendered layer, contains vertex data
 */
@@ -79,58 +261,166 @@ struct SpriteLayer {
 	bool textureIsExternal;
 	// pointer to texture
 	ofTexture* texture;
-	// vertex data
-	float* verts;
-	// texture coordinates data
-	float* coords;
-	// color data
-	unsigned char * colors;
-
-	// size of the buffer
+	// interleaved vertex data, one quad per sprite
+	SpriteQuad* quads;
+	// instanced meshes added in this frame, drawn on top of the quads
+	vector<SpriteInstanceBuffer*> instanceBuffers;
+	// baked chunks added in this frame, drawn below the quads
+	vector<SpriteChunk*> chunks;
+
+	// size of the buffer, grows when more sprites are added
 	int bufferSize;
+	// size requested when the layer was loaded, the buffer never shrinks below it
+	int minBufferSize;
 	// total number of sprites
 	int numSprites;
-
-	SpriteLayer(int zIndex) : zIndex(zIndex) {
+	// number of sprites whose data have been written into the arrays since the last reallocation
+	int writtenSprites;
+	// highest number of sprites drawn in one frame
+	int peakSprites;
+	// number of times the buffer has been resized
+	int reallocations;
+	// number of consecutive quiet frames, see SPRITE_LAYER_QUIET_RATIO
+	int quietFrames;
+
+	// backend that creates and draws the buffer objects
+	RenderBackend* backend;
+	// buffer objects the layer cycles through, 0 if a buffer hasn't been created yet
+	unsigned int gpuBuffers[SPRITE_LAYER_GPU_BUFFERS];
+	// number of sprites whose data are up to date in each buffer object
+	int gpuValidSprites[SPRITE_LAYER_GPU_BUFFERS];
+	// range of sprites that have changed since each buffer object was updated
+	int gpuDirtyFrom[SPRITE_LAYER_GPU_BUFFERS];
+	int gpuDirtyTo[SPRITE_LAYER_GPU_BUFFERS];
+	// index of the buffer object that was drawn last
+	int gpuCurrent;
+
+	SpriteLayer(int zIndex, RenderBackend* backend) : zIndex(zIndex), backend(backend) {
 		texture = nullptr;
-		verts = nullptr;
-		coords = nullptr;
-		colors = nullptr;
+		quads = nullptr;
 		bufferSize = 0;
+		minBufferSize = 0;
+		numSprites = 0;
+		writtenSprites = 0;
+		peakSprites = 0;
+		reallocations = 0;
+		quietFrames = 0;
+		gpuCurrent = 0;
+
+		for (int i = 0; i < SPRITE_LAYER_GPU_BUFFERS; i++) {
+			gpuBuffers[i] = 0;
+			gpuValidSprites[i] = 0;
+			gpuDirtyFrom[i] = gpuDirtyTo[i] = 0;
+		}
 
 		textureIsExternal = false;
 	}
 
+	/**
+	* Marks sprite at given index as changed for all buffer objects
+	*/
+	inline void MarkDirty(int index) {
+		for (int i = 0; i < SPRITE_LAYER_GPU_BUFFERS; i++) {
+			if (gpuDirtyFrom[i] >= gpuDirtyTo[i]) {
+				// empty range
+				gpuDirtyFrom[i] = index;
+				gpuDirtyTo[i] = index + 1;
+			}
+			else {
+				if (index < gpuDirtyFrom[i]) gpuDirtyFrom[i] = index;
+				if (index >= gpuDirtyTo[i]) gpuDirtyTo[i] = index + 1;
+			}
+		}
+	}
+
+	/**
+	* Deletes all buffer objects; they will be created and filled again by the next draw
+	*/
+	void ReleaseGpuBuffers() {
+		for (int i = 0; i < SPRITE_LAYER_GPU_BUFFERS; i++) {
+			if (gpuBuffers[i] != 0) {
+				backend->DeleteBuffer(gpuBuffers[i]);
+				gpuBuffers[i] = 0;
+			}
+			gpuValidSprites[i] = 0;
+			gpuDirtyFrom[i] = gpuDirtyTo[i] = 0;
+		}
+	}
+
+	/**
+	* Changes size of the buffer, keeping data of sprites that fit into the new size
+	* Buffer objects are deleted, since their size has to change as well
+	*/
+	void Resize(int size) {
+		SpriteQuad* resized = new SpriteQuad[size];
+		int kept = min(max(numSprites, writtenSprites), size);
+
+		if (quads != nullptr) {
+			memcpy(resized, quads, sizeof(SpriteQuad) * kept);
+			delete[] quads;
+		}
+
+		quads = resized;
+		bufferSize = size;
+		numSprites = min(numSprites, size);
+		writtenSprites = min(writtenSprites, size);
+		reallocations++;
+		ReleaseGpuBuffers();
+	}
+
 	~SpriteLayer() {
 		if (texture != nullptr) {
 			if (textureIsExternal) texture->clear();
 			else delete texture;
 		}
 
-		if (verts != nullptr)
-			delete[] verts;
-		if (coords != nullptr)
-			delete[] coords;
-		if (colors != nullptr)
-			delete[] colors;
+		if (quads != nullptr)
+			delete[] quads;
+
+		ReleaseGpuBuffers();
 	}
 };
 
 
 /**
- * Class that renders sprites using OpenGL api
+ * Class that renders sprites through a render backend, OpenGL by default
+ *
+ * By default, vertex data are passed to the driver from client-side arrays each frame
+ * If gpu buffers are enabled, each layer keeps its data in buffer objects and uploads only
+ * the range of sprites that have changed since the buffer object was updated the last time
  */
 class SpriteSheetRenderer {
 protected:
 	float brushX;
 	float brushY;
 	map<string, SpriteLayer*> buffers;
+	// layers indexed by their handles, nullptr for handles of layers that haven't been loaded
+	vector<SpriteLayer*> layersByHandle;
 	SpriteLayer* actualBuffer;
+	// indicator whether the layers are drawn from buffer objects
+	bool gpuBuffersEnabled = false;
+	// number of quiet frames after which buffers of layers shrink, 0 if they never shrink
+	int shrinkFrames = 0;
+	// number of bytes of vertex data sent to the driver by the last draw
+	int uploadedBytes = 0;
+	// data of the sprite that is being overwritten, used to find out whether it has changed
+	SpriteQuad previousQuad;
+	// data of sprites overwritten by a batch
+	vector<SpriteQuad> previousQuads;
+	// backend that draws the layers
+	RenderBackend* backend;
 public:
 
 	SpriteSheetRenderer();
 	~SpriteSheetRenderer();
 
+	/**
+	* Gets handle of a layer with given name, registering the name if it hasn't been used yet
+	* Handles are shared by all renderers and they never change, hence meshes can resolve them
+	* once when they are created and avoid lookups by name when they are drawn
+	*/
+	static int GetLayerHandle(const string& sheetName);
+
 	/**
 	* Pastes sprite image to the texture under the buffer with given name
 	* Note that there must be a SpriteTexture associated with the given sheet
@@ -146,16 +436,16 @@ public:
 	* Loads a texture
 	* @param texture texture to load
 	* @param sheetName name of the sheet
-	* @param bufferSize maximum number of sprites for this buffer
+	* @param bufferSize initial number of sprites for this buffer; the buffer grows when more sprites are added
 	* @param zIndex z-index of the layer
 	* @param isExternal indicator whether this texture is external and therefore it shouldn't be deleted
 	*/
 	void LoadTexture(ofTexture * texture, string sheetName, int bufferSize, int zIndex, bool isExternal = true);
 
 	/**
-	* Reallocates buffer with given name to the new size
+	* Reallocates buffer with given name to the new size, discarding its sprites
 	* @param sheetName name of the sheet to reallocate
-	* @param bufferSize new size of the buffer
+	* @param bufferSize new size of the buffer, which is also the minimum size the buffer can shrink to
 	*/
 	void ReallocateBuffer(string sheetName, int bufferSize);
 
@@ -164,6 +454,14 @@ public:
 	*/
 	bool AddTile(SpriteTile& tile);
 
+	/**
+	* Adds a batch of tiles into the actual buffer
+	* Corners are calculated for SPRITE_SIMD_WIDTH tiles at once by SSE or NEON instructions if they are available;
+	* otherwise (or if SPRITE_SIMD_DISABLED is defined), the tiles are processed one by one
+	* @return false if there is no texture loaded
+	*/
+	bool AddTiles(const SpriteTile* tiles, int count);
+
 	/**
 	* Adds a rectangle into the actual buffer
 	* @param x x coordinate
@@ -187,11 +485,128 @@ public:
 	*/
 	void ClearTexture(string sheetName);
 
+	/**
+	* Gets layer of given sheet or nullptr if there is no such layer
+	*/
+	SpriteLayer* GetLayer(string sheetName) {
+		auto buff = buffers.find(sheetName);
+		return buff != buffers.end() ? buff->second : nullptr;
+	}
+
+	/**
+	* Gets layer by its handle or nullptr if the layer hasn't been loaded
+	*/
+	SpriteLayer* GetLayer(int layerHandle) {
+		return (layerHandle >= 0 && layerHandle < (int)layersByHandle.size()) ? layersByHandle[layerHandle] : nullptr;
+	}
+
+	/**
+	* Gets number of layer handles, which is an upper bound of handles of all loaded layers
+	*/
+	int GetLayerHandlesNum() const {
+		return layersByHandle.size();
+	}
+
+	/**
+	* Reserves space for given number of sprites at the end of a layer, so that their quads can be written
+	* directly by MakeQuads, e.g. by several threads at once
+	* @return index of the first reserved sprite
+	*/
+	int AppendSprites(int layerHandle, int count);
+
+	/**
+	* Finishes sprites written directly into a layer; if gpu buffers are enabled, marks the given range as changed
+	* @param first index of the first written sprite
+	* @param count number of written sprites
+	* @param dirtyFrom index of the first changed sprite
+	* @param dirtyTo index after the last changed sprite, equal to dirtyFrom if nothing has changed
+	*/
+	void EndAppendedSprites(int layerHandle, int first, int count, int dirtyFrom, int dirtyTo);
+
+	/**
+	* Creates complete quads (vertices, texture coordinates and colors) of a batch of tiles
+	* The renderer isn't modified, hence it can be called by several threads at once
+	*/
+	void MakeQuads(SpriteQuad* quads, const SpriteTile* tiles, int count);
+
+	/**
+	* Creates instances of a batch of tiles, with the same corners, texture coordinates and colors as their quads
+	*/
+	void MakeInstances(SpriteInstance* instances, const SpriteTile* tiles, int count);
+
+	/**
+	* Adds instances of a mesh into the actual buffer; they are drawn on top of its quads by one instanced draw call
+	* The instances are uploaded by the next draw, the buffer must exist until then
+	* @return false if there is no texture loaded
+	*/
+	bool AddInstances(SpriteInstanceBuffer* instances);
+
+	/**
+	* Adds a baked chunk into the actual buffer; it is drawn below its quads from its own buffer object
+	* The quads are uploaded by the next draw if they have changed, the chunk must exist until then
+	* @return false if there is no texture loaded
+	*/
+	bool AddChunk(SpriteChunk* chunk);
+
 	/**
 	* Sets actual buffer that will be drawn
 	*/
 	void SetActualBuffer(string sheetName);
 
+	/**
+	* Sets actual buffer by the handle of its layer
+	*/
+	void SetActualBuffer(int layerHandle) {
+		actualBuffer = GetLayer(layerHandle);
+	}
+
+	/**
+	* Sets backend that draws the layers; buffer objects of the previous backend are deleted
+	* The backend isn't owned by the renderer
+	*/
+	void SetBackend(RenderBackend* backend);
+
+	RenderBackend* GetBackend() const {
+		return backend;
+	}
+
+	/**
+	* Enables or disables drawing from buffer objects
+	* Existing buffer objects are deleted, hence the next draw uploads everything
+	*/
+	void SetGpuBuffersEnabled(bool enabled);
+
+	bool IsGpuBuffersEnabled() const {
+		return gpuBuffersEnabled;
+	}
+
+	/**
+	* Sets number of consecutive quiet frames after which a buffer shrinks to half, but not below its initial size
+	* A frame is quiet if the layer uses at most 1/SPRITE_LAYER_QUIET_RATIO of its buffer
+	* @param frames number of frames, 0 if buffers should never shrink
+	*/
+	void SetShrinkFrames(int frames) {
+		this->shrinkFrames = frames;
+	}
+
+	int GetShrinkFrames() const {
+		return shrinkFrames;
+	}
+
+	/**
+	* Gets size of vertex data of one sprite in bytes
+	*/
+	int GetSpriteDataSize() const {
+		return sizeof(SpriteQuad);
+	}
+
+	/**
+	* Gets number of bytes of vertex data sent to the driver by the last draw
+	*/
+	int GetUploadedBytes() const {
+		return uploadedBytes;
+	}
+
 	/**
 	* Draws the actual buffer
 	*/
@@ -210,19 +625,64 @@ protected:
 	}
 
 	/**
-	* Adds texture coordinates of the given tile into the actual buffer
+	* Stores data of the sprite that is going to be written, so that it can be compared afterwards
+	*/
+	void BeginSprite();
+
+	/**
+	* Finishes the sprite that has been written, marking it as changed if its data differ
+	*/
+	void EndSprite();
+
+	/**
+	* Makes sure the actual buffer has space for given number of additional sprites
+	* The buffer grows geometrically, so that it is reallocated only a few times until it reaches its high-water mark
+	*/
+	inline void ReserveSprites(int count) {
+		int required = actualBuffer->numSprites + count;
+
+		if (required > actualBuffer->bufferSize) {
+			actualBuffer->Resize(max(required, actualBuffer->bufferSize * 2));
+		}
+	}
+
+	/**
+	* Updates statistics of a drawn layer and shrinks its buffer after enough quiet frames
+	*/
+	void EndLayerFrame(SpriteLayer* layer);
+
+	/**
+	* Updates the next buffer object of the layer
+	* @return identifier of the updated buffer object
 	*/
-	void AddTexCoords(SpriteTile& tile);
+	unsigned int UploadGpuBuffer(SpriteLayer* layer);
 
 	/**
-	* Adds given texture coordinates
+	* Uploads changed instances of a mesh, creating its buffer object if it doesn't exist or if it is too small
+	* @return identifier of the buffer object
+	*/
+	unsigned int UploadInstances(SpriteInstanceBuffer* instances);
+
+	/**
+	* Uploads quads of a chunk if they have been baked since the last upload
+	* @return identifier of the buffer object
+	*/
+	unsigned int UploadChunk(SpriteChunk* chunk);
+
+	/**
+	* Sets texture coordinates of a quad according to the given tile
+	*/
+	void AddTexCoords(SpriteQuad& quad, const SpriteTile& tile);
+
+	/**
+	* Adds given texture coordinates, in texels
 	*/
 	void AddTexCoords(FlipDirection f, float posX, float posY, float x = 1, float y = 1);
 
 	/**
-	* Ads texture coordinates to the current texture array
+	* Sets texture coordinates of a quad, in texels
 	*/
-	void AddTexCoords(int offset, float x1, float y1, float x2, float y2);
+	void AddTexCoords(SpriteQuad& quad, float x1, float y1, float x2, float y2);
 
 	/**
 	* Sets texture coefficients
@@ -232,28 +692,23 @@ protected:
 	/**
 	* Creates vertices from tile
 	*/
-	void MakeQuad(int offset, SpriteTile& tile);
+	void MakeQuad(SpriteQuad& quad, const SpriteTile& tile);
 
 	/**
-	* Creates vertices (two triangles) from given parameters
+	* Creates vertices from given corners
 	*/
-	void MakeQuad(int offset, float x1, float y1, float z1, float x2, float y2, float z2,
-		float x3, float y3, float z3, float x4, float y4, float z4);
+	void MakeQuad(SpriteQuad& quad, float x1, float y1, float x2, float y2,
+		float x3, float y3, float x4, float y4);
 
 	/**
 	* Creates color vertices
 	*/
-	void MakeColorQuad(int offset, ofColor& col);
-
-	inline int GetVertexOffset() {
-		return  (actualBuffer->numSprites) * 18;
-	}
-
-	inline int GetColorOffset() {
-		return (actualBuffer->numSprites) * 24;
-	}
+	void MakeColorQuad(SpriteQuad& quad, const ofColor& col);
 
-	inline int GetCoordOffset() {
-		return (actualBuffer->numSprites) * 12;
+	/**
+	* Gets quad of the sprite that is going to be added into the actual buffer
+	*/
+	inline SpriteQuad& GetActualQuad() {
+		return actualBuffer->quads[actualBuffer->numSprites];
 	}
 };
@@ -10,12 +10,13 @@ void DynamicsComponent::Init() {
 	if (!owner->HasAttr(ATTR_DYNAMICS)) {
 		owner->AddAttr(ATTR_DYNAMICS, new Dynamics());
 	}
+	dynamicsAttr = owner->GetAttrHandle<Dynamics*>(ATTR_DYNAMICS);
 }
 
 void DynamicsComponent::Update(const uint64_t delta, const uint64_t absolute) {
 
 	Trans& transform = owner->GetTransform();
-	Dynamics* dynamics = owner->GetAttr<Dynamics*>(ATTR_DYNAMICS);
+	Dynamics* dynamics = dynamicsAttr.Get();
 	auto& velocity = dynamics->GetVelocity();
 
 	// update velocity according to all forces
@@ -18,6 +18,8 @@ extern char ATTR_STEERING_BEH_DEST[];
 * to the Movement attribute
 */
 class DynamicsComponent : public Component {
+private:
+	AttrHandle<Dynamics*> dynamicsAttr;
 public:
 	virtual void Init();
 
@@ -0,0 +1,65 @@
+#include "TextBatcher.h"
+#include "GLRenderBackend.h"
+
+TextBatcher::TextBatcher() : backend(GLRenderBackend::GetInstance()) {
+}
+
+void TextBatcher::LayoutString(ofTrueTypeFont* font, const string& text, float x, float y, vector<GlyphVertex>& output) {
+	if (text.empty()) {
+		return;
+	}
+
+	// the font builds quads of its glyphs, with texture coordinates in its atlas
+	auto& mesh = font->getStringMesh(text, x, y, ofIsVFlipped());
+	auto& positions = mesh.getVertices();
+	auto& texCoords = mesh.getTexCoords();
+	auto& indices = mesh.getIndices();
+	int count = indices.empty() ? positions.size() : indices.size();
+	int first = output.size();
+	output.resize(first + count);
+
+	for (int i = 0; i < count; i++) {
+		int index = indices.empty() ? i : indices[i];
+		GlyphVertex& vertex = output[first + i];
+		vertex.x = positions[index].x;
+		vertex.y = positions[index].y;
+		vertex.u = texCoords[index].x;
+		vertex.v = texCoords[index].y;
+	}
+}
+
+void TextBatcher::AddText(ofTrueTypeFont* font, const AffineMatrix& matrix, const vector<GlyphVertex>& glyphs, const ofColor& color) {
+	if (font != this->font) {
+		// glyphs of other fonts are in other textures
+		Flush();
+		this->font = font;
+	}
+
+	textsNum++;
+	int first = vertices.size();
+	vertices.resize(first + glyphs.size());
+	TextVertex* vertex = &vertices[first];
+
+	for (auto& glyph : glyphs) {
+		vertex->x = matrix.a * glyph.x + matrix.c * glyph.y + matrix.tx;
+		vertex->y = matrix.b * glyph.x + matrix.d * glyph.y + matrix.ty;
+		vertex->u = glyph.u;
+		vertex->v = glyph.v;
+		vertex->r = color.r;
+		vertex->g = color.g;
+		vertex->b = color.b;
+		vertex->a = color.a;
+		vertex++;
+	}
+}
+
+void TextBatcher::Flush() {
+	if (vertices.empty()) {
+		return;
+	}
+
+	backend->LoadMatrix(ofMatrix4x4::newIdentityMatrix());
+	backend->DrawTexts(&font->getFontTexture(), vertices.data(), vertices.size());
+	drawCalls++;
+	vertices.clear();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "ofTrueTypeFont.h"
+#include "ofColor.h"
+#include "AffineMatrix.h"
+
+using namespace std;
+
+class RenderBackend;
+
+/**
+* Vertex of a laid out glyph in local coordinates of a text, with coordinates in the glyph atlas of its font
+*/
+struct GlyphVertex {
+	float x;
+	float y;
+	float u;
+	float v;
+};
+
+/**
+* Vertex of a batched glyph, already transformed into absolute coordinates
+*/
+struct TextVertex {
+	float x;
+	float y;
+	float u;
+	float v;
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+/**
+* Collects glyphs of texts into one vertex buffer and draws them by one call per font
+*
+* Each font keeps all its glyphs in one texture atlas, hence consecutive texts with the same font
+* share one draw call; the batch is flushed when the font changes, which keeps the order of the texts
+* The buffer is reused by each batch, so nothing is allocated once it has grown large enough
+*/
+class TextBatcher {
+private:
+	// font of the current batch
+	ofTrueTypeFont* font = nullptr;
+	vector<TextVertex> vertices;
+	// statistics of the current frame
+	int textsNum = 0;
+	int drawCalls = 0;
+	// backend that draws the batches, not owned by the batcher
+	RenderBackend* backend;
+
+public:
+	TextBatcher();
+
+	/**
+	* Sets backend that draws the batches, OpenGL by default
+	*/
+	void SetBackend(RenderBackend* backend) {
+		this->backend = backend;
+	}
+
+	/**
+	* Lays out a string the same way as ofTrueTypeFont::drawString and appends its glyphs as triangles
+	* @param x x-coordinate of the beginning of the baseline
+	* @param y y-coordinate of the baseline
+	*/
+	static void LayoutString(ofTrueTypeFont* font, const string& text, float x, float y, vector<GlyphVertex>& output);
+
+	/**
+	* Adds laid out glyphs of a text; if the font differs from the font of the current batch, the batch is flushed first
+	* @param matrix absolute transformation of the text
+	*/
+	void AddText(ofTrueTypeFont* font, const AffineMatrix& matrix, const vector<GlyphVertex>& glyphs, const ofColor& color);
+
+	/**
+	* Returns true, if there are texts that haven't been drawn yet
+	*/
+	bool IsEmpty() const {
+		return vertices.empty();
+	}
+
+	/**
+	* Draws all collected texts and clears the batch
+	* The vertices are already absolute, hence the matrix of the backend is reset to identity
+	*/
+	void Flush();
+
+	/**
+	* Resets statistics of the frame
+	*/
+	void ClearCounters() {
+		textsNum = 0;
+		drawCalls = 0;
+	}
+
+	/**
+	* Gets number of texts drawn in the current frame
+	*/
+	int GetTextsNum() const {
+		return textsNum;
+	}
+
+	/**
+	* Gets number of draw calls issued in the current frame
+	*/
+	int GetDrawCalls() const {
+		return drawCalls;
+	}
+
+	/**
+	* Gets collected vertices, valid until the next flush
+	*/
+	const vector<TextVertex>& GetVertices() const {
+		return vertices;
+	}
+};
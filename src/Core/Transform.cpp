@@ -17,6 +17,7 @@ void Trans::SetAbsAsLocal() {
 	absPos = localPos;
 	absScale = scale;
 	absRotation = rotation;
+	StoreCalcValues(0);
 }
 
 void Trans::CalcAbsTransform(Trans& parent) {
@@ -41,6 +42,37 @@ void Trans::CalcAbsTransform(Trans& parent) {
 		// calculate absolute position according to the parent's rotation origin
 		absPos = parent.absPos + parent.absRotationCentroid + rotPos - absRotationCentroid;
 	}
+
+	StoreCalcValues(parent.absVersion);
+}
+
+void Trans::UpdateAbsMatrix() {
+	float cosRot = cos(absRotation);
+	float sinRot = sin(absRotation);
+
+	// rotation followed by scale
+	absMatrix.a = absScale.x * cosRot;
+	absMatrix.b = absScale.y * sinRot;
+	absMatrix.c = -absScale.x * sinRot;
+	absMatrix.d = absScale.y * cosRot;
+
+	// the rotation is done around the unscaled centroid, which has to stay in place
+	float centroidX = absScale.x != 0 ? absRotationCentroid.x / absScale.x : 0;
+	float centroidY = absScale.y != 0 ? absRotationCentroid.y / absScale.y : 0;
+	absMatrix.tx = absPos.x + absRotationCentroid.x - (absMatrix.a * centroidX + absMatrix.c * centroidY);
+	absMatrix.ty = absPos.y + absRotationCentroid.y - (absMatrix.b * centroidX + absMatrix.d * centroidY);
+}
+
+void Trans::StoreCalcValues(unsigned parentVersion) {
+	UpdateAbsMatrix();
+
+	calc.pos = localPos;
+	calc.scale = scale;
+	calc.rotation = rotation;
+	calc.rotationCentroid = rotationCentroid;
+	calc.parentVersion = parentVersion;
+	calc.isCalculated = true;
+	absVersion++;
 }
 
 float Trans::CalcAngle(ofVec2f pos) {
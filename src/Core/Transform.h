@@ -3,6 +3,7 @@
 #include "ofVec2f.h"
 #include "ofVec3f.h"
 #include "ofMatrix4x4.h"
+#include "AffineMatrix.h"
 
 
 /**
@@ -51,6 +52,11 @@ public:
 	float absRotation = 0;
 	// absolute rotation centroid
 	ofVec3f absRotationCentroid = ofVec3f(0);
+	// incremented whenever the absolute transformation is recalculated; children keep the version
+	// they were calculated from in order to find out whether their parent has moved
+	unsigned absVersion = 0;
+	// absolute transformation matrix, recalculated together with the absolute values
+	AffineMatrix absMatrix;
 
 	ofVec3f& GetLocalPos() { return localPos; }
 	ofVec3f& GetScale() { return scale; }
@@ -67,6 +73,28 @@ public:
 	*/
 	void CalcAbsTransform(Trans& parent);
 
+	/**
+	* Returns true, if neither the local values nor the parent's absolute transformation
+	* have changed since the absolute transformation was calculated by CalcAbsTransform
+	*/
+	bool IsAbsTransformValid(const Trans& parent) const {
+		return calc.isCalculated && calc.parentVersion == parent.absVersion && !HasLocalChanged();
+	}
+
+	/**
+	* Returns true, if the local values haven't changed since the last call of SetAbsAsLocal
+	*/
+	bool IsAbsAsLocalValid() const {
+		return calc.isCalculated && calc.parentVersion == 0 && !HasLocalChanged();
+	}
+
+	/**
+	* Forces recalculation of the absolute transformation, e.g. when the object gets a new parent
+	*/
+	void Invalidate() {
+		calc.isCalculated = false;
+	}
+
 	/**
 	* Calculates angle in degrees between local position and given position
 	*/
@@ -83,10 +111,58 @@ public:
 	*/
 	ofMatrix4x4 CalcAbsMatrix();
 
+	/**
+	* Gets absolute transformation matrix calculated by SetAbsAsLocal or CalcAbsTransform;
+	* it transforms points the same way as the matrix from CalcAbsMatrix
+	*/
+	const AffineMatrix& GetAbsMatrix() const {
+		return absMatrix;
+	}
+
 	/**
 	* Calculates local transformation matrix
 	*/
 	ofMatrix4x4 CalcMatrix();
+
+private:
+	/**
+	* Local values and version of the parent the absolute transformation was calculated from
+	* They aren't copied with the transformation, since the copy may belong to another parent
+	*/
+	struct CalcState {
+		ofVec3f pos;
+		ofVec3f scale;
+		ofVec3f rotationCentroid;
+		float rotation = 0;
+		unsigned parentVersion = 0;
+		bool isCalculated = false;
+
+		CalcState() {
+
+		}
+
+		CalcState(const CalcState&) {
+
+		}
+
+		CalcState& operator=(const CalcState&) {
+			isCalculated = false;
+			return *this;
+		}
+	};
+
+	CalcState calc;
+
+	bool HasLocalChanged() const {
+		return calc.pos != localPos || calc.scale != scale || calc.rotation != rotation || calc.rotationCentroid != rotationCentroid;
+	}
+
+	void StoreCalcValues(unsigned parentVersion);
+
+	/**
+	* Recalculates the absolute matrix from the absolute values
+	*/
+	void UpdateAbsMatrix();
 };
 
 namespace std {
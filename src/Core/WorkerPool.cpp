@@ -0,0 +1,76 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int workersNum) : nextTask(0) {
+	for (int i = 0; i < workersNum; i++) {
+		threads.push_back(thread(&WorkerPool::WorkerLoop, this));
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+
+	batchReady.notify_all();
+
+	for (auto& worker : threads) {
+		worker.join();
+	}
+}
+
+void WorkerPool::Run(int tasksNum, const function<void(int)>& task) {
+	if (threads.empty() || tasksNum <= 1) {
+		// nothing to distribute
+		for (int i = 0; i < tasksNum; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+		this->task = task;
+		this->tasksNum = tasksNum;
+		nextTask = 0;
+		busyWorkers = threads.size();
+		batchId++;
+	}
+
+	batchReady.notify_all();
+	RunTasks();
+
+	unique_lock<mutex> guard(lock);
+	batchDone.wait(guard, [this]() { return busyWorkers == 0; });
+}
+
+void WorkerPool::WorkerLoop() {
+	int lastBatch = 0;
+
+	while (true) {
+		{
+			unique_lock<mutex> guard(lock);
+			batchReady.wait(guard, [this, lastBatch]() { return stopping || batchId != lastBatch; });
+
+			if (stopping) {
+				return;
+			}
+
+			lastBatch = batchId;
+		}
+
+		RunTasks();
+
+		unique_lock<mutex> guard(lock);
+		if (--busyWorkers == 0) {
+			batchDone.notify_one();
+		}
+	}
+}
+
+void WorkerPool::RunTasks() {
+	int index;
+	while ((index = nextTask++) < tasksNum) {
+		task(index);
+	}
+}
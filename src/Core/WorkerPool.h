@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+using namespace std;
+
+/**
+* Pool of worker threads that run batches of independent tasks
+*
+* Run distributes tasks among the workers and the calling thread and returns when all of them have finished,
+* hence it can replace a loop whose iterations don't depend on each other. Threads are created once
+* and they sleep between batches
+*/
+class WorkerPool {
+private:
+	vector<thread> threads;
+	mutex lock;
+	// signals a new batch to the workers
+	condition_variable batchReady;
+	// signals the calling thread that all workers have finished the batch
+	condition_variable batchDone;
+	// task of the current batch, called with index of the task
+	function<void(int)> task;
+	int tasksNum = 0;
+	atomic<int> nextTask;
+	// number of workers that haven't finished the current batch yet
+	int busyWorkers = 0;
+	// incremented with each batch, so that workers recognize a new one
+	int batchId = 0;
+	bool stopping = false;
+
+public:
+	/**
+	* Creates a pool
+	* @param workersNum number of threads besides the calling one
+	*/
+	WorkerPool(int workersNum);
+
+	~WorkerPool();
+
+	/**
+	* Runs tasks with indices from 0 to tasksNum-1 and waits until all of them have finished
+	* Tasks are picked in ascending order, each of them exactly once
+	*/
+	void Run(int tasksNum, const function<void(int)>& task);
+
+	/**
+	* Gets number of threads that run tasks, including the calling one
+	*/
+	int GetThreadsNum() const {
+		return threads.size() + 1;
+	}
+
+private:
+	void WorkerLoop();
+
+	/**
+	* Picks tasks of the current batch until there are none left
+	*/
+	void RunTasks();
+};
@@ -0,0 +1,1502 @@
+#include "BenchmarkExample.h"
+#include "AphUtils.h"
+#include "Scene.h"
+#include "GameObject.h"
+#include "SteeringComponent.h"
+#include "LooseQuadTree.h"
+#include "QuadTreeExample.h"
+#include "SpriteSheetRenderer.h"
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "SpriteSheet.h"
+#include "ShapeBatcher.h"
+#include "TextBatcher.h"
+#include "SpriteAtlas.h"
+#include "SoftwareRenderBackend.h"
+#include <cfloat>
+
+#define BENCH_LOOKUP_OBJECTS 100000
+#define BENCH_LOOKUP_NAMES 1000
+#define BENCH_LOOKUP_FLAGS 10
+#define BENCH_CHURN_BATCH 1000
+#define BENCH_DYNAMICS_OBJECTS 50000
+#define BENCH_ALLOCATOR_OBJECTS 10000
+#define BENCH_ATTR_OBJECTS 10000
+#define BENCH_MESSAGES 10000
+#define BENCH_SUBSCRIBERS 20
+#define BENCH_SPATIAL_AREA 1000
+#define BENCH_TRANSFORM_PARENTS 500
+#define BENCH_TRANSFORM_CHILDREN 100
+#define BENCH_SPRITES_SMALL 10000
+#define BENCH_SPRITES_LARGE 100000
+#define BENCH_QUEUE_NODES 20000
+#define BENCH_QUEUE_ZINDICES 10
+#define BENCH_CULLING_CHUNKS 100
+#define BENCH_CULLING_CHUNK_SPRITES 200
+#define BENCH_SHAPES 2000
+#define BENCH_TEXTS 200
+#define BENCH_ATLAS_RECTS 500
+#define BENCH_ATLAS_IMAGES 500
+#define BENCH_GROWTH_QUIET 1000
+#define BENCH_GROWTH_SPIKE 100000
+#define BENCH_GROWTH_SHRINK_FRAMES 30
+#define BENCH_PARALLEL_SPRITES 200000
+#define BENCH_PARALLEL_SINGLE_SPRITES 2000
+#define BENCH_HEADLESS_SPRITES 10000
+#define BENCH_HEADLESS_SHAPES 500
+#define BENCH_INSTANCED_SPRITES 20000
+#define BENCH_INSTANCED_MOVED 10
+#define BENCH_TILEMAP_SIZE 256
+
+/**
+ * Subscriber that counts received messages
+ */
+class CountingComponent : public Component {
+public:
+	int received = 0;
+	StrId action;
+	bool deferred;
+
+	CountingComponent(StrId action, bool deferred) : action(action), deferred(deferred) {
+
+	}
+
+	virtual void Init() {
+		if (deferred) {
+			RegisterDeferredSubscriber(action);
+		} else {
+			RegisterSubscriber(action);
+		}
+	}
+
+	virtual void OnMessage(Msg&) {
+		received++;
+	}
+
+	virtual void OnMessages(MsgSpan messages) {
+		received += messages.GetCount();
+	}
+
+	virtual void Update(uint64_t, uint64_t) {
+
+	}
+
+	void Send(StrId action) {
+		SendMsg(action);
+	}
+};
+
+/**
+ * Renderer of virtual size 800x600 that draws by a software backend into one sprite layer
+ * Texture of the layer is a checkerboard where each frame of 16x16 pixels has its own color,
+ * so that wrong texture coordinates change the frame
+ */
+class HeadlessRenderer {
+public:
+	SoftwareRenderBackend backend;
+	ofImage atlas;
+	ofPixels atlasPixels;
+	Renderer* renderer;
+
+	HeadlessRenderer(const string& layerName, int atlasSize, int layerSize) : backend(800, 600) {
+		renderer = new Renderer();
+		renderer->SetBackend(&backend);
+		renderer->SetVirtualWidth(800);
+		renderer->SetVirtualHeight(600);
+		renderer->OnInit();
+		renderer->AddTileLayer(&atlas, layerName, layerSize, 0);
+
+		atlasPixels.allocate(atlasSize, atlasSize, OF_PIXELS_RGBA);
+		for (int y = 0; y < atlasSize; y++) {
+			for (int x = 0; x < atlasSize; x++) {
+				int frame = (y / 16) * (atlasSize / 16) + x / 16;
+				bool isLight = (x / 4 + y / 4) % 2 == 0;
+				atlasPixels.setColor(x, y, isLight ? ofColor(frame * 16, 255, 255 - frame * 16) : ofColor(255, 0, 0, 128));
+			}
+		}
+		backend.SetTexturePixels(&atlas.getTexture(), &atlasPixels);
+	}
+
+	HeadlessRenderer(const HeadlessRenderer& copy) = delete;
+	HeadlessRenderer& operator=(const HeadlessRenderer& copy) = delete;
+
+	~HeadlessRenderer() {
+		delete renderer;
+	}
+};
+
+void BenchmarkExample::setup() {
+	ofBackground(0, 0, 0);
+	BenchmarkSceneLookups();
+	BenchmarkSceneChurn();
+	BenchmarkComponentPools();
+	BenchmarkSceneAllocator();
+	BenchmarkAttributes();
+	BenchmarkMessaging();
+	BenchmarkSpatialIndex();
+	BenchmarkTransforms();
+	BenchmarkSpriteBatches();
+	BenchmarkAddTile();
+	BenchmarkRenderQueue();
+	BenchmarkSpritePush();
+	BenchmarkCulling();
+	BenchmarkShapes();
+	BenchmarkTexts();
+	BenchmarkAtlas();
+	BenchmarkLayerGrowth();
+	BenchmarkParallelSprites();
+	BenchmarkHeadlessFrames();
+	BenchmarkInstancedSprites();
+	BenchmarkTileMap();
+}
+
+void BenchmarkExample::update() {
+
+}
+
+void BenchmarkExample::draw() {
+	ofSetColor(255, 255, 255);
+
+	for (int i = 0; i < (int)results.size(); i++) {
+		ofDrawBitmapString(results[i], 20, 20 + i * 15);
+	}
+}
+
+void BenchmarkExample::Measure(string name, int repeat, std::function<void()> func) {
+	uint64_t start = ofGetElapsedTimeMicros();
+
+	for (int i = 0; i < repeat; i++) {
+		func();
+	}
+
+	float avg = ((float)(ofGetElapsedTimeMicros() - start)) / repeat;
+	auto result = string_format("%-50s %12.3f us", name.c_str(), avg);
+	ofLogNotice("Benchmark", "%s", result.c_str());
+	results.push_back(result);
+}
+
+void BenchmarkExample::BenchmarkSceneLookups() {
+	results.push_back(string_format("Scene lookups, %d objects", BENCH_LOOKUP_OBJECTS));
+
+	auto scene = new Scene();
+	auto root = new GameObject("root", nullptr, scene);
+	scene->SetRootObject(root);
+
+	for (int i = 0; i < BENCH_LOOKUP_OBJECTS; i++) {
+		auto obj = new GameObject(string_format("object_%d", i % BENCH_LOOKUP_NAMES), nullptr, scene);
+		obj->SetFlag(i % BENCH_LOOKUP_FLAGS);
+		obj->SetNetworkId(i);
+		root->AddChild(obj);
+	}
+
+	auto& children = root->GetChildren();
+	int found = 0;
+
+	// linear scan over all objects, the way the scene used to search them
+	Measure("linear scan by network id", 100, [&]() {
+		int id = (int)ofRandom(0, BENCH_LOOKUP_OBJECTS);
+		for (auto child : children) {
+			if (child->GetNetworkId() == id) {
+				found++;
+				break;
+			}
+		}
+	});
+
+	Measure("FindGameObjectByNetworkId", 100000, [&]() {
+		if (scene->FindGameObjectByNetworkId((int)ofRandom(0, BENCH_LOOKUP_OBJECTS)) != nullptr) found++;
+	});
+
+	Measure("FindGameObjectByName", 100000, [&]() {
+		if (scene->FindGameObjectByName("object_500") != nullptr) found++;
+	});
+
+	vector<GameObject*> output;
+
+	Measure("FindGameObjectsByName (100 results)", 10000, [&]() {
+		output.clear();
+		scene->FindGameObjectsByName("object_500", output);
+	});
+
+	Measure("FindGameObjectsByFlag (10k results)", 1000, [&]() {
+		output.clear();
+		scene->FindGameObjectsByFlag(5, output);
+	});
+
+	Measure("SetName on a registered object", 10000, [&]() {
+		auto obj = children[(int)ofRandom(0, BENCH_LOOKUP_OBJECTS)];
+		obj->SetName(obj->GetName());
+		obj->SetName("renamed");
+		obj->SetName("object_0");
+	});
+
+	ofLogNotice("Benchmark", "Found %d objects", found);
+	delete root;
+	delete scene;
+}
+
+void BenchmarkExample::BenchmarkSceneChurn() {
+	results.push_back(string_format("Scene churn, batches of %d objects", BENCH_CHURN_BATCH));
+
+	for (int sceneSize : { 1000, 10000, 100000 }) {
+		auto scene = new Scene();
+		auto root = new GameObject("root", nullptr, scene);
+		scene->SetRootObject(root);
+
+		// static part of the scene
+		for (int i = 0; i < sceneSize; i++) {
+			auto obj = new GameObject("static", nullptr, scene);
+			obj->SetFlag(1);
+			root->AddChild(obj);
+		}
+
+		vector<GameObject*> batch;
+
+		// spawn a batch of projectiles and despawn them in the order they were created
+		Measure(string_format("spawn + despawn, scene of %d objects", sceneSize), 10, [&]() {
+			for (int i = 0; i < BENCH_CHURN_BATCH; i++) {
+				auto obj = new GameObject("projectile", nullptr, scene);
+				obj->SetFlag(2);
+				root->AddChild(obj);
+				batch.push_back(obj);
+			}
+
+			for (auto obj : batch) {
+				root->DestroyChild(obj);
+			}
+			batch.clear();
+		});
+
+		delete root;
+		delete scene;
+	}
+}
+
+void BenchmarkExample::BenchmarkComponentPools() {
+	results.push_back(string_format("Component update, %d dynamics objects", BENCH_DYNAMICS_OBJECTS));
+
+	for (bool pooled : { false, true }) {
+		auto scene = new Scene();
+		auto root = new GameObject("root", nullptr, scene);
+		scene->SetRootObject(root);
+
+		for (int i = 0; i < BENCH_DYNAMICS_OBJECTS; i++) {
+			auto obj = new GameObject("dynamic", nullptr, scene);
+			if (pooled) {
+				obj->AddComponent(scene->GetComponentPool<DynamicsComponent>()->Create());
+			} else {
+				obj->AddComponent(new DynamicsComponent());
+			}
+			obj->GetAttr<Dynamics*>(ATTR_DYNAMICS)->SetVelocity(ofVec2f(ofRandom(-50, 50), ofRandom(-50, 50)));
+			obj->GetTransform().localPos = ofVec3f(ofRandom(0, 90), ofRandom(0, 90));
+			root->AddChild(obj);
+		}
+
+		// one frame = update of the scene graph followed by update of the pools
+		Measure(pooled ? "frame, pooled components" : "frame, components updated by owners", 100, [&]() {
+			root->Update(16, 0);
+			scene->UpdateComponentPools(16, 0);
+		});
+
+		delete root;
+		delete scene;
+	}
+}
+
+void BenchmarkExample::BenchmarkSceneAllocator() {
+	results.push_back(string_format("Scene build + teardown, %d objects", BENCH_ALLOCATOR_OBJECTS));
+
+	for (bool useArena : { false, true }) {
+		auto scene = new Scene();
+
+		Measure(useArena ? "build + Clear, scene arena" : "build + Clear, global heap", 20, [&]() {
+			SceneAllocator* previous = SceneAllocator::GetCurrent();
+			SceneAllocator::SetCurrent(useArena ? &scene->GetAllocator() : nullptr);
+
+			auto root = new GameObject("root", nullptr, scene);
+			scene->SetRootObject(root);
+
+			// the same parts a factory creates: object, default mesh, attribute and component
+			for (int i = 0; i < BENCH_ALLOCATOR_OBJECTS; i++) {
+				auto obj = new GameObject("brick", nullptr, scene);
+				obj->AddAttr(ATTR_DYNAMICS, new Dynamics());
+				obj->AddComponent(new DynamicsComponent());
+				root->AddChild(obj);
+			}
+
+			scene->Clear();
+			SceneAllocator::SetCurrent(previous);
+		});
+
+		delete scene;
+	}
+}
+
+void BenchmarkExample::BenchmarkAttributes() {
+	results.push_back(string_format("Attribute access, %d objects with 5 attributes", BENCH_ATTR_OBJECTS));
+
+	auto scene = new Scene();
+	vector<GameObject*> objects;
+	vector<AttrHandle<Dynamics*>> handles;
+
+	for (int i = 0; i < BENCH_ATTR_OBJECTS; i++) {
+		auto obj = new GameObject("object", nullptr, scene);
+		obj->AddAttr(StrId("SPEED"), 1.0f);
+		obj->AddAttr(StrId("POSITION"), ofVec2f(1, 2));
+		obj->AddAttr(StrId("NAME"), string("object"));
+		obj->AddAttr(StrId("LIVES"), 3);
+		obj->AddAttr(ATTR_DYNAMICS, new Dynamics());
+		objects.push_back(obj);
+		handles.push_back(obj->GetAttrHandle<Dynamics*>(ATTR_DYNAMICS));
+	}
+
+	float sum = 0;
+	StrId dynamicsKey = StrId(ATTR_DYNAMICS);
+
+	Measure("GetAttr<Dynamics*> on each object", 100, [&]() {
+		for (auto obj : objects) {
+			sum += obj->GetAttr<Dynamics*>(dynamicsKey)->GetAngularSpeed();
+		}
+	});
+
+	Measure("AttrHandle<Dynamics*> on each object", 100, [&]() {
+		for (auto& handle : handles) {
+			sum += handle.Get()->GetAngularSpeed();
+		}
+	});
+
+	ofLogNotice("Benchmark", "Sum %f", sum);
+
+	for (auto obj : objects) {
+		delete obj;
+	}
+	delete scene;
+}
+
+void BenchmarkExample::BenchmarkMessaging() {
+	results.push_back(string_format("Messaging, %d messages, %d subscribers", BENCH_MESSAGES, BENCH_SUBSCRIBERS));
+
+	for (bool deferred : { false, true }) {
+		auto scene = new Scene();
+		auto root = new GameObject("root", nullptr, scene);
+		scene->SetRootObject(root);
+		StrId action = StrId("BENCH_ACTION");
+		vector<CountingComponent*> subscribers;
+
+		for (int i = 0; i < BENCH_SUBSCRIBERS; i++) {
+			auto subscriber = new CountingComponent(action, deferred);
+			root->AddComponent(subscriber);
+			subscribers.push_back(subscriber);
+		}
+
+		auto sender = new CountingComponent(StrId("BENCH_NOTHING"), false);
+		root->AddComponent(sender);
+
+		Measure(deferred ? "frame, deferred subscribers" : "frame, synchronous subscribers", 20, [&]() {
+			for (int i = 0; i < BENCH_MESSAGES; i++) {
+				sender->Send(action);
+			}
+			scene->DispatchMessages();
+		});
+
+		ofLogNotice("Benchmark", "Received %d messages", subscribers[0]->received);
+		delete root;
+		delete scene;
+	}
+}
+
+void BenchmarkExample::BenchmarkSpatialIndex() {
+	results.push_back(string_format("Spatial index, moving items in an area of %dx%d", BENCH_SPATIAL_AREA, BENCH_SPATIAL_AREA));
+
+	for (int itemsNum : { 10000, 50000, 200000 }) {
+		// the tree of QuadTreeExample, cleared and filled again every frame
+		QTBounds bounds{ 0, 0, BENCH_SPATIAL_AREA, BENCH_SPATIAL_AREA };
+		Quadtree<QuadTreeItem> example(bounds);
+		vector<QuadTreeItem> items;
+
+		for (int i = 0; i < itemsNum; i++) {
+			items.push_back(QuadTreeItem{ ofRandom(0, BENCH_SPATIAL_AREA - 3), ofRandom(0, BENCH_SPATIAL_AREA - 3), 3, 3, ofRandom(-2, 2), ofRandom(-2, 2) });
+		}
+
+		Measure(string_format("move + rebuild example tree, %d items", itemsNum), 10, [&]() {
+			example.clear();
+			for (auto& item : items) {
+				item.x += item.vx;
+				item.y += item.vy;
+				if (item.x < 0 || item.x + item.width > BENCH_SPATIAL_AREA) item.vx = -item.vx;
+				if (item.y < 0 || item.y + item.height > BENCH_SPATIAL_AREA) item.vy = -item.vy;
+				example.insert(item);
+			}
+		});
+		example.clear();
+
+		// the same items as game objects, moved by the transformation update
+		auto scene = new Scene();
+		auto root = new GameObject("root", nullptr, scene);
+		scene->SetRootObject(root);
+		vector<GameObject*> objects;
+		vector<ofVec2f> velocities;
+
+		for (auto& item : items) {
+			auto obj = new GameObject("item", nullptr, scene, new FRect(3, 3));
+			obj->GetTransform().localPos = ofVec3f(item.x, item.y);
+			root->AddChild(obj);
+			objects.push_back(obj);
+			velocities.push_back(ofVec2f(item.vx, item.vy));
+		}
+
+		auto moveObjects = [&]() {
+			for (int i = 0; i < (int)objects.size(); i++) {
+				auto& pos = objects[i]->GetTransform().localPos;
+				pos.x += velocities[i].x;
+				pos.y += velocities[i].y;
+				if (pos.x < 0 || pos.x + 3 > BENCH_SPATIAL_AREA) velocities[i].x = -velocities[i].x;
+				if (pos.y < 0 || pos.y + 3 > BENCH_SPATIAL_AREA) velocities[i].y = -velocities[i].y;
+			}
+			root->UpdateTransformations();
+		};
+
+		Measure(string_format("move + UpdateTransformations, %d objects", itemsNum), 10, moveObjects);
+
+		BoundingBox area;
+		area.bottomRight = area.topRight = area.bottomLeft = ofVec2f(BENCH_SPATIAL_AREA, BENCH_SPATIAL_AREA);
+		LooseQuadTree tree(area);
+		for (auto obj : objects) {
+			tree.Insert(obj);
+		}
+
+		Measure(string_format("move + UpdateTransformations, %d objects in a tree", itemsNum), 10, moveObjects);
+
+		vector<GameObject*> output;
+		int found = 0;
+
+		Measure("QueryRange 50x50", 1000, [&]() {
+			BoundingBox range;
+			range.topLeft = ofVec2f(ofRandom(0, BENCH_SPATIAL_AREA - 50), ofRandom(0, BENCH_SPATIAL_AREA - 50));
+			range.bottomRight = range.topLeft + ofVec2f(50, 50);
+			output.clear();
+			tree.QueryRange(range, output);
+			found += output.size();
+		});
+
+		Measure("QueryRadius 25", 1000, [&]() {
+			output.clear();
+			tree.QueryRadius(ofVec2f(ofRandom(0, BENCH_SPATIAL_AREA), ofRandom(0, BENCH_SPATIAL_AREA)), 25, output);
+			found += output.size();
+		});
+
+		Measure("QueryNearest 10", 1000, [&]() {
+			output.clear();
+			tree.QueryNearest(ofVec2f(ofRandom(0, BENCH_SPATIAL_AREA), ofRandom(0, BENCH_SPATIAL_AREA)), 10, output);
+			found += output.size();
+		});
+
+		ofLogNotice("Benchmark", "Found %d objects", found);
+		delete root;
+		delete scene;
+	}
+}
+
+void BenchmarkExample::BenchmarkTransforms() {
+	results.push_back(string_format("Transformation update, %d rotated parents with %d children", BENCH_TRANSFORM_PARENTS, BENCH_TRANSFORM_CHILDREN));
+
+	auto scene = new Scene();
+	auto root = new GameObject("root", nullptr, scene);
+	scene->SetRootObject(root);
+	vector<GameObject*> parents;
+
+	for (int i = 0; i < BENCH_TRANSFORM_PARENTS; i++) {
+		auto parent = new GameObject("parent", nullptr, scene, new FRect(10, 10));
+		parent->GetTransform().localPos = ofVec3f(ofRandom(0, 1000), ofRandom(0, 1000));
+		parent->GetTransform().rotation = ofRandom(0, PI);
+		root->AddChild(parent);
+		parents.push_back(parent);
+
+		for (int j = 0; j < BENCH_TRANSFORM_CHILDREN; j++) {
+			auto child = new GameObject("child", nullptr, scene, new FRect(1, 1));
+			child->GetTransform().localPos = ofVec3f(ofRandom(-5, 5), ofRandom(-5, 5));
+			parent->AddChild(child);
+		}
+	}
+
+	int recalculated = 0;
+
+	Measure("first frame, all transformations", 1, [&]() {
+		recalculated = root->UpdateTransformations();
+	});
+	ofLogNotice("Benchmark", "Recalculated %d transformations", recalculated);
+
+	Measure("static scene", 100, [&]() {
+		recalculated = root->UpdateTransformations();
+	});
+	ofLogNotice("Benchmark", "Recalculated %d transformations", recalculated);
+
+	// 1% of parents move, together with their children
+	Measure("scene with 1% of moving subtrees", 100, [&]() {
+		for (int i = 0; i < BENCH_TRANSFORM_PARENTS / 100; i++) {
+			parents[(int)ofRandom(0, BENCH_TRANSFORM_PARENTS)]->GetTransform().localPos.x += 1;
+		}
+		recalculated = root->UpdateTransformations();
+	});
+	ofLogNotice("Benchmark", "Recalculated %d transformations", recalculated);
+
+	delete root;
+	delete scene;
+}
+
+void BenchmarkExample::BenchmarkSpriteBatches() {
+	results.push_back("Sprite batches, client-side arrays and gpu buffers");
+
+	ofTexture texture;
+
+	for (int spritesNum : { BENCH_SPRITES_SMALL, BENCH_SPRITES_LARGE }) {
+		vector<SpriteTile> tiles(spritesNum);
+
+		for (auto& tile : tiles) {
+			tile.width = tile.height = 16;
+			tile.posX = ofRandom(0, 1000);
+			tile.posY = ofRandom(0, 1000);
+			tile.rotation = ofRandom(0, PI);
+		}
+
+		for (bool gpuBuffers : { false, true }) {
+			auto renderer = new SpriteSheetRenderer();
+			renderer->LoadTexture(&texture, "sprites", spritesNum, 0, true);
+			renderer->SetGpuBuffersEnabled(gpuBuffers);
+
+			auto drawFrame = [&]() {
+				renderer->ClearCounters("sprites");
+				for (auto& tile : tiles) {
+					renderer->AddTile(tile);
+				}
+				renderer->Draw();
+			};
+
+			// fill all buffer objects
+			for (int i = 0; i < SPRITE_LAYER_GPU_BUFFERS; i++) {
+				drawFrame();
+			}
+
+			string mode = gpuBuffers ? "gpu buffers" : "client arrays";
+
+			Measure(string_format("static frame, %d sprites, %s", spritesNum, mode.c_str()), 20, drawFrame);
+			ofLogNotice("Benchmark", "Uploaded %d bytes", renderer->GetUploadedBytes());
+
+			// a block of 1% of sprites moves, e.g. units of one squad
+			Measure(string_format("1%% moving, %d sprites, %s", spritesNum, mode.c_str()), 20, [&]() {
+				for (int i = spritesNum / 2; i < spritesNum / 2 + spritesNum / 100; i++) {
+					tiles[i].posX += 1;
+				}
+				drawFrame();
+			});
+			ofLogNotice("Benchmark", "Uploaded %d bytes", renderer->GetUploadedBytes());
+
+			delete renderer;
+		}
+	}
+}
+
+void BenchmarkExample::BenchmarkAddTile() {
+	results.push_back(string_format("AddTile and AddTiles, %d sprites", BENCH_SPRITES_LARGE));
+
+	ofTexture texture;
+	auto renderer = new SpriteSheetRenderer();
+	renderer->LoadTexture(&texture, "single", BENCH_SPRITES_LARGE, 0, true);
+	renderer->LoadTexture(&texture, "batch", BENCH_SPRITES_LARGE, 0, true);
+	vector<SpriteTile> tiles(BENCH_SPRITES_LARGE);
+
+	for (auto& tile : tiles) {
+		tile.offsetX = (int)ofRandom(0, 512);
+		tile.offsetY = (int)ofRandom(0, 512);
+		tile.width = tile.height = 16;
+		tile.posX = ofRandom(0, 1000);
+		tile.posY = ofRandom(0, 1000);
+		tile.scaleX = ofRandom(0.5f, 2);
+		tile.scaleY = ofRandom(0.5f, 2);
+	}
+
+	auto addTiles = [&]() {
+		renderer->ClearCounters("single");
+		for (auto& tile : tiles) {
+			renderer->AddTile(tile);
+		}
+	};
+
+	auto addBatch = [&]() {
+		renderer->ClearCounters("batch");
+		renderer->AddTiles(tiles.data(), tiles.size());
+	};
+
+	for (bool rotated : { false, true }) {
+		if (rotated) {
+			for (auto& tile : tiles) {
+				tile.rotation = ofRandom(0, PI);
+			}
+		}
+
+		Measure(rotated ? "AddTile, rotated" : "AddTile, no rotation", 50, addTiles);
+		Measure(rotated ? "AddTiles, rotated" : "AddTiles, no rotation", 50, addBatch);
+
+		// both ways have to produce the same vertices
+		auto single = renderer->GetLayer("single");
+		auto batch = renderer->GetLayer("batch");
+		float maxDiff = 0;
+		bool identical = single->numSprites == batch->numSprites
+			&& memcmp(single->quads, batch->quads, sizeof(SpriteQuad) * single->numSprites) == 0;
+
+		for (int i = 0; i < single->numSprites && i < batch->numSprites; i++) {
+			for (int j = 0; j < 4; j++) {
+				auto& expected = single->quads[i].vertices[j];
+				auto& actual = batch->quads[i].vertices[j];
+				maxDiff = max(maxDiff, max(abs(expected.x - actual.x), abs(expected.y - actual.y)));
+			}
+		}
+
+		ofLogNotice("Benchmark", "AddTiles output %s, max difference %f", identical ? "identical" : "differs", maxDiff);
+		if (maxDiff > 0.001f || single->numSprites != batch->numSprites) {
+			ofLogError("Benchmark", "AddTiles doesn't match AddTile!");
+		}
+	}
+
+	ofLogNotice("Benchmark", "Vertex data of one sprite: %d bytes", renderer->GetSpriteDataSize());
+
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkRenderQueue() {
+	results.push_back(string_format("Render queue, %d nodes with %d z-indices", BENCH_QUEUE_NODES, BENCH_QUEUE_ZINDICES));
+
+	vector<Renderable*> nodes;
+	vector<int> zIndices;
+
+	for (int i = 0; i < BENCH_QUEUE_NODES; i++) {
+		nodes.push_back(new FRect(1, 1));
+		zIndices.push_back((int)ofRandom(0, BENCH_QUEUE_ZINDICES));
+	}
+
+	int visited = 0;
+
+	Measure("map of vectors, recreated each frame", 100, [&]() {
+		map<int, vector<Renderable*>> buffer;
+		for (int i = 0; i < (int)nodes.size(); i++) {
+			buffer[zIndices[i]].push_back(nodes[i]);
+		}
+		for (auto& bucket : buffer) {
+			for (auto node : bucket.second) {
+				visited += node->IsVisible();
+			}
+		}
+	});
+
+	RenderQueue queue;
+
+	Measure("render queue with radix sort", 100, [&]() {
+		queue.Clear();
+		for (int i = 0; i < (int)nodes.size(); i++) {
+			queue.Push(nodes[i], zIndices[i]);
+		}
+		queue.Sort();
+		for (int i = 0; i < queue.GetSize(); i++) {
+			visited += queue.GetNode(i)->IsVisible();
+		}
+	});
+
+	// both ways have to produce the same order
+	map<int, vector<Renderable*>> buffer;
+	for (int i = 0; i < (int)nodes.size(); i++) {
+		buffer[zIndices[i]].push_back(nodes[i]);
+	}
+	int position = 0;
+	bool sameOrder = true;
+	for (auto& bucket : buffer) {
+		for (auto node : bucket.second) {
+			sameOrder &= queue.GetNode(position++) == node;
+		}
+	}
+
+	if (!sameOrder) {
+		ofLogError("Benchmark", "Render queue doesn't keep the order of z-index buckets!");
+	}
+
+	for (auto node : nodes) {
+		delete node;
+	}
+}
+
+void BenchmarkExample::BenchmarkSpritePush() {
+	results.push_back(string_format("Renderer, %d sprite meshes", BENCH_SPRITES_LARGE));
+
+	ofImage atlas;
+	SpriteSheet sheet(&atlas, "sprites", 1, 16, 16, 16, 16);
+	auto renderer = new Renderer();
+	renderer->OnInit();
+	renderer->AddTileLayer(&atlas, "sprites", BENCH_SPRITES_LARGE, 0);
+	vector<SpriteMesh*> meshes;
+
+	for (int i = 0; i < BENCH_SPRITES_LARGE; i++) {
+		auto mesh = new SpriteMesh(Sprite(&sheet, 0), "sprites");
+		mesh->GetTransform().localPos = ofVec3f(ofRandom(0, 1000), ofRandom(0, 1000), (int)ofRandom(0, 3));
+		meshes.push_back(mesh);
+	}
+
+	Measure("PushNode", 20, [&]() {
+		renderer->ClearBuffers();
+		for (auto mesh : meshes) {
+			renderer->PushNode(mesh);
+		}
+	});
+
+	Measure("PushNode + Render", 20, [&]() {
+		renderer->ClearBuffers();
+		for (auto mesh : meshes) {
+			renderer->PushNode(mesh);
+		}
+		renderer->Render();
+	});
+
+	for (auto mesh : meshes) {
+		delete mesh;
+	}
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkCulling() {
+	results.push_back(string_format("Viewport culling, %d chunks of %d sprites, 1/25 of the scene visible", BENCH_CULLING_CHUNKS, BENCH_CULLING_CHUNK_SPRITES));
+
+	ofImage atlas;
+	SpriteSheet sheet(&atlas, "sprites", 1, 16, 16, 16, 16);
+	auto renderer = new Renderer();
+	renderer->SetVirtualWidth(800);
+	renderer->SetVirtualHeight(600);
+	renderer->OnInit();
+	renderer->AddTileLayer(&atlas, "sprites", BENCH_CULLING_CHUNKS * BENCH_CULLING_CHUNK_SPRITES, 0);
+
+	// chunks of 200x600 placed in a row, the viewport covers four of them
+	auto scene = new Scene();
+	auto root = new GameObject("root", nullptr, scene);
+	scene->SetRootObject(root);
+	root->GetTransform().localPos = ofVec3f(-200 * BENCH_CULLING_CHUNKS / 2, 0);
+	vector<GameObject*> sprites;
+
+	for (int i = 0; i < BENCH_CULLING_CHUNKS; i++) {
+		auto chunk = new GameObject("chunk", nullptr, scene);
+		chunk->GetTransform().localPos = ofVec3f(200 * i, 0);
+		root->AddChild(chunk);
+
+		for (int j = 0; j < BENCH_CULLING_CHUNK_SPRITES; j++) {
+			auto sprite = new GameObject("sprite", nullptr, scene, new SpriteMesh(Sprite(&sheet, 0), "sprites"));
+			sprite->GetTransform().localPos = ofVec3f(ofRandom(-8, 192), ofRandom(-8, 592), (int)ofRandom(0, 3));
+			if (j % 3 == 0) {
+				sprite->GetTransform().rotation = ofRandom(0, 360);
+			}
+			chunk->AddChild(sprite);
+			sprites.push_back(sprite);
+		}
+	}
+
+	root->UpdateTransformations();
+
+	function<void(GameObject*, bool)> pushNode = [&](GameObject* node, bool cullSubtrees) {
+		if (cullSubtrees && renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+			return;
+		}
+
+		renderer->PushNode(node->GetRenderable());
+		for (auto child : node->GetChildren()) {
+			pushNode(child, cullSubtrees);
+		}
+	};
+
+	auto render = [&](bool culling, bool cullSubtrees) {
+		renderer->SetCullingEnabled(culling);
+		renderer->ClearBuffers();
+		pushNode(root, cullSubtrees);
+		renderer->Render();
+	};
+
+	Measure("push + Render, no culling", 20, [&]() { render(false, false); });
+	ofLogNotice("Benchmark", "Drawn %d, culled %d nodes", renderer->GetDrawnNodes(), renderer->GetCulledNodes());
+	Measure("push + Render, culling of nodes", 20, [&]() { render(true, false); });
+	ofLogNotice("Benchmark", "Drawn %d, culled %d nodes", renderer->GetDrawnNodes(), renderer->GetCulledNodes());
+	int drawnNodes = renderer->GetDrawnNodes();
+	Measure("push + Render, culling of nodes and subtrees", 20, [&]() { render(true, true); });
+	ofLogNotice("Benchmark", "Drawn %d, culled %d nodes", renderer->GetDrawnNodes(), renderer->GetCulledNodes());
+
+	if (drawnNodes != renderer->GetDrawnNodes() || renderer->GetDrawnNodes() + renderer->GetCulledNodes() != root->GetVisibleSubtreeSize()) {
+		ofLogError("Benchmark", "Culling of subtrees doesn't match culling of nodes!");
+	}
+
+	// sprites whose rotated corners reach into the viewport must never be culled
+	for (auto sprite : sprites) {
+		auto& trans = sprite->GetTransform();
+		float halfSize = 8;
+		float centerX = trans.absPos.x + halfSize;
+		float centerY = trans.absPos.y + halfSize;
+		float angle = trans.rotation * DEG_TO_RAD;
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+		for (int corner = 0; corner < 4; corner++) {
+			float x = (corner & 1) ? halfSize : -halfSize;
+			float y = (corner & 2) ? halfSize : -halfSize;
+			float rotX = centerX + x * cos(angle) - y * sin(angle);
+			float rotY = centerY + x * sin(angle) + y * cos(angle);
+			minX = min(minX, rotX);
+			minY = min(minY, rotY);
+			maxX = max(maxX, rotX);
+			maxY = max(maxY, rotY);
+		}
+
+		bool isInViewport = maxX >= 0 && minX <= 800 && maxY >= 0 && minY <= 600;
+		auto mesh = sprite->GetRenderable();
+		if (isInViewport && (!mesh->HasDrawBounds() || !renderer->IsInViewport(mesh->GetDrawBounds())
+			|| !renderer->IsInViewport(sprite->GetParent()->GetSubtreeBounds()))) {
+			ofLogError("Benchmark", "Visible sprite has been culled!");
+			break;
+		}
+	}
+
+	delete root;
+	delete scene;
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkShapes() {
+	results.push_back(string_format("Shapes, %d rectangles and circles", BENCH_SHAPES));
+
+	// a rectangle scaled twice with its top-left corner at [10, 20]
+	ShapeBatcher batcher;
+	Trans trans(10, 20);
+	trans.scale = ofVec3f(2);
+	trans.SetAbsAsLocal();
+	batcher.AddRect(trans.GetAbsMatrix(), 30, 40, ofColor(255), false);
+	auto& vertices = batcher.GetVertices();
+
+	if (vertices.size() != 6 || vertices[0].x != 10 || vertices[0].y != 20 || vertices[5].x != 70 || vertices[5].y != 100) {
+		ofLogError("Benchmark", "Batched rectangle has wrong vertices!");
+	}
+
+	auto renderer = new Renderer();
+	renderer->SetVirtualWidth(800);
+	renderer->SetVirtualHeight(600);
+	renderer->OnInit();
+	vector<Renderable*> shapes;
+
+	for (int i = 0; i < BENCH_SHAPES; i++) {
+		Renderable* shape;
+		if (i % 2 == 0) {
+			shape = new FRect(ofRandom(5, 50), ofRandom(5, 50), ofColor(255, 0, 0));
+			static_cast<FRect*>(shape)->SetNoFill(i % 10 == 0);
+		}
+		else {
+			shape = new FCircle(ofRandom(5, 20), ofColor(0, 0, 255), i % 10 == 1);
+		}
+
+		auto& shapeTrans = shape->GetTransform();
+		shapeTrans.localPos = ofVec3f(ofRandom(0, 800), ofRandom(0, 600), (int)ofRandom(0, 3));
+		shapeTrans.rotation = ofRandom(0, PI);
+		shapeTrans.SetAbsAsLocal();
+		shapes.push_back(shape);
+	}
+
+	auto render = [&](bool batching) {
+		renderer->SetShapeBatchingEnabled(batching);
+		renderer->ClearBuffers();
+		for (auto shape : shapes) {
+			renderer->PushNode(shape);
+		}
+		renderer->Render();
+	};
+
+	Measure("PushNode + Render, separate shapes", 20, [&]() { render(false); });
+	Measure("PushNode + Render, batched shapes", 20, [&]() { render(true); });
+	ofLogNotice("Benchmark", "Drawn %d shapes by %d calls", renderer->GetShapeBatcher().GetShapesNum(), renderer->GetShapeBatcher().GetDrawCalls());
+
+	for (auto shape : shapes) {
+		delete shape;
+	}
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkTexts() {
+	results.push_back(string_format("Texts, %d scores and %d status labels", BENCH_TEXTS, BENCH_TEXTS / 10));
+
+	ofTrueTypeFont font;
+	auto renderer = new Renderer();
+	renderer->SetVirtualWidth(800);
+	renderer->SetVirtualHeight(600);
+	renderer->OnInit();
+	vector<Text*> texts;
+	vector<Renderable*> meshes;
+
+	for (int i = 0; i < BENCH_TEXTS; i++) {
+		auto text = new Text(&font);
+		text->SetText(string_format("SCORE: %d", i));
+		text->GetTransform().localPos = ofVec3f(ofRandom(0, 700), ofRandom(0, 600));
+		text->GetTransform().SetAbsAsLocal();
+		texts.push_back(text);
+		meshes.push_back(text);
+
+		if (i % 10 == 0) {
+			string status = "IRON: 10\nPETROL: 20\nBUILDING: 30%\nAGENTS: 4";
+			auto label = new Label(&font, status, 200);
+			label->GetTransform().localPos = ofVec3f(ofRandom(0, 600), ofRandom(0, 500));
+			label->GetTransform().SetAbsAsLocal();
+			meshes.push_back(label);
+		}
+	}
+
+	// the batched glyphs have to be placed exactly where the font would draw them
+	auto& first = *texts[0];
+	auto& mesh = font.getStringMesh(first.GetText(), 0, font.getLineHeight() / 2);
+	TextBatcher batcher;
+	batcher.AddText(&font, first.GetTransform().GetAbsMatrix(), first.GetGlyphs(), first.GetColor());
+	auto& vertices = batcher.GetVertices();
+
+	if (vertices.size() != mesh.getIndices().size() || (!vertices.empty()
+		&& (vertices[0].x != mesh.getVertices()[mesh.getIndices()[0]].x + first.GetTransform().absPos.x
+		|| vertices[0].y != mesh.getVertices()[mesh.getIndices()[0]].y + first.GetTransform().absPos.y))) {
+		ofLogError("Benchmark", "Batched text has wrong vertices!");
+	}
+
+	int frame = 0;
+	float width = 0;
+
+	// every tenth frame, all scores change
+	auto render = [&](bool batching) {
+		renderer->SetTextBatchingEnabled(batching);
+		renderer->ClearBuffers();
+		frame++;
+		for (int i = 0; i < (int)texts.size(); i++) {
+			texts[i]->SetText(string_format("SCORE: %d", i + frame / 10));
+			width += texts[i]->GetWidth();
+		}
+		for (auto mesh : meshes) {
+			renderer->PushNode(mesh);
+		}
+		renderer->Render();
+	};
+
+	Measure("SetText + Render, separate texts", 100, [&]() { render(false); });
+	Measure("SetText + Render, batched texts", 100, [&]() { render(true); });
+	ofLogNotice("Benchmark", "Drawn %d texts by %d calls, width %f", renderer->GetTextBatcher().GetTextsNum(), renderer->GetTextBatcher().GetDrawCalls(), width);
+
+	for (auto mesh : meshes) {
+		delete mesh;
+	}
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkAtlas() {
+	results.push_back(string_format("Atlas, %d rectangles, %d images", BENCH_ATLAS_RECTS, BENCH_ATLAS_IMAGES));
+
+	vector<AtlasRegion> rects(BENCH_ATLAS_RECTS);
+	int usedArea = 0;
+	for (auto& rect : rects) {
+		rect.width = (int)ofRandom(8, 64);
+		rect.height = (int)ofRandom(8, 64);
+		usedArea += rect.width * rect.height;
+	}
+
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+	bool fits = false;
+	Measure("Layout of rectangles, MaxRects", 10, [&]() { fits = SpriteAtlas::Layout(rects, 1, atlasWidth, atlasHeight); });
+
+	// packed rectangles mustn't overlap nor exceed the atlas
+	bool isValid = fits;
+	for (int i = 0; i < (int)rects.size() && isValid; i++) {
+		auto& a = rects[i];
+		isValid = a.x >= 0 && a.y >= 0 && a.x + a.width <= atlasWidth && a.y + a.height <= atlasHeight;
+		for (int j = i + 1; j < (int)rects.size() && isValid; j++) {
+			auto& b = rects[j];
+			isValid = a.x >= b.x + b.width || b.x >= a.x + a.width || a.y >= b.y + b.height || b.y >= a.y + a.height;
+		}
+	}
+
+	if (!isValid) {
+		ofLogError("Benchmark", "Packed rectangles overlap or exceed the atlas!");
+	}
+
+	ofLogNotice("Benchmark", "Atlas %dx%d, occupancy %f", atlasWidth, atlasHeight, ((float)usedArea) / (atlasWidth * atlasHeight));
+
+	// images of the Paratrooper game
+	vector<string> paths = { "Paratrooper/cannon.png", "Paratrooper/copter_left.png", "Paratrooper/copter_right.png", "Paratrooper/paratrooper.png",
+		"Paratrooper/paratrooper_parachute.png", "Paratrooper/projectile.png", "Paratrooper/tower.png", "Paratrooper/turret.png" };
+	SpriteAtlas atlas;
+	vector<ofImage> images(paths.size());
+
+	for (int i = 0; i < (int)paths.size(); i++) {
+		atlas.AddImage(paths[i]);
+		images[i].load(paths[i]);
+	}
+
+	bool packed = false;
+	Measure("Packing of images", 1, [&]() { packed = atlas.Pack(); });
+
+	if (!packed) {
+		ofLogError("Benchmark", "Images couldn't be packed!");
+		return;
+	}
+
+	auto renderer = new Renderer();
+	renderer->SetVirtualWidth(800);
+	renderer->SetVirtualHeight(600);
+	renderer->OnInit();
+	vector<ImageMesh*> separateMeshes;
+	vector<ImageMesh*> atlasMeshes;
+
+	for (int i = 0; i < BENCH_ATLAS_IMAGES; i++) {
+		int index = i % paths.size();
+		auto separate = new ImageMesh(&images[index]);
+		auto fromAtlas = new ImageMesh(&atlas, paths[index]);
+		separate->GetTransform().localPos = fromAtlas->GetTransform().localPos = ofVec3f(ofRandom(0, 800), ofRandom(0, 600));
+		separate->GetTransform().SetAbsAsLocal();
+		fromAtlas->GetTransform().SetAbsAsLocal();
+		separateMeshes.push_back(separate);
+		atlasMeshes.push_back(fromAtlas);
+	}
+
+	auto render = [&](vector<ImageMesh*>& meshes) {
+		renderer->ClearBuffers();
+		for (auto mesh : meshes) {
+			renderer->PushNode(mesh);
+		}
+		renderer->Render();
+	};
+
+	Measure("Render, separate images", 100, [&]() { render(separateMeshes); });
+	int separateCalls = renderer->GetImageBatcher().GetDrawCalls();
+	Measure("Render, images of one atlas", 100, [&]() { render(atlasMeshes); });
+	ofLogNotice("Benchmark", "Drawn %d images by %d calls, %d calls without the atlas", renderer->GetImageBatcher().GetImagesNum(),
+		renderer->GetImageBatcher().GetDrawCalls(), separateCalls);
+
+	for (int i = 0; i < BENCH_ATLAS_IMAGES; i++) {
+		delete separateMeshes[i];
+		delete atlasMeshes[i];
+	}
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkLayerGrowth() {
+	results.push_back(string_format("Layer growth, %d sprites, spike of %d sprites", BENCH_GROWTH_QUIET, BENCH_GROWTH_SPIKE));
+
+	ofTexture texture;
+	auto renderer = new SpriteSheetRenderer();
+	// the initial size is only a guess, far below the spike
+	renderer->LoadTexture(&texture, "growing", BENCH_GROWTH_QUIET, 0, true);
+	renderer->LoadTexture(&texture, "presized", BENCH_GROWTH_SPIKE, 0, true);
+	renderer->SetShrinkFrames(BENCH_GROWTH_SHRINK_FRAMES);
+	auto growing = renderer->GetLayer("growing");
+	vector<SpriteTile> tiles(BENCH_GROWTH_SPIKE);
+
+	for (auto& tile : tiles) {
+		tile.width = tile.height = 16;
+		tile.posX = ofRandom(0, 1000);
+		tile.posY = ofRandom(0, 1000);
+	}
+
+	auto drawFrame = [&](const string& layer, int spritesNum) {
+		renderer->ClearCounters(layer);
+		for (int i = 0; i < spritesNum; i++) {
+			renderer->AddTile(tiles[i]);
+		}
+		renderer->Draw();
+	};
+
+	Measure("Spike, growing buffer", 1, [&]() { drawFrame("growing", BENCH_GROWTH_SPIKE); });
+	Measure("Spike, presized buffer", 1, [&]() { drawFrame("presized", BENCH_GROWTH_SPIKE); });
+
+	// no sprite may be lost during the spike
+	if (growing->peakSprites != BENCH_GROWTH_SPIKE) {
+		ofLogError("Benchmark", "Layer has lost sprites during the spike!");
+	}
+
+	ofLogNotice("Benchmark", "After the spike: buffer %d, peak %d, reallocations %d", growing->bufferSize, growing->peakSprites, growing->reallocations);
+
+	// the buffer shrinks back step by step when the load goes down
+	Measure("Quiet frames, growing buffer", 10 * BENCH_GROWTH_SHRINK_FRAMES, [&]() { drawFrame("growing", BENCH_GROWTH_QUIET / 2); });
+
+	if (growing->bufferSize != BENCH_GROWTH_QUIET) {
+		ofLogError("Benchmark", "Layer hasn't shrunk to its initial size!");
+	}
+
+	ofLogNotice("Benchmark", "After quiet frames: buffer %d, peak %d, reallocations %d", growing->bufferSize, growing->peakSprites, growing->reallocations);
+
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkParallelSprites() {
+	results.push_back(string_format("Parallel sprite quads, %d sprites of a multisprite and %d single sprites", BENCH_PARALLEL_SPRITES, BENCH_PARALLEL_SINGLE_SPRITES));
+
+	ofImage atlas;
+	SpriteSheet sheet(&atlas, "parallel", 1, 16, 16, 16, 16);
+	auto renderer = new Renderer();
+	renderer->SetVirtualWidth(800);
+	renderer->SetVirtualHeight(600);
+	renderer->OnInit();
+	renderer->AddTileLayer(&atlas, "parallel", BENCH_PARALLEL_SPRITES + BENCH_PARALLEL_SINGLE_SPRITES, 0);
+	renderer->AddTileLayer(&atlas, "parallel_top", BENCH_PARALLEL_SINGLE_SPRITES, 1);
+
+	// more than half of the sprites is outside the viewport and gets culled
+	auto scene = new Scene();
+	auto multiSprite = new MultiSpriteMesh("parallel");
+	auto root = new GameObject("root", nullptr, scene, multiSprite);
+	scene->SetRootObject(root);
+
+	for (int i = 0; i < BENCH_PARALLEL_SPRITES; i++) {
+		Trans transform;
+		transform.localPos = ofVec3f(ofRandom(-200, 1000), ofRandom(-150, 750));
+		transform.rotation = (i % 3 == 0) ? ofRandom(0, 360) : 0;
+		multiSprite->AddSprite(new Sprite(&sheet, 0, transform));
+	}
+
+	vector<GameObject*> singles;
+	for (int i = 0; i < BENCH_PARALLEL_SINGLE_SPRITES; i++) {
+		auto sprite = new GameObject("sprite", nullptr, scene, new SpriteMesh(Sprite(&sheet, 0), (i % 2 == 0) ? "parallel" : "parallel_top"));
+		sprite->GetTransform().localPos = ofVec3f(ofRandom(0, 784), ofRandom(0, 584), (int)ofRandom(0, 3));
+		root->AddChild(sprite);
+		singles.push_back(sprite);
+	}
+
+	root->UpdateTransformations();
+	auto sheetRenderer = renderer->GetSpriteSheetRenderer();
+
+	auto render = [&]() {
+		renderer->ClearBuffers();
+		renderer->PushNode(multiSprite);
+		for (auto single : singles) {
+			renderer->PushNode(single->GetRenderable());
+		}
+		renderer->Render();
+	};
+
+	// copies quads of both layers, so that the output of all runs can be compared
+	auto copyQuads = [&](vector<SpriteQuad>& output) {
+		output.clear();
+		for (auto name : { "parallel", "parallel_top" }) {
+			auto layer = sheetRenderer->GetLayer(name);
+			output.insert(output.end(), layer->quads, layer->quads + layer->numSprites);
+		}
+	};
+
+	vector<SpriteQuad> expected;
+	vector<SpriteQuad> actual;
+
+	renderer->SetWorkersNum(0);
+	Measure("Render, main thread only", 10, render);
+	copyQuads(expected);
+	int culledSprites = renderer->GetCulledSprites();
+	ofLogNotice("Benchmark", "Drawn %d sprites, culled %d sprites", (int)expected.size(), culledSprites);
+
+	for (int workers : { 1, 3, 7 }) {
+		renderer->SetWorkersNum(workers);
+		Measure(string_format("Render, %d workers", workers), 10, render);
+		copyQuads(actual);
+
+		// the parallel pass must produce the same quads in the same order
+		if (actual.size() != expected.size() || renderer->GetCulledSprites() != culledSprites
+			|| memcmp(actual.data(), expected.data(), sizeof(SpriteQuad) * expected.size()) != 0) {
+			ofLogError("Benchmark", "Quads generated by %d workers differ from the main thread!", workers);
+		}
+	}
+
+	// an unchanged frame must upload nothing, no matter which thread has written the quads
+	sheetRenderer->SetGpuBuffersEnabled(true);
+
+	// each of the cycling buffer objects is filled once
+	for (int i = 0; i <= SPRITE_LAYER_GPU_BUFFERS; i++) {
+		render();
+	}
+
+	if (sheetRenderer->GetUploadedBytes() != 0) {
+		ofLogError("Benchmark", "Unchanged frame has uploaded %d bytes!", sheetRenderer->GetUploadedBytes());
+	}
+
+	delete root;
+	delete scene;
+	delete renderer;
+}
+
+void BenchmarkExample::BenchmarkHeadlessFrames() {
+	results.push_back(string_format("Headless frames, %d sprites and %d shapes", BENCH_HEADLESS_SPRITES, BENCH_HEADLESS_SHAPES));
+
+	HeadlessRenderer headless("headless", 16, BENCH_HEADLESS_SPRITES);
+	auto& backend = headless.backend;
+	auto renderer = headless.renderer;
+	SpriteSheet sheet(&headless.atlas, "headless", 1, 16, 16, 16, 16);
+
+	vector<Renderable*> nodes;
+
+	for (int i = 0; i < BENCH_HEADLESS_SPRITES; i++) {
+		auto sprite = new SpriteMesh(Sprite(&sheet, 0), "headless");
+		auto& trans = sprite->GetTransform();
+		trans.localPos = ofVec3f(ofRandom(-16, 800), ofRandom(-16, 600), (int)ofRandom(0, 3));
+		trans.rotation = (i % 3 == 0) ? ofRandom(0, 360) : 0;
+		trans.SetAbsAsLocal();
+		nodes.push_back(sprite);
+	}
+
+	for (int i = 0; i < BENCH_HEADLESS_SHAPES; i++) {
+		Renderable* shape;
+		if (i % 2 == 0) {
+			shape = new FRect(ofRandom(5, 50), ofRandom(5, 50), ofColor(0, 255, 0));
+			static_cast<FRect*>(shape)->SetNoFill(i % 10 == 0);
+		}
+		else {
+			shape = new FCircle(ofRandom(5, 20), ofColor(0, 0, 255, 128), i % 10 == 1);
+		}
+
+		auto& trans = shape->GetTransform();
+		trans.localPos = ofVec3f(ofRandom(0, 800), ofRandom(0, 600), (int)ofRandom(0, 3));
+		trans.SetAbsAsLocal();
+		nodes.push_back(shape);
+	}
+
+	auto frame = [&]() {
+		renderer->ClearBuffers();
+		renderer->BeginRender();
+		for (auto node : nodes) {
+			renderer->PushNode(node);
+		}
+		renderer->Render();
+		renderer->EndRender();
+	};
+
+	Measure("Frame, null backend", 50, frame);
+	auto& stats = backend.GetStats();
+	ofLogNotice("Benchmark", "%d draw calls, %d vertices, %d state changes, %d texture binds", stats.drawCalls, stats.vertices, stats.stateChanges, stats.textureBinds);
+
+	if (stats.drawCalls != (int)backend.GetDrawCalls().size()) {
+		ofLogError("Benchmark", "Recorded draw calls don't match the statistics!");
+	}
+
+	backend.SetRasterizationEnabled(true);
+	Measure("Frame, software rasterizer", 5, frame);
+	unsigned int hash = backend.GetFramebufferHash();
+	frame();
+
+	if (backend.GetFramebufferHash() != hash) {
+		ofLogError("Benchmark", "Two identical frames differ!");
+	}
+
+	// the emulated buffer objects must contain exactly what the client-side arrays contain
+	auto sheetRenderer = renderer->GetSpriteSheetRenderer();
+	sheetRenderer->SetGpuBuffersEnabled(true);
+	for (int i = 0; i <= SPRITE_LAYER_GPU_BUFFERS; i++) {
+		frame();
+	}
+
+	if (backend.GetFramebufferHash() != hash || stats.uploadedBytes != 0) {
+		ofLogError("Benchmark", "Frame drawn from buffer objects differs from the one drawn from arrays!");
+	}
+
+	sheetRenderer->SetGpuBuffersEnabled(false);
+
+	// quads generated in parallel must be drawn the same way
+	renderer->SetWorkersNum(3);
+	frame();
+
+	if (backend.GetFramebufferHash() != hash) {
+		ofLogError("Benchmark", "Frame with sprites generated in parallel differs!");
+	}
+
+	ofLogNotice("Benchmark", "Frame hash %08x", hash);
+
+	for (auto node : nodes) {
+		delete node;
+	}
+}
+
+void BenchmarkExample::BenchmarkInstancedSprites() {
+	results.push_back(string_format("Instanced multisprite, %d sprites", BENCH_INSTANCED_SPRITES));
+
+	HeadlessRenderer headless("instanced", 16, BENCH_INSTANCED_SPRITES);
+	auto& backend = headless.backend;
+	auto renderer = headless.renderer;
+	renderer->SetWorkersNum(0);
+	SpriteSheet sheet(&headless.atlas, "instanced", 1, 16, 16, 16, 16);
+
+	// all sprites are inside the viewport, hence culling of quads doesn't change the frame
+	auto scene = new Scene();
+	auto multiSprite = new MultiSpriteMesh("instanced");
+	auto root = new GameObject("root", nullptr, scene, multiSprite);
+	scene->SetRootObject(root);
+
+	for (int i = 0; i < BENCH_INSTANCED_SPRITES; i++) {
+		Trans transform;
+		transform.localPos = ofVec3f(ofRandom(16, 768), ofRandom(16, 568));
+		transform.rotation = (i % 3 == 0) ? ofRandom(0, 360) : 0;
+		transform.scale = (i % 5 == 0) ? ofVec3f(1.5f) : ofVec3f(1);
+		multiSprite->AddSprite(new Sprite(&sheet, 0, transform));
+	}
+
+	root->UpdateTransformations();
+	auto sheetRenderer = renderer->GetSpriteSheetRenderer();
+	auto& sprites = multiSprite->GetSprites();
+
+	auto frame = [&]() {
+		renderer->ClearBuffers();
+		renderer->BeginRender();
+		renderer->PushNode(multiSprite);
+		renderer->Render();
+		renderer->EndRender();
+	};
+
+	// sprites move each frame, so that the instances have to be made again
+	auto movingFrame = [&]() {
+		for (int i = 0; i < BENCH_INSTANCED_MOVED; i++) {
+			sprites[(int)ofRandom(0, BENCH_INSTANCED_SPRITES)]->GetTransform().localPos.x += 0.5f;
+		}
+		multiSprite->InvalidateInstances();
+		frame();
+	};
+
+	Measure("Frame, quads", 20, frame);
+	ofLogNotice("Benchmark", "Quads upload %d bytes per frame", sheetRenderer->GetUploadedBytes());
+
+	multiSprite->SetInstanced(true);
+	Measure("Frame, instances", 20, frame);
+
+	if (sheetRenderer->GetUploadedBytes() != 0) {
+		ofLogError("Benchmark", "Unchanged instances have uploaded %d bytes!", sheetRenderer->GetUploadedBytes());
+	}
+
+	Measure(string_format("Frame, instances, %d sprites moved", BENCH_INSTANCED_MOVED), 20, movingFrame);
+	int movedBytes = sheetRenderer->GetUploadedBytes();
+	ofLogNotice("Benchmark", "Moved instances upload %d bytes per frame", movedBytes);
+
+	if (movedBytes == 0 || movedBytes > BENCH_INSTANCED_MOVED * (SPRITE_INSTANCE_UPLOAD_GAP + 1) * (int)sizeof(SpriteInstance)) {
+		ofLogError("Benchmark", "Moved instances have uploaded %d bytes!", movedBytes);
+	}
+
+	// instances of a static mesh are neither made nor uploaded again
+	multiSprite->SetStatic(true);
+	frame();
+	Measure("Frame, static instances", 20, frame);
+
+	if (sheetRenderer->GetUploadedBytes() != 0) {
+		ofLogError("Benchmark", "Static instances have uploaded %d bytes!", sheetRenderer->GetUploadedBytes());
+	}
+
+	// instances must be drawn exactly as quads
+	backend.SetRasterizationEnabled(true);
+	multiSprite->SetInstanced(false);
+	frame();
+	unsigned int hash = backend.GetFramebufferHash();
+	multiSprite->SetInstanced(true);
+	frame();
+
+	if (backend.GetFramebufferHash() != hash) {
+		ofLogError("Benchmark", "Frame drawn by instancing differs from the one drawn by quads!");
+	}
+
+	auto& drawCalls = backend.GetDrawCalls();
+	if (drawCalls.empty() || drawCalls.front().type != DrawCallType::SPRITE_INSTANCES) {
+		ofLogError("Benchmark", "Instances haven't been drawn by an instanced draw call!");
+	}
+
+	ofLogNotice("Benchmark", "Frame hash %08x", hash);
+
+	delete root;
+	delete scene;
+}
+
+void BenchmarkExample::BenchmarkTileMap() {
+	results.push_back(string_format("Tile map, %dx%d tiles", BENCH_TILEMAP_SIZE, BENCH_TILEMAP_SIZE));
+
+	HeadlessRenderer headless("tilemap", 64, 1000);
+	auto& backend = headless.backend;
+	auto renderer = headless.renderer;
+	renderer->SetWorkersNum(0);
+	// 16 frames of 16x16 pixels
+	SpriteSheet sheet(&headless.atlas, "tilemap", 16, 16, 16, 64, 64);
+
+	auto scene = new Scene();
+	auto root = new GameObject("root", nullptr, scene);
+	scene->SetRootObject(root);
+	auto tileMap = new TileMapMesh("tilemap", &sheet, BENCH_TILEMAP_SIZE, BENCH_TILEMAP_SIZE, 16, 16);
+	auto multiSprite = new MultiSpriteMesh("tilemap");
+	auto mapObject = new GameObject("map", nullptr, scene, tileMap);
+	auto multiObject = new GameObject("multi", nullptr, scene, multiSprite);
+	root->AddChild(mapObject);
+	root->AddChild(multiObject);
+
+	// the view lies in the middle of the map, so that chunks on all sides are culled
+	for (auto obj : { mapObject, multiObject }) {
+		obj->GetTransform().localPos = ofVec3f(-1000.5f, -1200.25f);
+		obj->GetTransform().scale = ofVec3f(1.5f);
+	}
+
+	for (int row = 0; row < BENCH_TILEMAP_SIZE; row++) {
+		for (int column = 0; column < BENCH_TILEMAP_SIZE; column++) {
+			// some tiles are empty
+			int frame = (row * 7 + column * 3) % 17 - 1;
+			tileMap->SetTile(column, row, frame);
+
+			if (frame >= 0) {
+				Trans transform;
+				transform.localPos = ofVec3f(column * 16, row * 16);
+				multiSprite->AddSprite(new Sprite(&sheet, frame, transform));
+			}
+		}
+	}
+
+	root->UpdateTransformations();
+	auto sheetRenderer = renderer->GetSpriteSheetRenderer();
+
+	auto frame = [&](Renderable* mesh) {
+		renderer->ClearBuffers();
+		renderer->BeginRender();
+		renderer->PushNode(mesh);
+		renderer->Render();
+		renderer->EndRender();
+	};
+
+	Measure("Frame, multisprite", 10, [&]() { frame(multiSprite); });
+	ofLogNotice("Benchmark", "Multisprite uploads %d bytes per frame", sheetRenderer->GetUploadedBytes());
+
+	frame(tileMap);
+	ofLogNotice("Benchmark", "Tile map has baked %d bytes", sheetRenderer->GetUploadedBytes());
+	Measure("Frame, tile map", 100, [&]() { frame(tileMap); });
+
+	if (sheetRenderer->GetUploadedBytes() != 0) {
+		ofLogError("Benchmark", "Unchanged tile map has uploaded %d bytes!", sheetRenderer->GetUploadedBytes());
+	}
+
+	// only the chunk of the changed tile is baked and uploaded again; the tiles lie in the center of the view
+	int changes = 0;
+	int centerColumn = (int)((400 + 1000.5f) / (16 * 1.5f));
+	int centerRow = (int)((300 + 1200.25f) / (16 * 1.5f));
+	Measure("Frame, tile map, one tile changed", 100, [&]() {
+		tileMap->SetTile(centerColumn + changes % 4, centerRow, changes % 16);
+		changes++;
+		frame(tileMap);
+	});
+
+	int chunkBytes = TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE * sizeof(SpriteQuad);
+	if (sheetRenderer->GetUploadedBytes() == 0 || sheetRenderer->GetUploadedBytes() > chunkBytes) {
+		ofLogError("Benchmark", "Changed tile has uploaded %d bytes!", sheetRenderer->GetUploadedBytes());
+	}
+
+	// restore the tiles, so that both meshes contain the same sprites
+	for (int column = centerColumn; column < centerColumn + 4; column++) {
+		tileMap->SetTile(column, centerRow, (centerRow * 7 + column * 3) % 17 - 1);
+	}
+
+	// visible chunks must be drawn exactly as the sprites of the multisprite
+	backend.SetRasterizationEnabled(true);
+	frame(multiSprite);
+	unsigned int hash = backend.GetFramebufferHash();
+	frame(tileMap);
+	int drawnChunks = backend.GetDrawCalls().size();
+
+	if (backend.GetFramebufferHash() != hash) {
+		ofLogError("Benchmark", "Tile map differs from the multisprite!");
+	}
+
+	ofLogNotice("Benchmark", "Drawn %d of %d chunks, culled %d sprites", drawnChunks, tileMap->GetChunksNum(), renderer->GetCulledSprites());
+	ofLogNotice("Benchmark", "Frame hash %08x", hash);
+
+	delete root;
+	delete scene;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "ofMain.h"
+#include <functional>
+
+/**
+ * Runs engine micro-benchmarks once at startup and shows the results
+ * Results are also written into the log so that they can be collected from the console
+ */
+class BenchmarkExample : public ofBaseApp {
+public:
+	// formatted results, one line per measurement
+	vector<string> results;
+
+	void setup();
+	void update();
+	void draw();
+
+protected:
+	/**
+	* Runs given function several times and stores the average time in microseconds
+	* @param name name of the measurement
+	* @param repeat number of repetitions
+	* @param func measured function
+	*/
+	void Measure(string name, int repeat, std::function<void()> func);
+
+	/**
+	* Scene lookups by name, flag and network id at 100k objects
+	*/
+	void BenchmarkSceneLookups();
+
+	/**
+	* Spawning and despawning of objects in scenes of various sizes
+	*/
+	void BenchmarkSceneChurn();
+
+	/**
+	* Update of 50k dynamics components, updated by their owners or by a component pool
+	*/
+	void BenchmarkComponentPools();
+
+	/**
+	* Building and tearing down a scene with the global heap and with the arena of the scene
+	*/
+	void BenchmarkSceneAllocator();
+
+	/**
+	* Reading attributes by their keys and via cached handles
+	*/
+	void BenchmarkAttributes();
+
+	/**
+	* Synchronous messaging compared to queued messages dispatched in batches
+	*/
+	void BenchmarkMessaging();
+
+	/**
+	* Moving objects in a loose quad tree compared to rebuilding the tree of QuadTreeExample each frame
+	*/
+	void BenchmarkSpatialIndex();
+
+	/**
+	* Transformation update of a static scene and of a scene where a few objects move
+	*/
+	void BenchmarkTransforms();
+
+	/**
+	* Sprite frames drawn from client-side arrays and from buffer objects updated by changed ranges
+	*/
+	void BenchmarkSpriteBatches();
+
+	/**
+	* Throughput of SpriteSheetRenderer::AddTile with and without rotation
+	*/
+	void BenchmarkAddTile();
+
+	/**
+	* Ordering of nodes by z-index in maps of vectors compared to the render queue
+	*/
+	void BenchmarkRenderQueue();
+
+	/**
+	* Pushing sprite meshes into the renderer and generating their quads
+	*/
+	void BenchmarkSpritePush();
+
+	/**
+	* Viewport culling of a scene that is much larger than the viewport
+	*/
+	void BenchmarkCulling();
+
+	/**
+	* Drawing rectangles and circles separately and in batches
+	*/
+	void BenchmarkShapes();
+
+	/**
+	* Drawing texts and labels separately and in batches
+	*/
+	void BenchmarkTexts();
+
+	/**
+	* Packing of images into an atlas and drawing separate images vs images of one atlas
+	*/
+	void BenchmarkAtlas();
+
+	/**
+	* Growth and shrinking of sprite layer buffers under a load spike
+	*/
+	void BenchmarkLayerGrowth();
+
+	/**
+	* Generation of sprite quads by the worker pool, compared with the main thread
+	*/
+	void BenchmarkParallelSprites();
+
+	/**
+	* Whole frames drawn by the software backend, without any window
+	*/
+	void BenchmarkHeadlessFrames();
+
+	/**
+	* Multisprite drawn by instancing, compared with its quads
+	*/
+	void BenchmarkInstancedSprites();
+
+	/**
+	* Large tile map baked into chunks, compared with the same tiles in a multisprite
+	*/
+	void BenchmarkTileMap();
+};
@@ -78,6 +78,10 @@ void ComponentExample::setup() {
 }
 
 void ComponentExample::PushNodeIntoRenderer(GameObject* node) {
+	if (renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+		return;
+	}
+
 	renderer->PushNode(node->GetRenderable());
 
 	for (auto child : node->GetChildren()) {
@@ -97,6 +101,8 @@ void ComponentExample::update() {
 	uint64 fixDelta = (delta < expectedDelta) ? expectedDelta : (delta < (2 * expectedDelta)) ? delta : (2 * expectedDelta);
 
 	scene->GetRootObject()->Update(fixDelta, absolute);
+	scene->UpdateComponentPools(fixDelta, absolute);
+	scene->DispatchMessages();
 	scene->GetRootObject()->UpdateTransformations();
 }
 
@@ -37,7 +37,8 @@ void ComponentExample2::setup() {
 				mesh->SetColor(ofColor(0, 255, 0));
 			}
 
-			obj->AddComponent(new DynamicsComponent());
+			// dynamics of all objects are updated in one batch
+			obj->AddComponent(scene->GetComponentPool<DynamicsComponent>()->Create());
 			rootObject->AddChild(obj);
 
 			// set positions
@@ -47,6 +48,10 @@ void ComponentExample2::setup() {
 }
 
 void ComponentExample2::PushNodeIntoRenderer(GameObject* node) {
+	if (renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+		return;
+	}
+
 	renderer->PushNode(node->GetRenderable());
 
 	for (auto child : node->GetChildren()) {
@@ -66,6 +71,8 @@ void ComponentExample2::update() {
 	uint64 fixDelta = (delta < expectedDelta) ? expectedDelta : (delta < (2 * expectedDelta)) ? delta : (2 * expectedDelta);
 
 	scene->GetRootObject()->Update(fixDelta, absolute);
+	scene->UpdateComponentPools(fixDelta, absolute);
+	scene->DispatchMessages();
 	scene->GetRootObject()->UpdateTransformations();
 }
 
@@ -127,15 +127,16 @@ void NetworkExample::Init() {
 	float desiredSceneHeight = 25.0f;
 	float autoScale = ofGetWindowSize().y / desiredSceneHeight;
 	this->meshDefaultScale = 1.0f / autoScale * (ofGetWindowSize().y / 400.0f);
-	rootBorder = new FRect(ofGetWindowSize().x / autoScale, ofGetWindowSize().y / autoScale, ofColor(0));
-	rootBorder->SetIsRenderable(false);
 }
 
 void NetworkExample::Reset() {
-	if (scene->GetRootObject() != nullptr) {
-		delete scene->GetRootObject();
-	}
+	// destroy the previous game and release its memory
+	scene->Clear();
 
+	// the root owns its mesh, hence a new one is created for each game
+	float autoScale = ofGetWindowSize().y / 25.0f;
+	auto rootBorder = new FRect(ofGetWindowSize().x / autoScale, ofGetWindowSize().y / autoScale, ofColor(0));
+	rootBorder->SetIsRenderable(false);
 	auto rootObject = new GameObject("root", this, scene, rootBorder);
 	scene->SetRootObject(rootObject);;
 
@@ -102,9 +102,6 @@ public:
 
 class NetworkExample : public AphApp {
 public:
-	// border of the root element
-	FRect* rootBorder;
-
 	/**
 	 * Initializes the game
 	 */
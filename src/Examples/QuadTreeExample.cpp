@@ -1,165 +1,5 @@
 #include "QuadTreeExample.h"
 
-// a node of a quad tree
-struct QuadTreeItem {
-	float x;
-	float y;
-	int width;
-	int height;
-	float vx;
-	float vy;
-};
-
-// bounding box 
-struct QTBounds {
-	float x;
-	float y;
-	int width;
-	int height;
-};
-
-
-template<typename T>
-class Quadtree {
-public:
-	QTBounds bounds;
-	int max_objects;
-	int max_levels;
-	int level;
-
-	// children
-	Quadtree* topRight = nullptr;
-	Quadtree* topLeft = nullptr;
-	Quadtree* bottomLeft = nullptr;
-	Quadtree* bottomRight = nullptr;
-
-	vector<T> objects;
-
-	Quadtree(QTBounds& bounds, int max_objects = 1, int max_levels = 8, int level = 0) {
-		this->bounds = bounds;
-		this->max_objects = max_objects;
-		this->max_levels = max_levels;
-		this->level = level;
-	}
-
-
-	void split() {
-		auto nextLevel = this->level + 1;
-		int subWidth = round(bounds.width / 2);
-		int subHeight = round(bounds.height / 2);
-		float x = round(bounds.x);
-		float y = round(bounds.y);
-
-		auto topRight = QTBounds{ x + subWidth, y, subWidth, subHeight };
-		auto topLeft = QTBounds{ x, y, subWidth, subHeight };
-		auto bottomLeft = QTBounds{ x, y + subHeight, subWidth, subHeight };
-		auto bottomRight = QTBounds{ x + subWidth, y + subHeight, subWidth, subHeight };
-
-		this->topRight = (new Quadtree(topRight, max_objects, max_levels, nextLevel));
-		this->topLeft = (new Quadtree(topLeft, max_objects, max_levels, nextLevel));
-		this->bottomLeft = (new Quadtree(bottomLeft, max_objects, max_levels, nextLevel));
-		this->bottomRight = (new Quadtree(bottomRight, max_objects, max_levels, nextLevel));
-	}
-
-	int getIndex(T& rect) {
-		int index = -1;
-		int verticalMidpoint = bounds.x + (bounds.width / 2);
-		int horizontalMidpoint = bounds.y + (bounds.height / 2);
-		bool topQuadrant = rect.y < horizontalMidpoint && (rect.y + rect.height) < horizontalMidpoint;
-		bool bottomQuadrant = rect.y > horizontalMidpoint;
-
-		// find appropriate index according to the midpoints
-		if (rect.x < verticalMidpoint && rect.x + rect.width < verticalMidpoint) {
-			if (topQuadrant) {
-				index = 1;
-			}
-			else if (bottomQuadrant) {
-				index = 2;
-			}
-		}
-		else if (rect.x > verticalMidpoint) {
-			if (topQuadrant) {
-				index = 0;
-			}
-			else if (bottomQuadrant) {
-				index = 3;
-			}
-		}
-
-		return index;
-	}
-
-	void insert(T& rect) {
-		int i = 0;
-		int index;
-
-		// if we have subnodes
-		if (topRight != nullptr) {
-			index = getIndex(rect);
-			if (index != -1) {
-				switch (index) {
-				case 0: topRight->insert(rect);
-					break;
-				case 1: topLeft->insert(rect);
-					break;
-				case 2: bottomLeft->insert(rect);
-					break;
-				case 3: bottomRight->insert(rect);
-					break;
-				}
-
-				return;
-			}
-		}
-
-		objects.push_back(rect);
-
-		if (objects.size() > max_objects && level < max_levels) {
-			// split if we don't already have subnodes
-			if (topRight == nullptr) {
-				this->split();
-			}
-
-			// add all objects to corresponding nodes
-			while (i < objects.size()) {
-				auto& obj = this->objects[i];
-				index = this->getIndex(obj);
-				objects.erase(objects.begin() + i);
-
-				if (index != -1) {
-					switch (index) {
-					case 0: topRight->insert(obj);
-						break;
-					case 1: topLeft->insert(obj);
-						break;
-					case 2: bottomLeft->insert(obj);
-						break;
-					case 3: bottomRight->insert(obj);
-						break;
-					}
-				}
-				else {
-					i++;
-				}
-			}
-		}
-	}
-
-	void clear() {
-		objects.clear();
-
-		if (topRight != nullptr) {
-			topRight->clear();
-			topLeft->clear();
-			bottomLeft->clear();
-			bottomRight->clear();
-		}
-
-		topRight = topLeft = bottomLeft = bottomRight = nullptr;
-	}
-
-};
-
 Quadtree<QuadTreeItem>* tree;
 vector<QuadTreeItem> items;
 
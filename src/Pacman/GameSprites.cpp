@@ -3,7 +3,7 @@
 #include "SpriteSheetBuilder.h"
 #include "GameObject.h"
 
-void GameSprites::Initialize(ofImage* mapImage, ofImage* spritesImage) {
+void GameSprites::Initialize(ofImage* mapImage, ofImage* spritesImage, int gridWidth, int gridHeight, int blockWidth, int blockHeight) {
 	// build sprites
 	SpriteSheetBuilder builder;
 
@@ -49,8 +49,8 @@ void GameSprites::Initialize(ofImage* mapImage, ofImage* spritesImage) {
 	spiderGate = new Sprite(spritesheets["spider_gate"], 0, trans);
 	staticMesh->AddSprite(spiderGate);
 
-	// create mesh for dots
-	dotMesh = new MultiSpriteMesh("spriteLayer");
+	// create map of dots
+	dotMap = new TileMapMesh("spriteLayer", spritesheets["gems"], gridWidth, gridHeight, blockWidth, blockHeight);
 	// create mesh for pellets
 	pelletMesh = new MultiSpriteMesh("spriteLayer");
 	// create mesh for spiders
@@ -65,11 +65,10 @@ void GameSprites::Initialize(ofImage* mapImage, ofImage* spritesImage) {
 }
 
 void GameSprites::Reset() {
-	dotSprites.clear();
 	pelletSprites.clear();
 	spiderMesh->RemoveAllSprites();
 	pelletMesh->RemoveAllSprites();
-	dotMesh->RemoveAllSprites();
+	dotMap->Clear();
 
 }
 
@@ -84,21 +83,14 @@ void GameSprites::RemoveSpider(Sprite* spider) {
 	spiderMesh->RemoveSprite(spider, true);
 }
 
-void GameSprites::AddPacDot(Trans& position, int mapIndex) {
-	auto dotSprite = new Sprite(spritesheets["gems"], 1, position);
-	// add into collection of sprites
-	dotSprites[mapIndex] = dotSprite;
-	// add into mesh (renderer needs it)
-	dotMesh->AddSprite(dotSprite);
+void GameSprites::AddPacDot(int mapIndex) {
+	// the second frame of gems is the dot
+	dotMap->SetTile(mapIndex % dotMap->GetColumns(), mapIndex / dotMap->GetColumns(), 1);
 }
 
 void GameSprites::RemovePacDot(int mapIndex) {
-	auto mesh = dotSprites.find(mapIndex);
-	auto sprite = mesh->second;
-	// add into collection of sprites
-	dotSprites.erase(mesh);
-	// add into mesh (renderer needs it)
-	dotMesh->RemoveSprite(sprite);
+	// only the chunk of the dot is baked again
+	dotMap->ClearTile(mapIndex % dotMap->GetColumns(), mapIndex / dotMap->GetColumns());
 }
 
 void GameSprites::AddPellet(Trans& position, int mapIndex) {
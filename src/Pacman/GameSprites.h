@@ -8,6 +8,7 @@ using namespace std;
 // forward declaration
 class Sprite;
 class MultiSpriteMesh;
+class TileMapMesh;
 class SpriteMesh;
 class SpriteSheet;
 class Text;
@@ -20,7 +21,6 @@ struct GameSprites {
 	map<string, SpriteSheet*> spritesheets;
 
 	// sprites mapped by their map indices 0 gives [0,0], 1 gives [0,1] and so on
-	map<int, Sprite*> dotSprites;
 	map<int, Sprite*> pelletSprites;
 
 	// these sprites are inside staticMesh, however we need to animate them. 
@@ -38,8 +38,8 @@ struct GameSprites {
 	SpriteMesh* background;
 	// mesh for map elements (gate, spawner, river, fountain)
 	MultiSpriteMesh* staticMesh;
-	// mesh for pac-dot sprites
-	MultiSpriteMesh* dotMesh;
+	// map of pac-dots, one tile per map block; the dots never move, hence they are baked into chunks
+	TileMapMesh* dotMap;
 	// mesh for power-pellets
 	MultiSpriteMesh* pelletMesh;
 	// mesh for spiders
@@ -47,7 +47,14 @@ struct GameSprites {
 
 	Text* textMesh;
 
-	void Initialize(ofImage* mapImage, ofImage* spritesImage);
+	/**
+	* Creates all sprites and meshes
+	* @param gridWidth number of map blocks along the x axis
+	* @param gridHeight number of map blocks along the y axis
+	* @param blockWidth width of one map block
+	* @param blockHeight height of one map block
+	*/
+	void Initialize(ofImage* mapImage, ofImage* spritesImage, int gridWidth, int gridHeight, int blockWidth, int blockHeight);
 
 	void Reset();
 
@@ -55,7 +62,7 @@ struct GameSprites {
 
 	void RemoveSpider(Sprite* spider);
 
-	void AddPacDot(Trans& position, int mapIndex);
+	void AddPacDot(int mapIndex);
 
 	void RemovePacDot(int mapIndex);
 
@@ -26,12 +26,16 @@ void PacmanApp::setup() {
 		renderer->AddTileLayer(mapImage, "bgrLayer", 1, 2);
 
 		// initialize all sprites
-		sprites.Initialize(mapImage, spritesImage);
+		sprites.Initialize(mapImage, spritesImage, gridWidth, gridHeight, blockWidth, blockHeight);
+
+		// dots are in the centers of map blocks, the same z-index as the other sprites
+		auto dotsOrigin = MapToWorld(0.5f, 0.5f);
+		sprites.dotMap->GetTransform().localPos = ofVec3f(dotsOrigin.x, dotsOrigin.y, 0);
 
 		// add all meshes into separate collection for rendering
 		meshes.push_back(sprites.background);
 		meshes.push_back(sprites.staticMesh);
-		meshes.push_back(sprites.dotMesh);
+		meshes.push_back(sprites.dotMap);
 		meshes.push_back(sprites.pelletMesh);
 		meshes.push_back(sprites.spiderMesh);
 		meshes.push_back(sprites.textMesh);
@@ -80,7 +84,7 @@ void PacmanApp::ResetGame() {
 				}
 				else {
 					// add dot entity
-					sprites.AddPacDot(trans, index);
+					sprites.AddPacDot(index);
 					remainingDots++;
 				}
 			}
@@ -374,7 +378,12 @@ void PacmanApp::draw() {
 	// add objects into renderer
 	for (auto mesh : meshes) {
 		// update transformation (actually, this may be done in update() method)
-		mesh->GetTransform().CalcAbsTransform(rootTransform);
+		// the map doesn't move, hence its transformations are recalculated only when the window is resized
+		if (!mesh->GetTransform().IsAbsTransformValid(rootTransform)) {
+			mesh->GetTransform().CalcAbsTransform(rootTransform);
+		}
+		// draw bounds are needed for culling
+		mesh->RefreshBoundingBox();
 		renderer->PushNode(mesh);
 	}
 
@@ -5,6 +5,7 @@
 #include "TransformBuilder.h"
 #include "GameValues.h"
 #include "Scene.h"
+#include "CollisionWorld.h"
 
 /**
  * Trigger that holds both unit and its colliding projectile
@@ -19,50 +20,39 @@ struct CollisionTrigger {
  */
 class CollisionManager : public Component {
 private:
-	vector<GameObject*> units; // list of all units
-	vector<GameObject*> projectiles; // list of all projectiles
+	// broad phase over the flag index of the scene, no need to track added or removed objects
+	CollisionWorld* world = nullptr;
+	// triggers of the current frame, reused every frame
+	vector<CollisionTrigger> triggers;
 public:
 
-	virtual void Init() {
-		// we need to refresh both collections whenever a game object is either
-		// added or removed. A bit ineffective, however... what the hell
-		RegisterSubscriber(OBJECT_ADDED);
-		RegisterSubscriber(OBJECT_REMOVED);
+	~CollisionManager() {
+		delete world;
 	}
 
-	virtual void OnMessage(Msg& msg) {
-		if (msg.GetAction() == OBJECT_ADDED || msg.GetAction() == OBJECT_REMOVED) {
-			projectiles.clear();
-			units.clear();
-			// refresh both collections
-			owner->GetScene()->FindGameObjectsByFlag(FLAG_PROJECTILE, projectiles);
-			owner->GetScene()->FindGameObjectsByFlag(FLAG_COLLIDABLE, units);
-		}
+	virtual void Init() {
+		world = new CollisionWorld(owner->GetScene());
 	}
 
-
 	virtual void Update(uint64_t delta, uint64_t absolute) {
 
-		vector<CollisionTrigger*> collides;
+		triggers.clear();
+
+		// candidates whose bounding boxes overlap
+		for (auto& pair : world->FindCollisions(FLAG_PROJECTILE, FLAG_COLLIDABLE)) {
+			auto projectile = pair.first;
+			auto unit = pair.second;
 
-		// O(m^n), we don't suppose there will be more than 50 units in total
-		for (auto projectile : projectiles) {
-			if (!projectile->HasFlag(FLAG_DEAD)) {
-				for (auto unit : units) {
-					if (!unit->HasFlag(FLAG_DEAD)) {
-						if (Collides(projectile, unit)) {
-							ofLogNotice("CollisionManager", "Collision with %s", unit->GetName().c_str());
-							collides.push_back(new CollisionTrigger{ unit, projectile });
-						}
-					}
-				}
+			if (!projectile->HasFlag(FLAG_DEAD) && !unit->HasFlag(FLAG_DEAD) && Collides(projectile, unit)) {
+				ofLogNotice("CollisionManager", "Collision with %s", unit->GetName().c_str());
+				triggers.push_back(CollisionTrigger{ unit, projectile });
 			}
 		}
 
 		// for each colliding pair, send a message
-		for (auto collid : collides) {
-			SendMsg(COLLISION, collid);
-			delete collid;
+		// the triggers are collected first, since the handlers may add or remove objects
+		for (auto& trigger : triggers) {
+			SendMsg(COLLISION, &trigger);
 		}
 	}
 
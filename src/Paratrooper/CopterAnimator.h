@@ -21,11 +21,11 @@ public:
 		if (ofSign(velocity.x) != ofSign(lastVelocity.x) || lastVelocity.x == 0) {
 			if (velocity.x < 0) {
 				// to the left
-				owner->GetMesh<ImageMesh>()->SetImage(owner->GetContext()->GetImage(FILE_COPTER_LEFT));
+				owner->GetMesh<ImageMesh>()->SetImage(owner->GetContext()->GetSpriteAtlas(), FILE_COPTER_LEFT);
 			}
 			else {
 				// to the right
-				owner->GetMesh<ImageMesh>()->SetImage(owner->GetContext()->GetImage(FILE_COPTER_RIGHT));
+				owner->GetMesh<ImageMesh>()->SetImage(owner->GetContext()->GetSpriteAtlas(), FILE_COPTER_RIGHT);
 			}
 		}
 
@@ -58,4 +58,6 @@ extern StrId ACTION_FIRE;
 #define FILE_PROJECTILE "Paratrooper/projectile.png"
 #define FILE_TOWER "Paratrooper/tower.png"
 #define FILE_TURRET "Paratrooper/turret.png"
+// cached atlas of all images, without extension
+#define FILE_ATLAS "Paratrooper/atlas"
 
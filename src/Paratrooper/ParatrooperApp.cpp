@@ -35,6 +35,18 @@ void ParatrooperApp::setup() {
 		playingSounds[FILE_SOUND_KILL] = killSnd;
 		playingSounds[FILE_SOUND_GAMEOVER] = gameOverSnd;
 
+		// pack all images into one atlas, so that they are drawn by one call
+		for (auto path : { FILE_CANNON, FILE_COPTER_LEFT, FILE_COPTER_RIGHT, FILE_PARATROOPER,
+			FILE_PARATROOPER_PARACHUTE, FILE_PROJECTILE, FILE_TOWER, FILE_TURRET }) {
+			atlas.AddImage(path);
+		}
+
+		if (!atlas.LoadOrPack(FILE_ATLAS)) {
+			ofLogError("APP", "Sprite atlas couldn't be created");
+		}
+
+		// objects of the game are allocated in the arena of the scene
+		SceneAllocatorScope allocatorScope(scene->GetAllocator());
 		this->Reset();
 	}
 }
@@ -42,9 +54,8 @@ void ParatrooperApp::setup() {
 void ParatrooperApp::Reset() {
 	ofLogNotice("APP", "Game reset");
 
-	if(scene->GetRootObject() != nullptr) {
-		delete scene->GetRootObject();
-	}
+	// destroy the previous game and release its memory
+	scene->Clear();
 
 	if(model == nullptr) {
 		model = ParatrooperFactory::LoadGameModel();
@@ -69,6 +80,10 @@ void ParatrooperApp::Reset() {
 }
 
 void ParatrooperApp::PushNodeIntoRenderer(GameObject* node) {
+	if (renderer->CullSubtree(node->HasSubtreeBounds(), node->GetSubtreeBounds(), node->GetVisibleSubtreeSize())) {
+		return;
+	}
+
 	renderer->PushNode(node->GetRenderable());
 
 	for (auto child : node->GetChildren()) {
@@ -78,6 +93,7 @@ void ParatrooperApp::PushNodeIntoRenderer(GameObject* node) {
 
 //--------------------------------------------------------------
 void ParatrooperApp::update() {
+	SceneAllocatorScope allocatorScope(scene->GetAllocator());
 	frameCounter++;
 
 	delta = ofGetSystemTime() - absolute;
@@ -88,6 +104,8 @@ void ParatrooperApp::update() {
 	uint64 fixDelta = (delta < expectedDelta) ? expectedDelta : (delta < (2 * expectedDelta)) ? delta : (2 * expectedDelta);
 
 	scene->GetRootObject()->Update(fixDelta, absolute);
+	scene->UpdateComponentPools(fixDelta, absolute);
+	scene->DispatchMessages();
 	scene->GetRootObject()->UpdateTransformations();
 
 	if(resetGamePending) {
@@ -31,6 +31,8 @@ public:
 	Renderer* renderer;
 	ParatrooperModel* model = nullptr;
 	map<string, ofImage*> images;
+	// all images of the game, packed into one texture
+	SpriteAtlas atlas;
 	map<string, ofSoundPlayer*> playingSounds;
 
 	void PushNodeIntoRenderer(GameObject* node);
@@ -68,6 +70,10 @@ public:
 
 	virtual ofImage* GetImage(string path);
 
+	virtual SpriteAtlas* GetSpriteAtlas() {
+		return &atlas;
+	}
+
 	virtual void ResetGame() {
 		resetGamePending = true;
 	}
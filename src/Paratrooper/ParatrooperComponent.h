@@ -21,16 +21,15 @@ enum class ParaState {
 class ParatrooperComponent : public Component {
 private:
 	GameObject* ground;
-	ofImage* paratrooper;
-	ofImage* paratrooperParachute;
+	// atlas with images of the paratrooper
+	SpriteAtlas* atlas;
 	ParaState lastState;
 	ParatrooperModel* model;
 public:
 
 	virtual void Init() {
 		ground = owner->GetScene()->FindGameObjectByName(OBJECT_GROUND);
-		paratrooper = owner->GetContext()->GetImage(FILE_PARATROOPER);
-		paratrooperParachute = owner->GetContext()->GetImage(FILE_PARATROOPER_PARACHUTE);
+		atlas = owner->GetContext()->GetSpriteAtlas();
 		lastState = owner->GetAttr<ParaState>(PARA_STATE);
 		model = owner->GetRoot()->GetAttr<ParatrooperModel*>(MODEL);
 	}
@@ -147,17 +146,17 @@ private:
 			// change mesh according to the current state
 			// transformation needs to be recalculated, because the image of paratrooper with opened parachute has different size than the image of a falling paratrooper
 			if (lastState == ParaState::FALLING && state == ParaState::FALLING_PARACHUTE) {
-				owner->GetMesh<ImageMesh>()->SetImage(paratrooperParachute);
+				owner->GetMesh<ImageMesh>()->SetImage(atlas, FILE_PARATROOPER_PARACHUTE);
 				owner->GetTransform().CalcAbsTransform(owner->GetParent()->GetTransform());
 				transBld.AbsolutePosition(paraBB.bottomLeft.x + paraBB.GetSize().x / 2, paraBB.bottomLeft.y).Anchor(0.5f, 1).LocalScale(trans.scale.x, trans.scale.y).Build(owner);
 			}
 			else if (lastState == ParaState::FALLING_PARACHUTE && state == ParaState::FALLING_WIHTOUT_PARACHUTE) {
-				owner->GetMesh<ImageMesh>()->SetImage(paratrooper);
+				owner->GetMesh<ImageMesh>()->SetImage(atlas, FILE_PARATROOPER);
 				owner->GetTransform().CalcAbsTransform(owner->GetParent()->GetTransform());
 				transBld.AbsolutePosition(paraBB.bottomLeft.x + paraBB.GetSize().x / 2, paraBB.bottomLeft.y).Anchor(0.5f, 1).LocalScale(trans.scale.x, trans.scale.y).Build(owner);
 			}
 			else if (lastState == ParaState::FALLING_PARACHUTE && state == ParaState::ON_GROUND) {
-				owner->GetMesh<ImageMesh>()->SetImage(paratrooper);
+				owner->GetMesh<ImageMesh>()->SetImage(atlas, FILE_PARATROOPER);
 				owner->GetTransform().CalcAbsTransform(owner->GetParent()->GetTransform());
 				transBld.AbsolutePosition(paraBB.bottomLeft.x + paraBB.GetSize().x / 2, paraBB.bottomLeft.y).Anchor(0.5f, 1).LocalScale(trans.scale.x, trans.scale.y).Build(owner);
 			}
@@ -56,9 +56,10 @@ void ParatrooperFactory::InitializeGame(GameObject* rootObject, ParatrooperModel
 	auto context = rootObject->GetContext();
 
 	// create all visible objects
-	auto tower = new GameObject(OBJECT_TOWER, context, scene, new ImageMesh(context->GetImage(FILE_TOWER)));
-	auto turret = new GameObject(OBJECT_TURRET, context, scene, new ImageMesh(context->GetImage(FILE_TURRET)));
-	auto cannon = new GameObject(OBJECT_CANNON, context, scene, new ImageMesh(context->GetImage(FILE_CANNON)));
+	auto atlas = context->GetSpriteAtlas();
+	auto tower = new GameObject(OBJECT_TOWER, context, scene, new ImageMesh(atlas, FILE_TOWER));
+	auto turret = new GameObject(OBJECT_TURRET, context, scene, new ImageMesh(atlas, FILE_TURRET));
+	auto cannon = new GameObject(OBJECT_CANNON, context, scene, new ImageMesh(atlas, FILE_CANNON));
 	auto ground = new GameObject(OBJECT_GROUND, context, scene, new FRect(100, 0.3f, ofColor(0, 255, 255)));
 
 	// add game model
@@ -115,8 +116,8 @@ void ParatrooperFactory::InitializeGame(GameObject* rootObject, ParatrooperModel
 }
 
 void ParatrooperFactory::CreateProjectile(GameObject* canon, ParatrooperModel* model) {
-	auto projectileImg = canon->GetContext()->GetImage(FILE_PROJECTILE);
-	GameObject* projectile = new GameObject(canon->GetContext(), canon->GetScene(), new ImageMesh(projectileImg));
+	auto projectileImg = new ImageMesh(canon->GetContext()->GetSpriteAtlas(), FILE_PROJECTILE);
+	GameObject* projectile = new GameObject(canon->GetContext(), canon->GetScene(), projectileImg);
 	projectile->SetFlag(FLAG_PROJECTILE);
 
 	auto rootObject = canon->GetRoot();
@@ -149,7 +150,7 @@ void ParatrooperFactory::CreateProjectile(GameObject* canon, ParatrooperModel* m
 }
 
 void ParatrooperFactory::CreateParatrooper(GameObject* owner, ParatrooperModel* model) {
-	auto paratrooperMesh = new ImageMesh(owner->GetContext()->GetImage(FILE_PARATROOPER));
+	auto paratrooperMesh = new ImageMesh(owner->GetContext()->GetSpriteAtlas(), FILE_PARATROOPER);
 	GameObject* paratrooper = new GameObject(OBJECT_PARATROOPER, owner->GetContext(), owner->GetScene(), paratrooperMesh);
 	paratrooper->SetFlag(FLAG_COLLIDABLE);
 	paratrooper->SetTransform(owner->GetTransform());
@@ -166,8 +167,7 @@ void ParatrooperFactory::CreateParatrooper(GameObject* owner, ParatrooperModel*
 }
 
 void ParatrooperFactory::CreateCopter(GameObject* owner, ParatrooperModel* model) {
-	auto copterLeft = owner->GetContext()->GetImage(FILE_COPTER_LEFT);
-	auto copterImage = new ImageMesh(copterLeft);
+	auto copterImage = new ImageMesh(owner->GetContext()->GetSpriteAtlas(), FILE_COPTER_LEFT);
 	GameObject* copter = new GameObject(OBJECT_COPTER, owner->GetContext(), owner->GetScene(), copterImage);
 	copter->SetFlag(FLAG_COLLIDABLE);
 
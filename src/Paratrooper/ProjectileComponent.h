@@ -8,11 +8,17 @@
  * Component that controls movement of the projectile
  */
 class ProjectileComponent : public Component {
+private:
+	AttrHandle<Dynamics*> dynamicsAttr;
 public:
+	virtual void Init() {
+		dynamicsAttr = owner->GetAttrHandle<Dynamics*>(ATTR_DYNAMICS);
+	}
+
 	virtual void Update(uint64_t delta, uint64_t absolute) {
 
 		// update location
-		auto dynamics = owner->GetAttr<Dynamics*>(ATTR_DYNAMICS);
+		auto dynamics = dynamicsAttr.Get();
 		dynamics->UpdateVelocity(delta, owner->GetContext()->GetGameSpeed());
 		auto deltaPos = dynamics->CalcDelta(delta, owner->GetContext()->GetGameSpeed());
 